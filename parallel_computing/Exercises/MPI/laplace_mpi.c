@@ -29,28 +29,21 @@
 #include <math.h>
 #include <sys/time.h>
 #include <mpi.h>
+#include "../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
 
-#define COLUMNS      1000
-#define ROWS_GLOBAL  1000        // this is a "global" row count
 #define NPES            4        // number of processors
-#define ROWS (ROWS_GLOBAL/NPES)  // number of real local rows
 
 // communication tags
 #define DOWN     100
 #define UP       101   
 
-#define MAX_TEMP_ERROR 0.01
-
-double Temperature[ROWS+2][COLUMNS+2];
-double Temperature_last[ROWS+2][COLUMNS+2]; //padding for ghost cells
-
-void initialize(int npes, int my_PE_num);
-void track_progress(int iter);
+void initialize(int npes, int my_PE_num, int64_t my_rows, double (*Temperature_last)[COLUMNS+2]);
+void track_progress(int iter, int64_t my_rows, double (*Temperature)[COLUMNS+2]);
 
 
 int main(int argc, char *argv[]) {
 
-    int i, j;
+    int64_t i, j;
     int max_iterations;
     int iteration=1;
     double dt;
@@ -60,6 +53,7 @@ int main(int argc, char *argv[]) {
     int        my_PE_num;           // my PE number
     double     dt_global=100;       // delta t across all PEs
     MPI_Status status;              // status returned by MPI calls
+    int64_t    my_rows;             // number of real local rows
 
     // the usual MPI startup routines
     MPI_Init(&argc, &argv);
@@ -75,8 +69,23 @@ int main(int argc, char *argv[]) {
       exit(1);
     }
 
+    // every PE sees the same command line, so every PE gets the same sizes
+    max_iterations = laplace_parse_args(argc, argv);
+    if(ROWS % NPES != 0) {
+      if(my_PE_num==0) {
+        printf("Rows (%" PRId64 ") must divide evenly over %d PEs\n", (int64_t)ROWS, NPES);
+      }
+      MPI_Finalize();
+      exit(1);
+    }
+    my_rows = ROWS/NPES;
+
+    // the row type depends on COLUMNS, so declare the grids only after parsing
+    double (*Temperature)[COLUMNS+2]      = laplace_alloc_grid(my_rows, COLUMNS);
+    double (*Temperature_last)[COLUMNS+2] = laplace_alloc_grid(my_rows, COLUMNS); //padding for ghost cells
+
     // PE 0 asks for input
-    if(my_PE_num==0) {
+    if(my_PE_num==0 && max_iterations < 0) {
       printf("Maximum iterations [100-4000]?\n");
       fflush(stdout); // Not always necessary, but can be helpful
       scanf("%d", &max_iterations);
@@ -87,12 +96,12 @@ int main(int argc, char *argv[]) {
 
     if (my_PE_num==0) gettimeofday(&start_time,NULL);
 
-    initialize(npes, my_PE_num);
+    initialize(npes, my_PE_num, my_rows, Temperature_last);
 
     while ( dt_global > MAX_TEMP_ERROR && iteration <= max_iterations ) {
 
         // main calculation: average my four neighbors
-        for(i = 1; i <= ROWS; i++) {
+        for(i = 1; i <= my_rows; i++) {
             for(j = 1; j <= COLUMNS; j++) {
                 Temperature[i][j] = 0.25 * (Temperature_last[i+1][j] + Temperature_last[i-1][j] +
                                             Temperature_last[i][j+1] + Temperature_last[i][j-1]);
@@ -103,7 +112,7 @@ int main(int argc, char *argv[]) {
 
         // send bottom real row down
         if(my_PE_num != npes-1){             //unless we are bottom PE
-            MPI_Send(&Temperature[ROWS][1], COLUMNS, MPI_DOUBLE, my_PE_num+1, DOWN, MPI_COMM_WORLD);
+            MPI_Send(&Temperature[my_rows][1], COLUMNS, MPI_DOUBLE, my_PE_num+1, DOWN, MPI_COMM_WORLD);
         }
 
         // receive the bottom row from above into our top ghost row
@@ -118,12 +127,12 @@ int main(int argc, char *argv[]) {
 
         // receive the top row from below into our bottom ghost row
         if(my_PE_num != npes-1){             //unless we are bottom PE
-            MPI_Recv(&Temperature_last[ROWS+1][1], COLUMNS, MPI_DOUBLE, my_PE_num+1, UP, MPI_COMM_WORLD, &status);
+            MPI_Recv(&Temperature_last[my_rows+1][1], COLUMNS, MPI_DOUBLE, my_PE_num+1, UP, MPI_COMM_WORLD, &status);
         }
 
         dt = 0.0;
 
-        for(i = 1; i <= ROWS; i++){
+        for(i = 1; i <= my_rows; i++){
             for(j = 1; j <= COLUMNS; j++){
 	        dt = fmax( fabs(Temperature[i][j]-Temperature_last[i][j]), dt);
 	        Temperature_last[i][j] = Temperature[i][j];
@@ -137,7 +146,7 @@ int main(int argc, char *argv[]) {
         // periodically print test values - only for PE in lower corner
         if((iteration % 100) == 0) {
             if (my_PE_num == npes-1){
-                track_progress(iteration);
+                track_progress(iteration, my_rows, Temperature);
 	    }
         }
 
@@ -161,12 +170,12 @@ int main(int argc, char *argv[]) {
 
 
 
-void initialize(int npes, int my_PE_num){
+void initialize(int npes, int my_PE_num, int64_t my_rows, double (*Temperature_last)[COLUMNS+2]){
 
     double tMin, tMax;  //Local boundary limits
-    int i,j;
+    int64_t i,j;
 
-    for(i = 0; i <= ROWS+1; i++){
+    for(i = 0; i <= my_rows+1; i++){
         for (j = 0; j <= COLUMNS+1; j++){
             Temperature_last[i][j] = 0.0;
         }
@@ -177,9 +186,9 @@ void initialize(int npes, int my_PE_num){
     tMax = (my_PE_num+1)*100.0/npes;
 
     // Left and right boundaries
-    for (i = 0; i <= ROWS+1; i++) {
+    for (i = 0; i <= my_rows+1; i++) {
       Temperature_last[i][0] = 0.0;
-      Temperature_last[i][COLUMNS+1] = tMin + ((tMax-tMin)/ROWS)*i;
+      Temperature_last[i][COLUMNS+1] = tMin + ((tMax-tMin)/my_rows)*i;
     }
 
     // Top boundary (PE 0 only)
@@ -190,21 +199,21 @@ void initialize(int npes, int my_PE_num){
     // Bottom boundary (Last PE only)
     if (my_PE_num == npes-1)
       for (j=0; j<=COLUMNS+1; j++)
-	Temperature_last[ROWS+1][j] = (100.0/COLUMNS) * j;
+	Temperature_last[my_rows+1][j] = (100.0/COLUMNS) * j;
 
 }
 
 
 // only called by last PE
-void track_progress(int iteration) {
+void track_progress(int iteration, int64_t my_rows, double (*Temperature)[COLUMNS+2]) {
 
-    int i;
+    int64_t i;
 
     printf("---------- Iteration number: %d ------------\n", iteration);
 
     // output global coordinates so user doesn't have to understand decomposition
-    for(i = 5; i >= 0; i--) {
-      printf("[%d,%d]: %5.2f  ", ROWS_GLOBAL-i, COLUMNS-i, Temperature[ROWS-i][COLUMNS-i]);
+    for(i = laplace_progress_reach(my_rows, COLUMNS); i >= 0; i--) {
+      printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", ROWS-i, COLUMNS-i, Temperature[my_rows-i][COLUMNS-i]);
     }
     printf("\n");
 }
@@ -24,36 +24,34 @@
 #include <stdio.h>
 #include <math.h>
 #include <sys/time.h>
-
-// size of plate
-#define COLUMNS    1000
-#define ROWS       1000
-
-// largest permitted change in temp (This value takes about 3400 steps)
-#define MAX_TEMP_ERROR 0.01
-
-double Temperature[ROWS+2][COLUMNS+2];      // temperature grid
-double Temperature_last[ROWS+2][COLUMNS+2]; // temperature grid from last iteration
+#include "../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
 
 //   helper routines
-void initialize();
-void track_progress(int iter);
+void initialize(double (*Temperature_last)[COLUMNS+2]);
+void track_progress(int iter, double (*Temperature)[COLUMNS+2]);
 
 
 int main(int argc, char *argv[]) {
 
-    int i, j;                                            // grid indexes
+    int64_t i, j;                                        // grid indexes
     int max_iterations;                                  // number of iterations
     int iteration=1;                                     // current iteration
     double dt=100;                                       // largest change in t
     struct timeval start_time, stop_time, elapsed_time;  // timers
 
-    printf("Maximum iterations [100-4000]?\n");
-    scanf("%d", &max_iterations);
+    max_iterations = laplace_parse_args(argc, argv);
+    if (max_iterations < 0) {
+        printf("Maximum iterations [100-4000]?\n");
+        scanf("%d", &max_iterations);
+    }
+
+    // the row type depends on COLUMNS, so declare the grids only after parsing
+    double (*Temperature)[COLUMNS+2]      = laplace_alloc_grid(ROWS, COLUMNS); // temperature grid
+    double (*Temperature_last)[COLUMNS+2] = laplace_alloc_grid(ROWS, COLUMNS); // temperature grid from last iteration
 
     gettimeofday(&start_time,NULL); // Unix timer
 
-    initialize();                   // initialize Temp_last including boundary conditions
+    initialize(Temperature_last);   // initialize Temp_last including boundary conditions
 
     // do until error is minimal or until max steps
     while ( dt > MAX_TEMP_ERROR && iteration <= max_iterations ) {
@@ -78,7 +76,7 @@ int main(int argc, char *argv[]) {
 
         // periodically print test values
         if((iteration % 100) == 0) {
- 	    track_progress(iteration);
+ 	    track_progress(iteration, Temperature);
         }
 
 	iteration++;
@@ -95,9 +93,9 @@ int main(int argc, char *argv[]) {
 
 // initialize plate and boundary conditions
 // Temp_last is used to to start first iteration
-void initialize(){
+void initialize(double (*Temperature_last)[COLUMNS+2]){
 
-    int i,j;
+    int64_t i,j;
 
     for(i = 0; i <= ROWS+1; i++){
         for (j = 0; j <= COLUMNS+1; j++){
@@ -122,13 +120,13 @@ void initialize(){
 
 
 // print diagonal in bottom right corner where most action is
-void track_progress(int iteration) {
+void track_progress(int iteration, double (*Temperature)[COLUMNS+2]) {
 
-    int i;
+    int64_t i;
 
     printf("---------- Iteration number: %d ------------\n", iteration);
-    for(i = ROWS-5; i <= ROWS; i++) {
-        printf("[%d,%d]: %5.2f  ", i, i, Temperature[i][i]);
+    for(i = laplace_progress_reach(ROWS, COLUMNS); i >= 0; i--) {
+        printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", ROWS-i, COLUMNS-i, Temperature[ROWS-i][COLUMNS-i]);
     }
     printf("\n");
 }
@@ -0,0 +1,62 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: in-situ analysis against dumping the field
+# Objective:
+#   1. run laplace_omp.c for a fixed iteration count three ways: no
+#      output, --analysis every N sweeps (statistics, thumbnail and
+#      isotherms on the live grid), and --snapshot every N sweeps (the
+#      full field, what offline postprocessing has to read back)
+#   2. report solve time, seconds per analysis and the bytes each
+#      way leaves on disk
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_analysis_result.txt"
+threads=${OMP_NUM_THREADS:-8}
+bench_itr=${BENCH_ITR:-1000}
+every=${ANALYSIS_EVERY:-100}
+out_dir=${ANALYSIS_DIR:-"analysis_out"}
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp -pthread"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../HW/hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "Compiler: ${CC} ${CFLAGS}" \
+    "Threads: ${threads}"
+
+${CC} ${CFLAGS} laplace_omp.c -o laplace_omp.out -lm || exit 1
+
+# Arrays of plate sizes to test
+sizes=(1000 4000 8000)
+
+# solve time and seconds per analysis, then the MB left in out_dir
+run() {
+    rm -rf ${out_dir}
+    mkdir -p ${out_dir}
+    OMP_NUM_THREADS=${threads} ./laplace_omp.out --size=$1 --max-temp-error=0 --max-iterations=${bench_itr} $2 |
+        awk '/Total time/ {t=$4} /^Analysis:/ {a=$6} END {printf "%10s %10s", t, a ? a : "-"}'
+    printf " %10.2f" $(du -sb ${out_dir} | awk '{print $1 / 1e6}')
+}
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN, OUTPUT EVERY ${every}!!!!" >> ${output_file}
+printf "%-9s %6s %10s %10s %10s\n" "output" "size" "time(s)" "s/analysis" "disk_MB" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    echo "Running ${size}x${size}..."
+    printf "%-9s %6d %s\n" "none" ${size} "$(run ${size})" >> ${output_file}
+    printf "%-9s %6d %s\n" "analysis" ${size} \
+        "$(run ${size} "--analysis=${out_dir}/plate --analysis-every=${every}")" >> ${output_file}
+    printf "%-9s %6d %s\n" "snapshot" ${size} \
+        "$(run ${size} "--snapshot=${out_dir}/plate.snap --snapshot-every=${every}")" >> ${output_file}
+    echo "----------------------------------------" >> ${output_file}
+done
+rm -rf ${out_dir}
+echo "Analysis benchmark complete. Results saved in ${output_file}"
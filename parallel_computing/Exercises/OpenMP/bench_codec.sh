@@ -0,0 +1,65 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: lossless grid codec on real solver output
+# Objective:
+#   1. solve plates with laplace_omp.c to a few iteration counts and
+#      run --codec-report on the result: compression ratio, encode and
+#      decode GB/s (raw cells), and a bit-for-bit check
+#   2. write snapshots raw and through the codec (--snapshot-codec=xor)
+#      and compare file size, writer GB/s and solver time
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_codec_result.txt"
+threads=${OMP_NUM_THREADS:-8}
+snapshot_file=${SNAPSHOT_FILE:-"laplace_snapshot.bin"}
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp -pthread"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../HW/hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "Compiler: ${CC} ${CFLAGS}" \
+    "Threads: ${threads}"
+
+${CC} ${CFLAGS} laplace_omp.c -o laplace_omp.out -lm || exit 1
+
+# Arrays of plate sizes and iteration counts to test (early, mid, converged)
+sizes=(1000 2000 4000)
+iterations=(100 1000 100000)
+
+echo "=== Codec on the final plate ===" >> ${output_file}
+printf "%6s %8s %8s %8s %8s %8s %10s\n" "size" "itr" "MB" "ratio" "enc_GB/s" "dec_GB/s" "check" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for itr in "${iterations[@]}"
+    do
+        echo "Coding ${size}x${size} after ${itr} iterations..."
+        OMP_NUM_THREADS=${threads} ./laplace_omp.out --size=${size} --max-iterations=${itr} --codec-report |
+            awk -v s=${size} -v i=${itr} '/^Codec:/ {gsub(",", ""); printf "%6d %8d %8s %8s %8s %8s %10s\n", s, i, $2, $8, $10, $13, $15}' >> ${output_file}
+    done
+done
+
+echo "=== Snapshots every 100 iterations, 1000 iterations ===" >> ${output_file}
+printf "%6s %6s %10s %10s %10s\n" "size" "codec" "time(s)" "file_MB" "GB/s" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for codec in raw xor
+    do
+        echo "Snapshots ${size}x${size}, ${codec}..."
+        OMP_NUM_THREADS=${threads} ./laplace_omp.out --size=${size} --max-temp-error=0 --max-iterations=1000 \
+            --snapshot=${snapshot_file} --snapshot-codec=${codec} |
+            awk -v s=${size} -v c=${codec} '/Total time/ {t=$4} /^Snapshots:/ {m=$10; g=$13}
+                 END {printf "%6d %6s %10s %10s %10s\n", s, c, t, m, g}' >> ${output_file}
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+rm -f ${snapshot_file}
+echo "Codec benchmark complete. Results saved in ${output_file}"
@@ -0,0 +1,69 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: double vs mixed precision Jacobi
+# Objective:
+#   1. solve each plate in double and then in mixed precision
+#      (--precision=compare) with laplace_serial.c and laplace_omp.c
+#   2. report iterations, time, speedup and max |mixed - double|
+#   3. run hw3_laplace_mpi_3.c with --precision=double and =mixed
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_mixed_result.txt"
+max_itr=${MAX_ITR:-100000}
+threads=${OMP_NUM_THREADS:-8}
+pe=${PE:-4}
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp"}
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native -fopenmp-simd -DLAPLACE_OMP_SIMD"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../HW/hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "Compiler: ${CC} ${CFLAGS}, ${MPICC} ${MPIFLAGS}" \
+    "Threads: ${threads}, PEs: ${pe}"
+
+${CC} ${CFLAGS} laplace_serial.c -o laplace_serial.out -lm || exit 1
+${CC} ${CFLAGS} laplace_omp.c -o laplace_omp.out -lm || exit 1
+${MPICC} ${MPIFLAGS} ../../HW/hw3/hw3_laplace_mpi_3.c -o laplace_mpi.out -lm || exit 1
+
+# Array of plate sizes to test
+sizes=(500 1000 2000)
+
+# double and mixed iterations/time, speedup and difference from --precision=compare
+compare() {
+    "$@" --max-iterations=${max_itr} --precision=compare |
+        awk '/^Max error/ {itr=$5} /^Total time/ {t=$4}
+             /^Mixed precision: max error/ {mitr=$7} /^Mixed precision: total/ {mt=$6; x=$8}
+             /mixed - double/ {d=$NF}
+             END {printf "%8s %10s %8s %10s %8s %12s", itr, t, mitr, mt, x, d}'
+}
+
+# iterations and time from an MPI run
+mpi_run() {
+    mpirun -n ${pe} ./laplace_mpi.out --size=$1 --max-iterations=${max_itr} --precision=$2 |
+        awk '/Max error/ {itr=$5} /Total time/ {t=$4} END {printf "%8s %10s", itr, t}'
+}
+
+export OMP_NUM_THREADS=${threads}
+printf "%-10s %6s %8s %10s %8s %10s %8s %12s\n" "solver" "size" "d_iters" "d_time(s)" "m_iters" "m_time(s)" "speedup" "max|m-d|" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    echo "Running ${size}x${size}..."
+    printf "%-10s %6d %s\n" "serial" ${size} "$(compare ./laplace_serial.out --size=${size})" >> ${output_file}
+    printf "%-10s %6d %s\n" "omp" ${size} "$(compare ./laplace_omp.out --size=${size})" >> ${output_file}
+    d=$(mpi_run ${size} double)
+    m=$(mpi_run ${size} mixed)
+    x=$(echo "${d} ${m}" | awk '{printf "(%.2fx)", $2/$4}')
+    printf "%-10s %6d %s %s %8s %12s\n" "mpi(${pe})" ${size} "${d}" "${m}" "${x}" "-" >> ${output_file}
+    echo "----------------------------------------" >> ${output_file}
+done
+echo "Mixed precision benchmark complete. Results saved in ${output_file}"
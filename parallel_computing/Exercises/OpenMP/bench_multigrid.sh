@@ -0,0 +1,60 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: Jacobi vs red-black vs geometric multigrid
+# Objective:
+#   1. solve the same plate to MAX_TEMP_ERROR with the Jacobi sweep
+#      (laplace_serial.c, laplace_omp.c), the red-black checkerboard
+#      (HW/hw1/ex1/laplace_omp_parallel.c) and the multigrid engine
+#      with V- and F-cycles
+#   2. report iterations (multigrid: cycles), final residual and time
+#      for growing plate sizes; Jacobi iterations grow with size^2,
+#      multigrid cycles should not grow at all
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_multigrid_result.txt"
+max_itr=${MAX_ITR:-100000}
+threads=${OMP_NUM_THREADS:-8}
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../HW/hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "Compiler: ${CC} ${CFLAGS}" \
+    "Threads: ${threads}"
+
+${CC} ${CFLAGS} laplace_serial.c -o laplace_serial.out -lm || exit 1
+${CC} ${CFLAGS} laplace_omp.c -o laplace_omp.out -lm || exit 1
+${CC} ${CFLAGS} ../../HW/hw1/ex1/laplace_omp_parallel.c -o laplace_redblack.out -lm || exit 1
+
+# Array of plate sizes to test
+sizes=(250 500 1000 2000)
+
+# iterations, residual (multigrid only) and time from the solver's own output
+run() {
+    "$@" --max-iterations=${max_itr} |
+        awk '/^residual/ {res=$3} /Max error/ {itr=$5; err=$7} /Total time/ {t=$4}
+             END {if (res == "") res="-"; printf "%8s %10s %14s %10s", itr, err, res, t}'
+}
+
+export OMP_NUM_THREADS=${threads}
+printf "%-16s %6s %8s %10s %14s %10s\n" "engine" "size" "iters" "max_err" "residual" "time(s)" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    echo "Running ${size}x${size}..."
+    printf "%-16s %6d %s\n" "jacobi(serial)" ${size} "$(run ./laplace_serial.out --size=${size})" >> ${output_file}
+    printf "%-16s %6d %s\n" "jacobi(omp)" ${size} "$(run ./laplace_omp.out --size=${size})" >> ${output_file}
+    printf "%-16s %6d %s\n" "redblack(omp)" ${size} "$(run ./laplace_redblack.out --size=${size})" >> ${output_file}
+    printf "%-16s %6d %s\n" "multigrid(V)" ${size} "$(run ./laplace_omp.out --size=${size} --engine=multigrid --cycle=V)" >> ${output_file}
+    printf "%-16s %6d %s\n" "multigrid(F)" ${size} "$(run ./laplace_omp.out --size=${size} --engine=multigrid --cycle=F)" >> ${output_file}
+    echo "----------------------------------------" >> ${output_file}
+done
+echo "Multigrid benchmark complete. Results saved in ${output_file}"
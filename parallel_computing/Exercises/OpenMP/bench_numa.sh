@@ -0,0 +1,81 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: NUMA first-touch, huge pages and thread pinning
+# Objective:
+#   1. run laplace_omp.c with the serial placement of before, with
+#      --placement=first-touch, --huge-pages=thp|explicit and
+#      --pin=close|spread, alone and combined
+#   2. report the sweep time per iteration (compute + reduction from
+#      --bench) and the bandwidth it implies at 40 bytes per cell
+#      (stencil 16, dt+copy 24, as in --perf), with the speedup over
+#      the serial placement
+#   3. keep each run's affinity map and page placement lines in a log
+#      to check the threads and pages went where they were told
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_numa_result.txt"
+log_file="bench_numa_placement.txt"
+bench_itr=${BENCH_ITR:-200}
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp -pthread"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../HW/hw3/bench_common.sh"
+
+# Clear previous results
+> ${log_file}
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "NUMA nodes: $(ls -d /sys/devices/system/node/node* 2>/dev/null | wc -l)" \
+    "THP: $(cat /sys/kernel/mm/transparent_hugepage/enabled 2>/dev/null || echo n/a), reserved huge pages: $(cat /proc/sys/vm/nr_hugepages 2>/dev/null || echo n/a)" \
+    "Compiler: ${CC} ${CFLAGS}"
+
+${CC} ${CFLAGS} laplace_omp.c -o laplace_omp.out -lm || exit 1
+
+# Arrays of plate sizes, thread counts and placement options to test
+sizes=(2000 8000)
+thread_counts=(1 16 $(nproc))
+options=("serial"
+         "--placement=first-touch"
+         "--huge-pages=thp"
+         "--huge-pages=explicit"
+         "--pin=close"
+         "--pin=spread"
+         "--placement=first-touch --pin=spread"
+         "--placement=first-touch --pin=spread --huge-pages=thp")
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN!!!!" >> ${output_file}
+printf "%-56s %6s %8s %12s %10s %8s\n" "options" "size" "threads" "ms/iteration" "GB/s" "speedup" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for threads in "${thread_counts[@]}"
+    do
+        echo "Running ${size}x${size} with ${threads} threads..."
+        base=""
+        for option in "${options[@]}"
+        do
+            flags="${option}"
+            [ "${flags}" = "serial" ] && flags=""
+            echo "=== ${size}x${size}, ${threads} threads, ${option} ===" >> ${log_file}
+            # sweep seconds: compute + reduction of the Bench line
+            t=$(OMP_NUM_THREADS=${threads} ./laplace_omp.out --size=${size} --max-temp-error=0 \
+                    --max-iterations=${bench_itr} --bench ${flags} 2>&1 |
+                tee >(grep -E "^Affinity|^  |^Placement|huge pages" >> ${log_file}) |
+                awk '/^Bench:/ {print $5 + $9}')
+            [ -z "${base}" ] && base=${t}
+            echo "${option}|${size}|${threads}|${t}|${base}" |
+                awk -F'|' -v itr=${bench_itr} '{
+                    printf "%-56s %6d %8d %12.3f %10.2f %8.2f\n", $1, $2, $3,
+                           $4 * 1e3 / itr, 40.0 * $2 * $2 * itr / $4 / 1e9, $5 / $4 }' >> ${output_file}
+        done
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+echo "NUMA benchmark complete. Results saved in ${output_file}, placement in ${log_file}"
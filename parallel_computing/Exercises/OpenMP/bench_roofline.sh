@@ -0,0 +1,67 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: hardware counters and roofline of the sweep kernels
+# Objective:
+#   1. run laplace_omp.c (Jacobi stencil and dt+copy) and
+#      HW/hw1/ex1/laplace_omp_parallel.c (red-black, interleaved and
+#      split layouts) with --perf at plate sizes inside and beyond
+#      the last-level cache
+#   2. keep the STREAM and multiply-add roofs once, and per kernel the
+#      time, GB/s, GFLOP/s, arithmetic intensity, roof%, IPC and
+#      misses per cell ("-" where the counters cannot be opened)
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_roofline_result.txt"
+threads=${OMP_NUM_THREADS:-8}
+bench_itr=${BENCH_ITR:-200}
+stream_mb=${STREAM_MB:-0}          # 0 sizes the STREAM arrays from the LLC
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp -pthread"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../HW/hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "Caches: $(lscpu | grep -E '^L(1d|2|3)' | awk '{printf "%s %s %s  ", $1, $3, $4}')" \
+    "perf_event_paranoid: $(cat /proc/sys/kernel/perf_event_paranoid 2>/dev/null || echo n/a)" \
+    "Compiler: ${CC} ${CFLAGS}" \
+    "Threads: ${threads}"
+
+${CC} ${CFLAGS} laplace_omp.c -o laplace_omp.out -lm || exit 1
+${CC} ${CFLAGS} ../../HW/hw1/ex1/laplace_omp_parallel.c -o laplace_p.out -lm || exit 1
+
+# Arrays of plate sizes to test
+sizes=(1000 4000 10000)
+
+stream_arg=""
+if [ "${stream_mb}" != "0" ]; then stream_arg="--stream-mb=${stream_mb}"; fi
+
+# the counters, roofline and column lines once, then each kernel row tagged with its size
+run() {
+    OMP_NUM_THREADS=${threads} ./$1 --size=$2 --max-temp-error=0 --max-iterations=${bench_itr} \
+        --perf ${stream_arg} $3 |
+        awk -v size=$2 -v header=$4 '
+            /^Counters:|^Roofline:/ { if (header) print }
+            /^kernel / { table = 1; if (header) printf "%6s %s\n", "size", $0; next }
+            table && NF == 10 { printf "%6d %s\n", size, $0 }'
+}
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN!!!!" >> ${output_file}
+first=1
+for size in "${sizes[@]}"
+do
+    echo "Running ${size}x${size}..."
+    run laplace_omp.out ${size} "" ${first} >> ${output_file}
+    first=0
+    run laplace_p.out ${size} "" 0 >> ${output_file}
+    run laplace_p.out ${size} "--layout=split" 0 >> ${output_file}
+    echo "----------------------------------------" >> ${output_file}
+done
+echo "Roofline benchmark complete. Results saved in ${output_file}"
@@ -0,0 +1,67 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: solver throughput with asynchronous snapshots
+# Objective:
+#   1. run laplace_omp.c for a fixed iteration count without snapshots
+#      and with --snapshot every 100, 10 and 1 iterations
+#   2. report iterations per second, the slowdown against no
+#      snapshots, snapshots written and dropped, and the writer's GB/s
+#   3. the buffers stay at two grids however often snapshots are asked
+#      for; a busy writer drops snapshots instead of stalling the sweep
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_snapshot_result.txt"
+bench_itr=${BENCH_ITR:-2000}
+threads=${OMP_NUM_THREADS:-8}
+snapshot_file=${SNAPSHOT_FILE:-"laplace_snapshot.bin"}
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp -pthread"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../HW/hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "Compiler: ${CC} ${CFLAGS}" \
+    "Threads: ${threads}, snapshot file: ${snapshot_file}"
+
+${CC} ${CFLAGS} laplace_omp.c -o laplace_omp.out -lm || exit 1
+
+# Arrays of plate sizes and snapshot intervals to test (0 = off)
+sizes=(1000 2000 4000)
+intervals=(0 100 10 1)
+
+# total seconds, snapshots written and dropped, writer GB/s
+run() {
+    local snap=""
+    [ $2 -gt 0 ] && snap="--snapshot=${snapshot_file} --snapshot-every=$2"
+    OMP_NUM_THREADS=${threads} ./laplace_omp.out --size=$1 --max-temp-error=0 \
+        --max-iterations=${bench_itr} ${snap} |
+        awk '/Total time/ {t=$4} /^Snapshots:/ {s=1; w=$2; d=$6; g=$13}
+             END {if (s) printf "%10s %8s %8s %8s", t, w, d, g; else printf "%10s %8s %8s %8s", t, "-", "-", "-"}'
+}
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN!!!!" >> ${output_file}
+printf "%6s %8s %10s %10s %8s %8s %8s %8s\n" "size" "every" "time(s)" "itr/s" "written" "dropped" "GB/s" "slowdown" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    echo "Running ${size}x${size}..."
+    base=""
+    for every in "${intervals[@]}"
+    do
+        result=$(run ${size} ${every})
+        [ -z "${base}" ] && base=$(echo "${result}" | awk '{print $1}')
+        stats=$(echo "${base} ${bench_itr} ${result}" | awk '{printf "%10.0f %8s %8s %8s %8.2f", $2/$3, $4, $5, $6, $3/$1}')
+        label=${every}; [ ${every} -eq 0 ] && label="off"
+        printf "%6d %8s %10s %s\n" ${size} ${label} "$(echo ${result} | awk '{print $1}')" "${stats}" >> ${output_file}
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+rm -f ${snapshot_file}
+echo "Snapshot benchmark complete. Results saved in ${output_file}"
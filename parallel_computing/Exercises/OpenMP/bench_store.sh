@@ -0,0 +1,58 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: tiled solution store, mmap queries against a full load
+# Objective:
+#   1. solve a large plate with laplace_omp.c and write it once with
+#      --store (64 x 64 tiles, page aligned, min/max index)
+#   2. query the store from a cold page cache with laplace_query.c:
+#      random cells, a corner window, one row and a value-range count
+#      (the min/max index skips tiles), through mmap (only the touched
+#      tiles are read) and after reading the whole file
+#   3. report per-query latency and page faults for both modes
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_store_result.txt"
+threads=${OMP_NUM_THREADS:-8}
+store_file=${STORE_FILE:-"laplace_store.tiles"}
+max_itr=${MAX_ITR:-10}
+queries=${QUERIES:-1000}
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp -pthread"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../HW/hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "Compiler: ${CC} ${CFLAGS}" \
+    "Threads: ${threads}" \
+    "Store file: ${store_file}"
+
+${CC} ${CFLAGS} laplace_omp.c -o laplace_omp.out -lm || exit 1
+${CC} ${CFLAGS} laplace_query.c -o laplace_query.out || exit 1
+
+# Arrays of plate sizes and query windows to test
+sizes=(4000 10000)
+windows=(64 512)
+
+for size in "${sizes[@]}"
+do
+    echo "Storing ${size}x${size}..."
+    OMP_NUM_THREADS=${threads} ./laplace_omp.out --size=${size} --max-temp-error=0 --max-iterations=${max_itr} \
+        --store=${store_file} | grep '^Store:' >> ${output_file}
+    for window in "${windows[@]}"
+    do
+        echo "Querying ${size}x${size}, window ${window}..."
+        echo "=== ${size}x${size}, ${queries} random cells, ${window}x${window} window ===" >> ${output_file}
+        ./laplace_query.out ${store_file} --queries=${queries} --window=${window} | grep -v '^\[' >> ${output_file}
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+rm -f ${store_file}
+echo "Store benchmark complete. Results saved in ${output_file}"
@@ -0,0 +1,63 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: two-loop sweep vs temporal (wavefront) blocking
+# Objective:
+#   1. run laplace_omp.c with the default two-loop sweep and with the
+#      wavefront engine at several time-block depths
+#   2. compare wall clock at 1, 8 and 32 threads; both engines must stop
+#      on the same iteration with the same max error
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_wavefront_result.txt"
+max_itr=4000
+size=${SIZE:-1000}
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../HW/hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "Compiler: ${CC} ${CFLAGS}" \
+    "Plate: ${size}x${size}"
+
+${CC} ${CFLAGS} laplace_omp.c -o laplace_omp.out -lm || exit 1
+
+# Array of thread counts to test
+thread_counts=(1 8 32)
+time_blocks=(4 8 16)
+
+run() {
+    ./laplace_omp.out --size=${size} --max-iterations=${max_itr} "$@" |
+        awk '/Max error/ {itr=$5; err=$7} /Total time/ {t=$4} END {printf "%6s %10s %10s", itr, err, t}'
+}
+
+printf "%-16s %8s %6s %10s %10s %8s\n" "engine" "threads" "iters" "max_err" "time(s)" "speedup" >> ${output_file}
+for threads in "${thread_counts[@]}"
+do
+    echo "Running with ${threads} threads..."
+    export OMP_NUM_THREADS=${threads}
+
+    sweep=$(run --engine=sweep)
+    sweep_time=$(echo ${sweep} | awk '{print $3}')
+    printf "%-16s %8d %s %8s\n" "sweep" ${threads} "${sweep}" "1.00" >> ${output_file}
+
+    for tb in "${time_blocks[@]}"
+    do
+        result=$(run --engine=wavefront --time-block=${tb})
+        speedup=$(echo "${sweep_time} $(echo ${result} | awk '{print $3}')" | awk '{printf "%.2f", $1/$2}')
+        printf "%-16s %8d %s %8s\n" "wavefront(T=${tb})" ${threads} "${result}" ${speedup} >> ${output_file}
+    done
+    echo "----------------------------------------" >> ${output_file}
+
+    # Add a small delay between runs
+    sleep 1
+done
+echo "Wavefront benchmark complete. Results saved in ${output_file}"
@@ -20,69 +20,383 @@
  *
  ************************************************/
 
+/*************************************************
+ * Temporal (wavefront) blocking engine
+ *
+ *   ./laplace_omp.out --engine=wavefront [--time-block=T] [--tile-columns=W]
+ *
+ * The default sweep streams both grids through memory twice per
+ * iteration. The wavefront engine instead advances T time levels while
+ * a band of rows is still in cache: the plate is cut into column tiles,
+ * and each tile is swept top to bottom with level t+1 trailing level t
+ * by one row, so only ~2(T+3) rows of a tile are live at once. Levels
+ * alternate between the two grids, and tiles are skewed one column per
+ * level so a tile only ever depends on the tile to its left. Threads
+ * own tiles round-robin and wait on their left neighbour's wavefront
+ * row, so all threads sweep down the plate together, staggered by one
+ * tile.
+ *
+ * Every level records its own dt, so the engine stops on exactly the
+ * iteration the sweep would, with bit-identical temperatures. A block
+ * that crosses MAX_TEMP_ERROR part way is rolled back from a snapshot
+ * and rerun short. Snapshots are only taken when the measured decay
+ * rate says convergence is near.
+ *
+ * Also available, shared with laplace_serial.c:
+ *
+ *   --engine=multigrid [--cycle=V|F]   geometric multigrid,
+ *                                      common/laplace_multigrid.h
+ *   --simd=NAME [--simd-report]        sweep kernel set (auto, avx512,
+ *                                      avx2, sse2, scalar),
+ *                                      common/laplace_simd.h
+ *   --precision=mixed                  float correction sweeps with a
+ *                                      double residual every 100
+ *                                      iterations, common/laplace_mixed.h
+ *   --precision=compare                rerun in mixed after the double
+ *                                      solve; print speedup and
+ *                                      max |mixed - double|
+ *   --check-every=N|auto               measure dt every Nth sweep, or
+ *                                      at a spacing set by its decay,
+ *                                      common/laplace_check.h
+ *   --snapshot=FILE [--snapshot-every=N]
+ *                                      append the plate to FILE every
+ *                                      N sweeps (default 100) and at
+ *                                      the end, from a writer thread,
+ *                                      common/laplace_snapshot.h
+ *   --snapshot-codec=xor               store snapshots through the
+ *                                      lossless codec,
+ *                                      common/laplace_codec.h
+ *   --codec-report                     time the codec on the final
+ *                                      plate
+ *   --store=FILE                       save the final plate as a
+ *                                      tiled store for laplace_query.c,
+ *                                      common/laplace_store.h
+ *   --pitch=packed|aligned|padded|N    doubles from one row to the
+ *                                      next, padded by default; see
+ *                                      laplace_grid_pitch() in
+ *                                      common/laplace_args.h. Multigrid
+ *                                      and mixed precision work on
+ *                                      packed rows and ignore it
+ *
+ * OpenMP only (and in hw3_laplace_mpi_3.c):
+ *
+ *   --analysis=PREFIX [--analysis-every=N] [--decimate=F]
+ *         [--isotherms=L1,L2,...]      in-situ statistics, a thumbnail
+ *                                      decimated F times and isotherm
+ *                                      segments every N sweeps and of
+ *                                      the final plate, never the
+ *                                      field, common/laplace_analysis.h
+ *   --bench                            print in-process phase times
+ *                                      for HW/hw3/bench_harness.sh,
+ *                                      common/bench_phases.h
+ *   --perf [--stream-mb=N]             hardware counters around the
+ *                                      stencil and dt+copy sweeps and
+ *                                      a roofline against a STREAM
+ *                                      probe, common/laplace_perf.h
+ *   --trace=FILE [--trace-events=N]    per-thread timeline of the
+ *                                      sweep, dt+copy and output
+ *                                      phases as Chrome trace JSON,
+ *                                      common/laplace_trace.h
+ *   --placement=first-touch            touch each grid row first from
+ *                                      the thread that sweeps it
+ *   --huge-pages=thp|explicit          back the grids with 2 MB pages
+ *   --pin=close|spread                 bind threads to CPUs; any of
+ *                                      the three prints the affinity
+ *                                      map and where the pages went,
+ *                                      common/laplace_numa.h
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#define _GNU_SOURCE   // sched_getcpu and CPU_SET in common/laplace_numa.h
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <sched.h>
 #include <sys/time.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
+#include "../../common/laplace_multigrid.h"
+#include "../../common/laplace_simd.h"
+#include "../../common/laplace_mixed.h"
+#include "../../common/laplace_check.h"
+#include "../../common/laplace_snapshot.h"
+#include "../../common/laplace_store.h"
+#include "../../common/laplace_analysis.h"
+#include "../../common/bench_phases.h"
+#include "../../common/laplace_perf.h"
+#include "../../common/laplace_trace.h"
+#include "../../common/laplace_numa.h"
 
-// size of plate
-#define COLUMNS    1000
-#define ROWS       1000
-
-// largest permitted change in temp (This value takes about 3400 steps)
-#define MAX_TEMP_ERROR 0.01
-
-double Temperature[ROWS+2][COLUMNS+2];      // temperature grid
-double Temperature_last[ROWS+2][COLUMNS+2]; // temperature grid from last iteration
+// wavefront engine limits
+#define MAX_TIME_BLOCK 64      // most time levels per cache-resident pass
+#define MIN_TILE_COLUMNS 16    // narrower tiles spend more time waiting than computing
 
 //   helper routines
-void initialize();
-void track_progress(int iter);
+void initialize(int64_t pitch, double (*Temperature_last)[pitch]);
+void track_progress(int iter, int64_t pitch, double (*Temperature)[pitch]);
+int wavefront_solve(int64_t pitch, double (*Temperature)[pitch], double (*Temperature_last)[pitch],
+                    int max_iterations, int time_block, int64_t tile_columns, double *dt);
+int multigrid_solve(double (*Temperature_last)[COLUMNS+2], int max_iterations, int fcycle, double *dt);
+int mixed_solve(double (*Temperature_last)[COLUMNS+2], int max_iterations, int verbose, double *dt);
+void compare_mixed(int64_t pitch, double (*Temperature_last)[pitch], int max_iterations, double double_seconds);
 
 
 int main(int argc, char *argv[]) {
 
-    int i, j;                                            // grid indexes
+    int64_t i;                                           // grid row index
     int max_iterations;                                  // number of iterations
     int iteration=1;                                     // current iteration
     double dt=100;                                       // largest change in t
     struct timeval start_time, stop_time, elapsed_time;  // timers
 
-    printf("Maximum iterations [100-4000]?\n");
-    scanf("%d", &max_iterations);
+    int wavefront = 0;                                   // use the temporal blocking engine
+    int time_block = 8;                                  // time levels per wavefront pass
+    int64_t tile_columns = 0;                            // wavefront tile width, 0 = size to L2
+    int multigrid = 0;                                   // use the multigrid engine
+    int fcycle = 0;                                      // multigrid F-cycles instead of V-cycles
+    const char *simd_name = NULL;                        // sweep kernel set, NULL = widest supported
+    int simd_report = 0;                                 // time the kernel sets first
+    const laplace_simd_kernels *simd;                    // sweep kernels
+    int mixed = 0;                                       // float sweeps with double refinement
+    int compare = 0;                                     // rerun mixed and compare with double
+    const char *check_spec = NULL;                       // --check-every, NULL = every iteration
+    laplace_check check;                                 // when to measure dt
+    char check_name[32];
+    const char *snapshot_path = NULL;                    // --snapshot file, NULL = none
+    int snapshot_every = 100;                            // iterations between snapshots
+    laplace_snapshot snapshots;                          // buffers and writer thread
+    int snapshot_encoding = LAPLACE_SNAPSHOT_RAW;        // --snapshot-codec
+    int codec_report = 0;                                // time the codec on the final plate
+    const char *store_path = NULL;                       // --store file for the final plate
+    const char *analysis_prefix = NULL;                  // --analysis output prefix, NULL = none
+    int analysis_every = 0;                              // iterations between analyses, 0 = final only
+    int64_t decimate = 0;                                // thumbnail factor, 0 = fit 256 pixels
+    const char *isotherms = NULL;                        // isotherm levels, NULL = 10, 20, ..., 90
+    laplace_analysis analysis;
+    int bench_line = 0;                                  // --bench: print the phase times
+    bench_phases bench;                                  // init, compute, reduction, output
+    int perf_report = 0;                                 // --perf: counters and roofline
+    double stream_mb = 0;                                // STREAM array size, 0 = from the LLC
+    laplace_perf perf;
+    int perf_stencil = 0, perf_copy = 0;                 // its kernel phases
+    const char *trace_path = NULL;                       // --trace file, NULL = no tracing
+    int64_t trace_events = 0;                            // events per thread, 0 = default
+    laplace_trace trace;
+    const char *placement = NULL;                        // --placement, NULL = serial
+    const char *huge_pages = NULL;                       // --huge-pages, NULL = off
+    const char *pin = NULL;                              // --pin, NULL = off
+    laplace_numa numa;
+    int64_t pitch;                                       // doubles from one row to the next
+    int threads = 1;
+    const char *v;
+    int arg;
+
+    max_iterations = laplace_parse_args(argc, argv);
+    pitch = laplace_grid_pitch(COLUMNS, LAPLACE_PITCH_PADDED);
+    for (arg = 1; arg < argc; arg++) {
+        if ((v = laplace_arg_value(argv[arg], "--pitch"))) {
+            pitch = laplace_parse_pitch(v, COLUMNS);
+        } else if ((v = laplace_arg_value(argv[arg], "--engine"))) {
+            if (strcmp(v, "wavefront") == 0) wavefront = 1;
+            else if (strcmp(v, "multigrid") == 0) multigrid = 1;
+            else if (strcmp(v, "sweep") != 0) {
+                fprintf(stderr, "Unknown engine '%s' (sweep, wavefront, multigrid)\n", v);
+                exit(1);
+            }
+        } else if ((v = laplace_arg_value(argv[arg], "--time-block"))) {
+            time_block = (int)laplace_parse_size(v, "--time-block");
+            if (time_block > MAX_TIME_BLOCK) time_block = MAX_TIME_BLOCK;
+        } else if ((v = laplace_arg_value(argv[arg], "--tile-columns"))) {
+            tile_columns = laplace_parse_size(v, "--tile-columns");
+        } else if ((v = laplace_arg_value(argv[arg], "--cycle"))) {
+            fcycle = (v[0] == 'F' || v[0] == 'f');
+        } else if ((v = laplace_arg_value(argv[arg], "--simd"))) {
+            simd_name = v;
+        } else if (strcmp(argv[arg], "--simd-report") == 0) {
+            simd_report = 1;
+        } else if ((v = laplace_arg_value(argv[arg], "--snapshot-every"))) {
+            snapshot_every = (int)laplace_parse_size(v, "--snapshot-every");
+        } else if ((v = laplace_arg_value(argv[arg], "--snapshot-codec"))) {
+            if (strcmp(v, "xor") == 0) snapshot_encoding = LAPLACE_SNAPSHOT_XOR;
+            else if (strcmp(v, "raw") != 0) {
+                fprintf(stderr, "Unknown snapshot codec '%s' (raw, xor)\n", v);
+                exit(1);
+            }
+        } else if ((v = laplace_arg_value(argv[arg], "--store"))) {
+            store_path = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--analysis-every"))) {
+            analysis_every = (int)laplace_parse_size(v, "--analysis-every");
+        } else if ((v = laplace_arg_value(argv[arg], "--analysis"))) {
+            analysis_prefix = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--decimate"))) {
+            decimate = laplace_parse_size(v, "--decimate");
+        } else if ((v = laplace_arg_value(argv[arg], "--isotherms"))) {
+            isotherms = v;
+        } else if (strcmp(argv[arg], "--bench") == 0) {
+            bench_line = 1;
+        } else if (strcmp(argv[arg], "--perf") == 0) {
+            perf_report = 1;
+        } else if ((v = laplace_arg_value(argv[arg], "--stream-mb"))) {
+            stream_mb = (double)laplace_parse_size(v, "--stream-mb");
+        } else if ((v = laplace_arg_value(argv[arg], "--trace-events"))) {
+            trace_events = laplace_parse_size(v, "--trace-events");
+        } else if ((v = laplace_arg_value(argv[arg], "--trace"))) {
+            trace_path = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--placement"))) {
+            placement = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--huge-pages"))) {
+            huge_pages = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--pin"))) {
+            pin = v;
+        } else if (strcmp(argv[arg], "--codec-report") == 0) {
+            codec_report = 1;
+        } else if ((v = laplace_arg_value(argv[arg], "--snapshot"))) {
+            snapshot_path = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--check-every"))) {
+            check_spec = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--precision"))) {
+            if (strcmp(v, "mixed") == 0) mixed = 1;
+            else if (strcmp(v, "compare") == 0) compare = 1;
+            else if (strcmp(v, "double") != 0) {
+                fprintf(stderr, "Unknown precision '%s' (double, mixed, compare)\n", v);
+                exit(1);
+            }
+        }
+    }
+    // the multigrid and mixed helpers index the plate with a COLUMNS+2 stride
+    if (multigrid || mixed) pitch = laplace_grid_pitch(COLUMNS, LAPLACE_PITCH_PACKED);
+    laplace_numa_init(&numa, placement, huge_pages, pin);
+    simd = laplace_simd_select(simd_name);
+    if (simd_report) laplace_simd_report(COLUMNS);
+    if (!wavefront && !multigrid && !mixed) printf("Sweep kernels: %s\n", simd->name);
+    if (max_iterations < 0) {
+        printf("Maximum iterations [100-4000]?\n");
+        scanf("%d", &max_iterations);
+    }
+
+    // the probes run before the grids exist, so they have the memory to themselves
+    if (perf_report) {
+        laplace_perf_open(&perf, stream_mb);
+        // per cell: 3 adds and a multiply; one grid read (the neighbour rows
+        // hit in cache) and one written, counted without write-allocate as
+        // STREAM is. dt+copy: subtract and max; two reads, one write
+        perf_stencil = laplace_perf_kernel_add(&perf, "stencil", 4, 16);
+        perf_copy    = laplace_perf_kernel_add(&perf, "dt+copy", 2, 24);
+    }
+
+    // the row type depends on the pitch, so declare the grids only after parsing;
+    // pin first, so first-touch places rows where their threads will run
+    bench_start(&bench);
+    laplace_numa_pin(&numa);
+    double (*Temperature)[pitch]      = laplace_numa_alloc_grid(&numa, ROWS, pitch); // temperature grid
+    double (*Temperature_last)[pitch] = laplace_numa_alloc_grid(&numa, ROWS, pitch); // temperature grid from last iteration
+
+    if (snapshot_path) laplace_snapshot_open(&snapshots, snapshot_path, ROWS, COLUMNS, snapshot_encoding);
+    if (analysis_prefix) laplace_analysis_init(&analysis, analysis_prefix, analysis_every, decimate,
+                                               isotherms, ROWS, COLUMNS, ROWS+1, 1);
 
     gettimeofday(&start_time,NULL); // Unix timer
 
-    initialize();                   // initialize Temp_last including boundary conditions
+    initialize(pitch, Temperature_last);   // initialize Temp_last including boundary conditions
+    initialize(pitch, Temperature);        // boundaries too: unchecked iterations swap the grids
+    laplace_check_init(&check, check_spec, MAX_TEMP_ERROR);
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    laplace_trace_open(&trace, (!wavefront && !multigrid && !mixed) ? trace_path : NULL, 0,
+                       threads, trace_events);
+    if (numa.enabled) {
+        laplace_numa_report_affinity(&numa);
+        laplace_numa_report_grid(&numa, "Temperature", Temperature, ROWS, pitch);
+        laplace_numa_report_grid(&numa, "Temperature_last", Temperature_last, ROWS, pitch);
+    }
+    bench_lap(&bench, BENCH_INIT);
+
+    // multigrid and mixed run on packed grids, so their casts only change the declared row length
+    if (wavefront) {
+        iteration = wavefront_solve(pitch, Temperature, Temperature_last, max_iterations,
+                                    time_block, tile_columns, &dt) + 1;
+    } else if (multigrid) {
+        iteration = multigrid_solve((double (*)[COLUMNS+2])Temperature_last, max_iterations, fcycle, &dt) + 1;
+    } else if (mixed) {
+        iteration = mixed_solve((double (*)[COLUMNS+2])Temperature_last, max_iterations, 1, &dt) + 1;
+    }
+    bench_lap(&bench, BENCH_COMPUTE);   // the other engines count as compute
 
     // do until error is minimal or until max steps
-    while ( dt > MAX_TEMP_ERROR && iteration <= max_iterations ) {
+    while ( !wavefront && !multigrid && !mixed && dt > MAX_TEMP_ERROR && iteration <= max_iterations ) {
 
         // main calculation: average my four neighbors
-        #pragma omp parallel for private(i,j)
-        for(i = 1; i <= ROWS; i++) {
-            for(j = 1; j <= COLUMNS; j++) {
-                Temperature[i][j] = 0.25 * (Temperature_last[i+1][j] + Temperature_last[i-1][j] +
-                                            Temperature_last[i][j+1] + Temperature_last[i][j-1]);
+        if (perf_report) laplace_perf_begin(&perf, perf_stencil);
+        #pragma omp parallel private(i)
+        {
+            double trace_start = laplace_trace_now(&trace);
+            // nowait: each thread's event ends with its own rows;
+            // static: the rows --placement=first-touch gave it
+            #pragma omp for schedule(static) nowait
+            for(i = 1; i <= ROWS; i++) {
+                simd->stencil(&Temperature[i][1], &Temperature_last[i-1][1],
+                              &Temperature_last[i][1], &Temperature_last[i+1][1], COLUMNS);
             }
+            laplace_trace_add(&trace, TRACE_SWEEP, trace_start, iteration);
         }
+        if (perf_report) laplace_perf_end(&perf, perf_stencil, (double)ROWS * COLUMNS);
+        bench_lap(&bench, BENCH_COMPUTE);
         
-        dt = 0.0; // reset largest temperature change
-
-        // copy grid to old grid for next iteration and find latest dt
-        #pragma omp parallel for reduction(max:dt) private(i,j)
-        for(i = 1; i <= ROWS; i++){
-            for(j = 1; j <= COLUMNS; j++){
-	      dt = fmax( fabs(Temperature[i][j]-Temperature_last[i][j]), dt);
-	      Temperature_last[i][j] = Temperature[i][j];
+        if (laplace_check_due(&check, iteration)) {
+            dt = 0.0; // reset largest temperature change
+
+            // copy grid to old grid for next iteration and find latest dt
+            if (perf_report) laplace_perf_begin(&perf, perf_copy);
+            #pragma omp parallel reduction(max:dt) private(i)
+            {
+                double trace_start = laplace_trace_now(&trace);
+                #pragma omp for schedule(static) nowait
+                for(i = 1; i <= ROWS; i++){
+                    dt = fmax( simd->maxdiff_copy(&Temperature_last[i][1], &Temperature[i][1], COLUMNS), dt);
+                }
+                laplace_trace_add(&trace, TRACE_REDUCTION, trace_start, iteration);
             }
+            if (perf_report) laplace_perf_end(&perf, perf_copy, (double)ROWS * COLUMNS);
+            laplace_check_update(&check, iteration, dt);
+        } else {
+            // no dt wanted: swap the grids instead of copying
+            double (*temp_ptr)[pitch] = Temperature_last;
+            Temperature_last = Temperature;
+            Temperature = temp_ptr;
         }
+        bench_lap(&bench, BENCH_REDUCTION);
+        double trace_start = laplace_trace_now(&trace);
 
         // periodically print test values
         if((iteration % 100) == 0) {
- 	    track_progress(iteration);
+ 	    track_progress(iteration, pitch, Temperature_last);
+        }
+
+        // hand a copy of the grid to the snapshot writer, unless it is still busy
+        if (snapshot_path && (iteration % snapshot_every) == 0) {
+            double *slot = laplace_snapshot_slot(&snapshots, 0);
+            if (slot) {
+                #pragma omp parallel for
+                for(i = 0; i <= ROWS+1; i++) {
+                    memcpy(slot + i*(COLUMNS+2), Temperature_last[i], (COLUMNS+2)*sizeof(double));
+                }
+                laplace_snapshot_push(&snapshots, iteration, dt);
+            }
         }
 
+        // in-situ analysis of the live grid: only the small results leave
+        if (analysis_prefix && analysis_every && (iteration % analysis_every) == 0) {
+            laplace_analysis_run(&analysis, &Temperature_last[0][0], pitch, iteration);
+        }
+        laplace_trace_add(&trace, TRACE_OUTPUT, trace_start, iteration);
+        bench_lap(&bench, BENCH_OUTPUT);
+
 	iteration++;
     }
 
@@ -91,15 +405,73 @@ int main(int argc, char *argv[]) {
 
     printf("\nMax error at iteration %d was %f\n", iteration-1, dt);
     printf("Total time was %f seconds.\n", elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0);
+    if (check_spec) {
+        if (wavefront || multigrid || mixed) printf("Convergence checks: only the sweep engine honours --check-every\n");
+        else printf("Convergence checks: %d (%s)\n", check.checks,
+                    laplace_check_name(&check, check_name, sizeof(check_name)));
+    }
+
+    if (codec_report) laplace_codec_report(&Temperature_last[1][1], pitch, ROWS, COLUMNS);
+
+    // tiled store of the final plate for laplace_query.c
+    if (store_path) {
+        struct timeval store_start, store_stop;
+        gettimeofday(&store_start, NULL);
+        if (laplace_store_write(store_path, &Temperature_last[1][1], pitch, ROWS, COLUMNS,
+                                iteration-1, dt) != 0) {
+            perror(store_path);
+            exit(1);
+        }
+        gettimeofday(&store_stop, NULL);
+        timersub(&store_stop, &store_start, &store_stop);
+        printf("Store: %s written in %f seconds\n", store_path, store_stop.tv_sec+store_stop.tv_usec/1000000.0);
+    }
+
+    if (analysis_prefix) {
+        laplace_analysis_run(&analysis, &Temperature_last[0][0], pitch, iteration-1);
+        laplace_analysis_close(&analysis);
+    }
+
+    // the final plate always goes out, now that nothing is left to stall
+    if (snapshot_path) {
+        double *slot = laplace_snapshot_slot(&snapshots, 1);
+        #pragma omp parallel for
+        for(i = 0; i <= ROWS+1; i++) {
+            memcpy(slot + i*(COLUMNS+2), Temperature_last[i], (COLUMNS+2)*sizeof(double));
+        }
+        laplace_snapshot_push(&snapshots, iteration-1, dt);
+        laplace_snapshot_close(&snapshots);
+    }
+
+    if (bench_line) {
+        bench_lap(&bench, BENCH_OUTPUT);
+        bench_report(bench.seconds, bench_total(&bench), (double)ROWS * COLUMNS * (iteration-1),
+                     bench_peak_rss(), threads);
+    }
+
+    if (trace_path) {
+        if (wavefront || multigrid || mixed) printf("Trace: only the sweep engine is traced\n");
+        else laplace_trace_close(&trace, trace_path);
+    }
+
+    if (perf_report) {
+        if (wavefront || multigrid || mixed) printf("Roofline: only the sweep engine is instrumented\n");
+        else laplace_perf_report(&perf);
+    }
+
+    if (compare) {
+        compare_mixed(pitch, Temperature_last, max_iterations, elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0);
+    }
+    laplace_numa_close(&numa);
 
 }
 
 
 // initialize plate and boundary conditions
 // Temp_last is used to to start first iteration
-void initialize(){
+void initialize(int64_t pitch, double (*Temperature_last)[pitch]){
 
-    int i,j;
+    int64_t i,j;
 
     for(i = 0; i <= ROWS+1; i++){
         for (j = 0; j <= COLUMNS+1; j++){
@@ -124,13 +496,294 @@ void initialize(){
 
 
 // print diagonal in bottom right corner where most action is
-void track_progress(int iteration) {
+void track_progress(int iteration, int64_t pitch, double (*Temperature)[pitch]) {
 
-    int i;
+    int64_t i;
 
     printf("---------- Iteration number: %d ------------\n", iteration);
-    for(i = ROWS-5; i <= ROWS; i++) {
-        printf("[%d,%d]: %5.2f  ", i, i, Temperature[i][i]);
+    for(i = laplace_progress_reach(ROWS, COLUMNS); i >= 0; i--) {
+        printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", ROWS-i, COLUMNS-i, Temperature[ROWS-i][COLUMNS-i]);
     }
     printf("\n");
 }
+
+
+// one cache line per tile so threads polling a neighbour do not false-share
+typedef struct {
+    int64_t row;          // last wavefront row this tile has finished
+    char pad[56];
+} tile_progress;
+
+
+// widest tile whose live rows (2 grids x (T+3) rows) fit in half of L2,
+// but narrow enough that every thread gets at least one tile
+int64_t wavefront_tile_columns(int time_block) {
+
+    long l2 = 0;
+    int nthreads = 1;
+    int64_t width, per_thread;
+
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    if (l2 <= 0) l2 = 512*1024;   // AMD EPYC 7763
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+
+    width = l2 / 2 / (2 * (time_block + 3) * (int64_t)sizeof(double));
+    per_thread = (COLUMNS + nthreads - 1) / nthreads;
+    if (width > per_thread) width = per_thread;
+    if (width < MIN_TILE_COLUMNS) width = MIN_TILE_COLUMNS;
+    return width;
+}
+
+
+// spin until the tile to the left has finished wavefront row w
+void wait_for_tile(tile_progress *left, int64_t w) {
+
+    int64_t done;
+    int spins = 0;
+
+    for (;;) {
+        #pragma omp atomic read seq_cst
+        done = left->row;
+        if (done >= w) return;
+        if (++spins % 64 == 0) sched_yield();   // let an oversubscribed neighbour run
+    }
+}
+
+
+// advance the plate `steps` time levels without leaving cache
+// level t lives in level0 for even t and level1 for odd t, level 0 is the input;
+// dt_level[t] gets the largest change made at level t
+void wavefront_block(int64_t pitch, double (*level0)[pitch], double (*level1)[pitch],
+                     int steps, int64_t tile_columns, double *dt_level) {
+
+    int64_t ntiles = (COLUMNS + tile_columns - 1) / tile_columns;
+    tile_progress *progress = aligned_alloc(64, ntiles * sizeof(tile_progress));
+    int64_t k;
+    int t;
+
+    for (k = 0; k < ntiles; k++) progress[k].row = 0;
+    for (t = 0; t <= steps; t++) dt_level[t] = 0.0;
+
+    #pragma omp parallel private(k,t)
+    {
+        double my_dt[MAX_TIME_BLOCK+1] = {0.0};   // this thread's dt per level
+        int nthreads = 1, thread = 0;
+        int64_t w, i, j, jlo, jhi;
+
+#ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        thread = omp_get_thread_num();
+#endif
+
+        // tiles round-robin; tile k only reads columns tile k-1 has already written,
+        // so waiting on the left neighbour's wavefront row is the only sync needed
+        for (k = thread; k < ntiles; k += nthreads) {
+            for (w = 1; w <= ROWS + steps - 1; w++) {
+                if (k > 0) wait_for_tile(&progress[k-1], w);
+
+                // level t+1 works on row w-t, one row behind level t
+                for (t = 0; t < steps; t++) {
+                    double (*src)[pitch] = (t % 2 == 0) ? level0 : level1;
+                    double (*dst)[pitch] = (t % 2 == 0) ? level1 : level0;
+                    double level_dt = my_dt[t+1];
+
+                    i = w - t;
+                    if (i < 1 || i > ROWS) continue;
+
+                    // tiles lean one column left per level so the left edge
+                    // always has its neighbours ready
+                    jlo = k*tile_columns + 1 - t;
+                    jhi = (k == ntiles-1) ? COLUMNS : (k+1)*tile_columns - t;
+                    if (jlo < 1) jlo = 1;
+
+                    #pragma omp simd reduction(max:level_dt)
+                    for (j = jlo; j <= jhi; j++) {
+                        dst[i][j] = 0.25 * (src[i+1][j] + src[i-1][j] +
+                                            src[i][j+1] + src[i][j-1]);
+                        level_dt = fmax( fabs(dst[i][j]-src[i][j]), level_dt);
+                    }
+                    my_dt[t+1] = level_dt;
+                }
+
+                #pragma omp atomic write seq_cst
+                progress[k].row = w;
+            }
+        }
+
+        #pragma omp critical
+        for (t = 1; t <= steps; t++) {
+            dt_level[t] = fmax(my_dt[t], dt_level[t]);
+        }
+    }
+
+    free(progress);
+}
+
+
+// temporally blocked solve; returns the number of iterations done and
+// leaves the final plate in both grids, like the two-loop sweep
+int wavefront_solve(int64_t pitch, double (*Temperature)[pitch], double (*Temperature_last)[pitch],
+                    int max_iterations, int time_block, int64_t tile_columns, double *dt) {
+
+    double (*current)[pitch] = Temperature_last;       // newest time level
+    double (*other)[pitch]   = Temperature;
+    double (*snapshot)[pitch] = NULL;                  // start of the block, near convergence
+    double dt_level[MAX_TIME_BLOCK+1];
+    size_t bytes = (size_t)(ROWS+2) * (size_t)pitch * sizeof(double);
+    int iteration = 0;                                 // time levels completed
+    int near = 1;                                      // convergence may fall in the next block
+    int overshoot = 0;                                 // levels past convergence (no snapshot)
+    int steps, t;
+
+    if (tile_columns == 0) tile_columns = wavefront_tile_columns(time_block);
+    printf("Wavefront engine: %d time levels per pass, %" PRId64 "-column tiles\n",
+           time_block, tile_columns);
+
+    // levels alternate between the grids, so both need the fixed boundaries
+    memcpy(Temperature, Temperature_last, bytes);
+
+    *dt = 100;
+    while ( *dt > MAX_TEMP_ERROR && iteration < max_iterations ) {
+
+        // end blocks on max_iterations and on every 100th iteration for track_progress
+        steps = time_block;
+        if (steps > max_iterations - iteration) steps = max_iterations - iteration;
+        if (steps > 100 - iteration % 100) steps = 100 - iteration % 100;
+
+        if (near) {
+            if (!snapshot) snapshot = laplace_alloc_pitched_grid(ROWS, pitch);
+            memcpy(snapshot, current, bytes);
+        }
+
+        wavefront_block(pitch, current, other, steps, tile_columns, dt_level);
+
+        // the sweep would have stopped at the first level under the tolerance
+        for (t = 1; t < steps && dt_level[t] > MAX_TEMP_ERROR; t++) ;
+        if (t < steps) {
+            if (near) {
+                memcpy(current, snapshot, bytes);
+                steps = t;
+                wavefront_block(pitch, current, other, steps, tile_columns, dt_level);
+            } else {
+                overshoot = steps - t;
+                steps = t;
+            }
+        }
+
+        // newest level is in `other` after an odd number of steps
+        if ((steps + overshoot) % 2 == 1) {
+            double (*swap)[pitch] = current;
+            current = other;
+            other = swap;
+        }
+        iteration += steps;
+        *dt = dt_level[steps];
+
+        // geometric decay over this block predicts whether the next one converges
+        if (steps > 1 && dt_level[1] > *dt && *dt > 0.0) {
+            double rate = pow(*dt / dt_level[1], 1.0 / (steps - 1));
+            near = log(MAX_TEMP_ERROR / *dt) / log(rate) < 2 * time_block;
+        }
+
+        // periodically print test values
+        if ((iteration % 100) == 0) {
+            track_progress(iteration, pitch, current);
+        }
+    }
+
+    if (overshoot) {
+        printf("Wavefront engine: converged %d levels before the end of a block\n", overshoot);
+    }
+
+    // leave the newest plate in both grids
+    memcpy(other, current, bytes);
+    free(snapshot);
+    return iteration;
+}
+
+
+// multigrid cycles until the Jacobi-equivalent dt meets MAX_TEMP_ERROR;
+// returns the number of cycles
+int multigrid_solve(double (*Temperature_last)[COLUMNS+2], int max_iterations, int fcycle, double *dt) {
+
+    laplace_mg mg;
+    int cycle = 0;
+
+    laplace_mg_init(&mg, ROWS, COLUMNS, Temperature_last);
+    printf("Multigrid engine: %c-cycles over %d levels\n", fcycle ? 'F' : 'V', mg.levels);
+
+    *dt = 100;
+    while ( *dt > MAX_TEMP_ERROR && cycle < max_iterations ) {
+        *dt = laplace_mg_cycle(&mg, fcycle);
+        cycle++;
+
+        // cycles are few, so show every one
+        track_progress(cycle, COLUMNS+2, Temperature_last);
+        printf("residual max %e  rms %e\n", mg.residual_max, mg.residual_rms);
+    }
+
+    laplace_mg_free(&mg);
+    return cycle;
+}
+
+
+// mixed precision: float sweeps on the correction, refined in double every
+// 100 iterations (when progress is printed); returns the number of sweeps
+int mixed_solve(double (*Temperature_last)[COLUMNS+2], int max_iterations, int verbose, double *dt) {
+
+    laplace_mixed m;
+    int iteration = 0;
+
+    laplace_mixed_init(&m, ROWS, COLUMNS, Temperature_last);
+    laplace_mixed_refine(&m);
+
+    *dt = 100;
+    while ( *dt > MAX_TEMP_ERROR && iteration < max_iterations ) {
+        *dt = laplace_mixed_sweep(&m);
+        iteration++;
+
+        // refine where the double solver prints, so the printed values compare
+        if((iteration % 100) == 0) {
+            laplace_mixed_refine(&m);
+            if (verbose) track_progress(iteration, COLUMNS+2, Temperature_last);
+        }
+    }
+
+    laplace_mixed_fold(&m);
+    laplace_mixed_free(&m);
+    return iteration;
+}
+
+
+// rerun in mixed precision and report the speedup and the largest
+// difference from the double result
+void compare_mixed(int64_t pitch, double (*Temperature_last)[pitch], int max_iterations, double double_seconds) {
+
+    double (*Mixed)[COLUMNS+2] = laplace_alloc_grid(ROWS, COLUMNS);
+    struct timeval start_time, stop_time, elapsed_time;
+    double seconds, dt, diff = 0.0;
+    int64_t i, j;
+    int iterations;
+
+    gettimeofday(&start_time,NULL);
+    initialize(COLUMNS+2, Mixed);
+    iterations = mixed_solve(Mixed, max_iterations, 0, &dt);
+    gettimeofday(&stop_time,NULL);
+    timersub(&stop_time, &start_time, &elapsed_time);
+    seconds = elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0;
+
+    for(i = 0; i <= ROWS+1; i++) {
+        for(j = 0; j <= COLUMNS+1; j++) {
+            diff = fmax(fabs(Mixed[i][j] - Temperature_last[i][j]), diff);
+        }
+    }
+
+    printf("\nMixed precision: max error at iteration %d was %f\n", iterations, dt);
+    printf("Mixed precision: total time was %f seconds (%.2fx)\n", seconds, double_seconds / seconds);
+    printf("Mixed precision: max |mixed - double| = %e\n", diff);
+    free(Mixed);
+}
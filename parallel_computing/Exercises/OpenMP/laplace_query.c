@@ -0,0 +1,200 @@
+/*************************************************
+ * Queries on a tiled Laplace solution store
+ *
+ *   ./laplace_omp.out --size=10000 ... --store=plate.tiles
+ *   ./laplace_query.out plate.tiles [--queries=N] [--window=W] [--range=LO:HI]
+ *
+ * Prints the track_progress corner of the stored plate, then times
+ * the same queries two ways, each from a cold page cache (the file's
+ * pages are dropped with posix_fadvise first):
+ *
+ *   mmap   map the store and touch only the tiles a query needs
+ *   load   read the whole file into memory, then query it
+ *
+ * The queries are N random cells, a W x W window at the hot corner, one
+ * full row and a count of the cells between LO and HI degrees (default
+ * 50:100), which reads only the tiles the min/max index cannot decide.
+ * For each, the time and the page faults it took (getrusage; major
+ * faults went to the disk) are reported.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "../../common/laplace_store.h"
+
+typedef struct {
+    double seconds;
+    long minor, major;
+} probe;
+
+static probe probe_now(void) {
+    struct timeval tv;
+    struct rusage ru;
+    probe p;
+    gettimeofday(&tv, NULL);
+    getrusage(RUSAGE_SELF, &ru);
+    p.seconds = tv.tv_sec + tv.tv_usec / 1000000.0;
+    p.minor = ru.ru_minflt;
+    p.major = ru.ru_majflt;
+    return p;
+}
+
+static void report(const char *mode, const char *what, probe start, int count) {
+    probe stop = probe_now();
+    printf("%-5s %-22s %12.2f us %10ld faults %8ld major\n", mode, what,
+           (stop.seconds - start.seconds) * 1e6 / count,
+           stop.minor - start.minor + stop.major - start.major, stop.major - start.major);
+}
+
+// drop the file's cached pages so the next read goes to the disk
+static void evict(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+// the same queries for either mode; returns a checksum so none is optimised away
+static double run_queries(const char *mode, const laplace_store *s, int queries, int64_t window,
+                          double lo, double hi) {
+
+    int64_t rows = s->header.rows, columns = s->header.columns;
+    int64_t count, tiles_read;
+    double *out = malloc((window * window > columns ? window * window : columns) * sizeof(double));
+    double sum = 0.0;
+    probe start;
+    int q;
+
+    srand(2025);
+    start = probe_now();
+    for (q = 0; q < queries; q++) {
+        sum += laplace_store_cell(s, 1 + rand() % rows, 1 + rand() % columns);
+    }
+    report(mode, "random cell", start, queries);
+
+    start = probe_now();
+    laplace_store_rect(s, rows - window + 1, columns - window + 1, window, window, out);
+    sum += out[window * window - 1];
+    {
+        char what[64];
+        snprintf(what, sizeof(what), "%" PRId64 "x%" PRId64 " corner window", window, window);
+        report(mode, what, start, 1);
+    }
+
+    start = probe_now();
+    laplace_store_row(s, rows / 2, out);
+    sum += out[columns / 2];
+    report(mode, "one row", start, 1);
+
+    start = probe_now();
+    count = laplace_store_count_range(s, lo, hi, &tiles_read);
+    sum += count;
+    {
+        char what[64];
+        snprintf(what, sizeof(what), "range, %" PRId64 "/%" PRId64 " tiles",
+                 tiles_read, s->header.tiles_down * s->header.tiles_across);
+        report(mode, what, start, 1);
+    }
+
+    free(out);
+    return sum;
+}
+
+int main(int argc, char *argv[]) {
+
+    const char *path = NULL;
+    int queries = 1000;
+    int64_t window = 64;
+    double lo = 50.0, hi = 100.0;
+    int64_t n, reach;
+    laplace_store s;
+    probe start;
+    double check_mmap, check_load;
+    int64_t i;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (strncmp(argv[arg], "--queries=", 10) == 0) queries = atoi(argv[arg] + 10);
+        else if (strncmp(argv[arg], "--window=", 9) == 0) window = atoll(argv[arg] + 9);
+        else if (strncmp(argv[arg], "--range=", 8) == 0) {
+            if (sscanf(argv[arg] + 8, "%lf:%lf", &lo, &hi) != 2 || lo > hi) {
+                fprintf(stderr, "--range=%s must be LO:HI with LO <= HI\n", argv[arg] + 8);
+                return 1;
+            }
+        }
+        else path = argv[arg];
+    }
+    if (!path) {
+        fprintf(stderr, "usage: %s STORE [--queries=N] [--window=W] [--range=LO:HI]\n", argv[0]);
+        return 1;
+    }
+
+    // mmap: only the pages a query lands on are read
+    evict(path);
+    start = probe_now();
+    if (laplace_store_open(&s, path) != 0) {
+        fprintf(stderr, "%s is not a Laplace store\n", path);
+        return 1;
+    }
+    report("mmap", "open", start, 1);
+    if (window > s.header.rows) window = s.header.rows;
+    if (window > s.header.columns) window = s.header.columns;
+
+    printf("Store: %" PRId64 "x%" PRId64 ", %" PRId64 "x%" PRId64 " tiles, iteration %" PRId64
+           ", dt %f, %.1f MB\n", s.header.rows, s.header.columns, s.header.tile_rows,
+           s.header.tile_columns, s.header.iteration, s.header.dt, s.map_bytes / 1e6);
+    // same corner as track_progress, at most six cells and none outside a small store
+    n = s.header.rows < s.header.columns ? s.header.rows : s.header.columns;
+    reach = n < 6 ? n - 1 : 5;
+    for (i = reach; i >= 0; i--) {
+        printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", s.header.rows - i, s.header.columns - i,
+               laplace_store_cell(&s, s.header.rows - i, s.header.columns - i));
+    }
+    printf("\n");
+
+    check_mmap = run_queries("mmap", &s, queries, window, lo, hi);
+    laplace_store_close(&s);
+
+    // load: read everything first, then query the copy
+    evict(path);
+    {
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        unsigned char *buffer;
+        size_t done = 0;
+        ssize_t n;
+
+        start = probe_now();
+        fstat(fd, &st);
+        buffer = malloc(st.st_size);
+        while (done < (size_t)st.st_size && (n = read(fd, buffer + done, st.st_size - done)) > 0) {
+            done += n;
+        }
+        close(fd);
+        report("load", "read whole file", start, 1);
+
+        s.map = buffer;
+        s.map_bytes = st.st_size;
+        memcpy(&s.header, buffer, sizeof(s.header));
+        s.index = (const laplace_tile_stats *)(buffer + s.header.index_offset);
+        check_load = run_queries("load", &s, queries, window, lo, hi);
+        free(buffer);
+    }
+
+    if (check_mmap != check_load) {
+        fprintf(stderr, "mmap and load queries disagree\n");
+        return 1;
+    }
+    return 0;
+}
@@ -20,65 +20,200 @@
  *
  ************************************************/
 
+/*************************************************
+ * Engines
+ *
+ *   --engine=sweep       Jacobi sweep below (default)
+ *   --engine=multigrid   geometric multigrid, common/laplace_multigrid.h
+ *   --cycle=V|F          multigrid cycle shape (default V)
+ *   --simd=NAME          sweep kernels: auto (default), avx512, avx2, sse2
+ *                        or scalar; common/laplace_simd.h
+ *   --simd-report        time each kernel set before solving
+ *   --precision=mixed    sweep a float correction with a double
+ *                        residual every 100 iterations;
+ *                        common/laplace_mixed.h
+ *   --precision=compare  solve in double, then again in mixed, and
+ *                        print the speedup and max |mixed - double|
+ *   --check-every=N|auto measure dt every Nth sweep, or at a spacing
+ *                        set by its decay; common/laplace_check.h
+ *   --snapshot=FILE      append the plate to FILE every
+ *   --snapshot-every=N   N sweeps (default 100) and at the end, from a
+ *                        writer thread; common/laplace_snapshot.h
+ *   --snapshot-codec=xor store snapshots through the lossless codec,
+ *                        common/laplace_codec.h
+ *   --codec-report       time the codec on the final plate
+ *   --store=FILE         save the final plate as a tiled store for
+ *                        laplace_query.c; common/laplace_store.h
+ *   --pitch=packed|aligned|padded|N
+ *                        doubles from one row to the next, padded by
+ *                        default; see laplace_grid_pitch() in
+ *                        common/laplace_args.h
+ *
+ * Multigrid counts one iteration per cycle and stops on the same
+ * Jacobi-equivalent dt as the sweep. Compile with -fopenmp to run
+ * the multigrid loops in parallel. Multigrid and mixed precision
+ * work on packed rows, so they ignore --pitch.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
 #include <sys/time.h>
-
-// size of plate
-#define COLUMNS    1000
-#define ROWS       1000
-
-// largest permitted change in temp (This value takes about 3400 steps)
-#define MAX_TEMP_ERROR 0.01
-
-double Temperature[ROWS+2][COLUMNS+2];      // temperature grid
-double Temperature_last[ROWS+2][COLUMNS+2]; // temperature grid from last iteration
+#include "../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
+#include "../../common/laplace_multigrid.h"
+#include "../../common/laplace_simd.h"
+#include "../../common/laplace_mixed.h"
+#include "../../common/laplace_check.h"
+#include "../../common/laplace_snapshot.h"
+#include "../../common/laplace_store.h"
 
 //   helper routines
-void initialize();
-void track_progress(int iter);
+void initialize(int64_t pitch, double (*Temperature_last)[pitch]);
+void track_progress(int iter, int64_t pitch, double (*Temperature)[pitch]);
+int multigrid_solve(double (*Temperature_last)[COLUMNS+2], int max_iterations, int fcycle, double *dt);
+int mixed_solve(double (*Temperature_last)[COLUMNS+2], int max_iterations, int verbose, double *dt);
+void compare_mixed(int64_t pitch, double (*Temperature_last)[pitch], int max_iterations, double double_seconds);
 
 
 int main(int argc, char *argv[]) {
 
-    int i, j;                                            // grid indexes
+    int64_t i;                                           // grid row index
     int max_iterations;                                  // number of iterations
     int iteration=1;                                     // current iteration
     double dt=100;                                       // largest change in t
     struct timeval start_time, stop_time, elapsed_time;  // timers
+    int multigrid = 0;                                   // use the multigrid engine
+    int fcycle = 0;                                      // multigrid F-cycles instead of V-cycles
+    const char *simd_name = NULL;                        // sweep kernel set, NULL = widest supported
+    int simd_report = 0;                                 // time the kernel sets first
+    const laplace_simd_kernels *simd;                    // sweep kernels
+    int mixed = 0;                                       // float sweeps with double refinement
+    int compare = 0;                                     // rerun mixed and compare with double
+    const char *check_spec = NULL;                       // --check-every, NULL = every iteration
+    laplace_check check;                                 // when to measure dt
+    char check_name[32];
+    const char *snapshot_path = NULL;                    // --snapshot file, NULL = none
+    int snapshot_every = 100;                            // iterations between snapshots
+    laplace_snapshot snapshots;                          // buffers and writer thread
+    int snapshot_encoding = LAPLACE_SNAPSHOT_RAW;        // --snapshot-codec
+    int codec_report = 0;                                // time the codec on the final plate
+    const char *store_path = NULL;                       // --store file for the final plate
+    int64_t pitch;                                       // doubles from one row to the next
+    const char *v;
+    int arg;
+
+    max_iterations = laplace_parse_args(argc, argv);
+    pitch = laplace_grid_pitch(COLUMNS, LAPLACE_PITCH_PADDED);
+    for (arg = 1; arg < argc; arg++) {
+        if ((v = laplace_arg_value(argv[arg], "--pitch"))) {
+            pitch = laplace_parse_pitch(v, COLUMNS);
+        } else if ((v = laplace_arg_value(argv[arg], "--engine"))) {
+            if (strcmp(v, "multigrid") == 0) multigrid = 1;
+            else if (strcmp(v, "sweep") != 0) {
+                fprintf(stderr, "Unknown engine '%s' (sweep, multigrid)\n", v);
+                exit(1);
+            }
+        } else if ((v = laplace_arg_value(argv[arg], "--cycle"))) {
+            fcycle = (v[0] == 'F' || v[0] == 'f');
+        } else if ((v = laplace_arg_value(argv[arg], "--simd"))) {
+            simd_name = v;
+        } else if (strcmp(argv[arg], "--simd-report") == 0) {
+            simd_report = 1;
+        } else if ((v = laplace_arg_value(argv[arg], "--snapshot-every"))) {
+            snapshot_every = (int)laplace_parse_size(v, "--snapshot-every");
+        } else if ((v = laplace_arg_value(argv[arg], "--snapshot-codec"))) {
+            if (strcmp(v, "xor") == 0) snapshot_encoding = LAPLACE_SNAPSHOT_XOR;
+            else if (strcmp(v, "raw") != 0) {
+                fprintf(stderr, "Unknown snapshot codec '%s' (raw, xor)\n", v);
+                exit(1);
+            }
+        } else if ((v = laplace_arg_value(argv[arg], "--store"))) {
+            store_path = v;
+        } else if (strcmp(argv[arg], "--codec-report") == 0) {
+            codec_report = 1;
+        } else if ((v = laplace_arg_value(argv[arg], "--snapshot"))) {
+            snapshot_path = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--check-every"))) {
+            check_spec = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--precision"))) {
+            if (strcmp(v, "mixed") == 0) mixed = 1;
+            else if (strcmp(v, "compare") == 0) compare = 1;
+            else if (strcmp(v, "double") != 0) {
+                fprintf(stderr, "Unknown precision '%s' (double, mixed, compare)\n", v);
+                exit(1);
+            }
+        }
+    }
+    // the multigrid and mixed helpers index the plate with a COLUMNS+2 stride
+    if (multigrid || mixed) pitch = laplace_grid_pitch(COLUMNS, LAPLACE_PITCH_PACKED);
+    simd = laplace_simd_select(simd_name);
+    if (simd_report) laplace_simd_report(COLUMNS);
+    if (!multigrid && !mixed) printf("Sweep kernels: %s\n", simd->name);
+    if (max_iterations < 0) {
+        printf("Maximum iterations [100-4000]?\n");
+        scanf("%d", &max_iterations);
+    }
 
-    printf("Maximum iterations [100-4000]?\n");
-    scanf("%d", &max_iterations);
+    // the row type depends on the pitch, so declare the grids only after parsing
+    double (*Temperature)[pitch]      = laplace_alloc_pitched_grid(ROWS, pitch); // temperature grid
+    double (*Temperature_last)[pitch] = laplace_alloc_pitched_grid(ROWS, pitch); // temperature grid from last iteration
+
+    if (snapshot_path) laplace_snapshot_open(&snapshots, snapshot_path, ROWS, COLUMNS, snapshot_encoding);
 
     gettimeofday(&start_time,NULL); // Unix timer
 
-    initialize();                   // initialize Temp_last including boundary conditions
+    initialize(pitch, Temperature_last);   // initialize Temp_last including boundary conditions
+    initialize(pitch, Temperature);        // boundaries too: unchecked iterations swap the grids
+    laplace_check_init(&check, check_spec, MAX_TEMP_ERROR);
+
+    // packed above, so the cast only changes the declared row length
+    if (multigrid) {
+        iteration = multigrid_solve((double (*)[COLUMNS+2])Temperature_last, max_iterations, fcycle, &dt) + 1;
+    } else if (mixed) {
+        iteration = mixed_solve((double (*)[COLUMNS+2])Temperature_last, max_iterations, 1, &dt) + 1;
+    }
 
     // do until error is minimal or until max steps
-    while ( dt > MAX_TEMP_ERROR && iteration <= max_iterations ) {
+    while ( !multigrid && !mixed && dt > MAX_TEMP_ERROR && iteration <= max_iterations ) {
 
         // main calculation: average my four neighbors
         for(i = 1; i <= ROWS; i++) {
-            for(j = 1; j <= COLUMNS; j++) {
-                Temperature[i][j] = 0.25 * (Temperature_last[i+1][j] + Temperature_last[i-1][j] +
-                                            Temperature_last[i][j+1] + Temperature_last[i][j-1]);
-            }
+            simd->stencil(&Temperature[i][1], &Temperature_last[i-1][1],
+                          &Temperature_last[i][1], &Temperature_last[i+1][1], COLUMNS);
         }
         
-        dt = 0.0; // reset largest temperature change
+        if (laplace_check_due(&check, iteration)) {
+            dt = 0.0; // reset largest temperature change
 
-        // copy grid to old grid for next iteration and find latest dt
-        for(i = 1; i <= ROWS; i++){
-            for(j = 1; j <= COLUMNS; j++){
-	      dt = fmax( fabs(Temperature[i][j]-Temperature_last[i][j]), dt);
-	      Temperature_last[i][j] = Temperature[i][j];
+            // copy grid to old grid for next iteration and find latest dt
+            for(i = 1; i <= ROWS; i++){
+                dt = fmax( simd->maxdiff_copy(&Temperature_last[i][1], &Temperature[i][1], COLUMNS), dt);
             }
+            laplace_check_update(&check, iteration, dt);
+        } else {
+            // no dt wanted: swap the grids instead of copying
+            double (*temp_ptr)[pitch] = Temperature_last;
+            Temperature_last = Temperature;
+            Temperature = temp_ptr;
         }
 
         // periodically print test values
         if((iteration % 100) == 0) {
- 	    track_progress(iteration);
+ 	    track_progress(iteration, pitch, Temperature_last);
+        }
+
+        // hand a copy of the grid to the snapshot writer, unless it is still busy
+        if (snapshot_path && (iteration % snapshot_every) == 0) {
+            double *slot = laplace_snapshot_slot(&snapshots, 0);
+            if (slot) {
+                for(i = 0; i <= ROWS+1; i++) {
+                    memcpy(slot + i*(COLUMNS+2), Temperature_last[i], (COLUMNS+2)*sizeof(double));
+                }
+                laplace_snapshot_push(&snapshots, iteration, dt);
+            }
         }
 
 	iteration++;
@@ -89,15 +224,49 @@ int main(int argc, char *argv[]) {
 
     printf("\nMax error at iteration %d was %f\n", iteration-1, dt);
     printf("Total time was %f seconds.\n", elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0);
+    if (check_spec && !multigrid && !mixed) {
+        printf("Convergence checks: %d (%s)\n", check.checks,
+               laplace_check_name(&check, check_name, sizeof(check_name)));
+    }
+
+    if (codec_report) laplace_codec_report(&Temperature_last[1][1], pitch, ROWS, COLUMNS);
+
+    // tiled store of the final plate for laplace_query.c
+    if (store_path) {
+        struct timeval store_start, store_stop;
+        gettimeofday(&store_start, NULL);
+        if (laplace_store_write(store_path, &Temperature_last[1][1], pitch, ROWS, COLUMNS,
+                                iteration-1, dt) != 0) {
+            perror(store_path);
+            exit(1);
+        }
+        gettimeofday(&store_stop, NULL);
+        timersub(&store_stop, &store_start, &store_stop);
+        printf("Store: %s written in %f seconds\n", store_path, store_stop.tv_sec+store_stop.tv_usec/1000000.0);
+    }
+
+    // the final plate always goes out, now that nothing is left to stall
+    if (snapshot_path) {
+        double *slot = laplace_snapshot_slot(&snapshots, 1);
+        for(i = 0; i <= ROWS+1; i++) {
+            memcpy(slot + i*(COLUMNS+2), Temperature_last[i], (COLUMNS+2)*sizeof(double));
+        }
+        laplace_snapshot_push(&snapshots, iteration-1, dt);
+        laplace_snapshot_close(&snapshots);
+    }
+
+    if (compare) {
+        compare_mixed(pitch, Temperature_last, max_iterations, elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0);
+    }
 
 }
 
 
 // initialize plate and boundary conditions
 // Temp_last is used to to start first iteration
-void initialize(){
+void initialize(int64_t pitch, double (*Temperature_last)[pitch]){
 
-    int i,j;
+    int64_t i,j;
 
     for(i = 0; i <= ROWS+1; i++){
         for (j = 0; j <= COLUMNS+1; j++){
@@ -122,13 +291,96 @@ void initialize(){
 
 
 // print diagonal in bottom right corner where most action is
-void track_progress(int iteration) {
+void track_progress(int iteration, int64_t pitch, double (*Temperature)[pitch]) {
 
-    int i;
+    int64_t i;
 
     printf("---------- Iteration number: %d ------------\n", iteration);
-    for(i = ROWS-5; i <= ROWS; i++) {
-        printf("[%d,%d]: %5.2f  ", i, i, Temperature[i][i]);
+    for(i = laplace_progress_reach(ROWS, COLUMNS); i >= 0; i--) {
+        printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", ROWS-i, COLUMNS-i, Temperature[ROWS-i][COLUMNS-i]);
     }
     printf("\n");
 }
+
+
+// multigrid cycles until the Jacobi-equivalent dt meets MAX_TEMP_ERROR;
+// returns the number of cycles
+int multigrid_solve(double (*Temperature_last)[COLUMNS+2], int max_iterations, int fcycle, double *dt) {
+
+    laplace_mg mg;
+    int cycle = 0;
+
+    laplace_mg_init(&mg, ROWS, COLUMNS, Temperature_last);
+    printf("Multigrid engine: %c-cycles over %d levels\n", fcycle ? 'F' : 'V', mg.levels);
+
+    *dt = 100;
+    while ( *dt > MAX_TEMP_ERROR && cycle < max_iterations ) {
+        *dt = laplace_mg_cycle(&mg, fcycle);
+        cycle++;
+
+        // cycles are few, so show every one
+        track_progress(cycle, COLUMNS+2, Temperature_last);
+        printf("residual max %e  rms %e\n", mg.residual_max, mg.residual_rms);
+    }
+
+    laplace_mg_free(&mg);
+    return cycle;
+}
+
+
+// mixed precision: float sweeps on the correction, refined in double every
+// 100 iterations (when progress is printed); returns the number of sweeps
+int mixed_solve(double (*Temperature_last)[COLUMNS+2], int max_iterations, int verbose, double *dt) {
+
+    laplace_mixed m;
+    int iteration = 0;
+
+    laplace_mixed_init(&m, ROWS, COLUMNS, Temperature_last);
+    laplace_mixed_refine(&m);
+
+    *dt = 100;
+    while ( *dt > MAX_TEMP_ERROR && iteration < max_iterations ) {
+        *dt = laplace_mixed_sweep(&m);
+        iteration++;
+
+        // refine where the double solver prints, so the printed values compare
+        if((iteration % 100) == 0) {
+            laplace_mixed_refine(&m);
+            if (verbose) track_progress(iteration, COLUMNS+2, Temperature_last);
+        }
+    }
+
+    laplace_mixed_fold(&m);
+    laplace_mixed_free(&m);
+    return iteration;
+}
+
+
+// rerun in mixed precision and report the speedup and the largest
+// difference from the double result
+void compare_mixed(int64_t pitch, double (*Temperature_last)[pitch], int max_iterations, double double_seconds) {
+
+    double (*Mixed)[COLUMNS+2] = laplace_alloc_grid(ROWS, COLUMNS);
+    struct timeval start_time, stop_time, elapsed_time;
+    double seconds, dt, diff = 0.0;
+    int64_t i, j;
+    int iterations;
+
+    gettimeofday(&start_time,NULL);
+    initialize(COLUMNS+2, Mixed);
+    iterations = mixed_solve(Mixed, max_iterations, 0, &dt);
+    gettimeofday(&stop_time,NULL);
+    timersub(&stop_time, &start_time, &elapsed_time);
+    seconds = elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0;
+
+    for(i = 0; i <= ROWS+1; i++) {
+        for(j = 0; j <= COLUMNS+1; j++) {
+            diff = fmax(fabs(Mixed[i][j] - Temperature_last[i][j]), diff);
+        }
+    }
+
+    printf("\nMixed precision: max error at iteration %d was %f\n", iterations, dt);
+    printf("Mixed precision: total time was %f seconds (%.2fx)\n", seconds, double_seconds / seconds);
+    printf("Mixed precision: max |mixed - double| = %e\n", diff);
+    free(Mixed);
+}
@@ -0,0 +1,68 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: interleaved vs split red/black storage layout
+# Objective:
+#   1. run laplace_omp_parallel.c with the interleaved checkerboard
+#      (stride-2 sweeps) and with --layout=split (unit-stride sweeps)
+#   2. compare ns per cell update over a fixed iteration count, from
+#      cache-resident to memory-bound plates, at 1, 8 and 32 threads
+#   3. check both layouts stop on the same iteration for a full solve
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_layout_result.txt"
+max_itr=4000
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${CC} ${CFLAGS}"
+
+${CC} ${CFLAGS} laplace_omp_parallel.c -o laplace_p.out -lm || exit 1
+
+# Arrays of plate sizes and thread counts to test
+sizes=(200 1000 4000)
+thread_counts=(1 8 32)
+bench_itr=200
+
+# pull the solver's own timer out of its output
+solver_time() {
+    grep -E "Total time" | sed -r 's/[^0-9.]*([0-9.]+).*/\1/'
+}
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN!!!!" >> ${output_file}
+printf "%-12s %6s %8s %10s %14s %8s\n" "layout" "size" "threads" "time(s)" "ns/cell-update" "speedup" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for threads in "${thread_counts[@]}"
+    do
+        echo "Running ${size}x${size} with ${threads} threads..."
+        export OMP_NUM_THREADS=${threads}
+        base=""
+        for layout in interleaved split
+        do
+            t=$(./laplace_p.out --size=${size} --max-temp-error=0 --max-iterations=${bench_itr} --layout=${layout} | solver_time)
+            ns=$(echo "${t} ${size} ${bench_itr}" | awk '{printf "%.3f", $1*1e9/($2*$2*$3)}')
+            if [ -z "${base}" ]; then base=${t}; fi
+            speedup=$(echo "${base} ${t}" | awk '{printf "%.2f", $1/$2}')
+            printf "%-12s %6d %8d %10s %14s %8s\n" ${layout} ${size} ${threads} ${t} ${ns} ${speedup} >> ${output_file}
+        done
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+
+echo "!!!!FULL SOLVE, 1000x1000!!!!" >> ${output_file}
+for layout in interleaved split
+do
+    echo "=== ${layout} ===" >> ${output_file}
+    ./laplace_p.out --size=1000 --max-iterations=${max_itr} --layout=${layout} | tail -3 >> ${output_file}
+done
+echo "Layout benchmark complete. Results saved in ${output_file}"
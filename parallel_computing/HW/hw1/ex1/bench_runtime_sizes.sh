@@ -0,0 +1,87 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: run-time vs compile-time plate size benchmark
+# Objective:
+#   1. build serial / omp / checkerboard omp twice: once with the plate
+#      size fixed at compile time (-DROWS -DCOLUMNS), once sized at run time
+#   2. run both builds side by side on the same 1000x1000 problem so any
+#      slowdown from the run-time sizes shows up in the hot loop timings
+#   3. run the run-time build on larger plates (the fixed build cannot)
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_runtime_sizes_result.txt"
+max_itr=4000
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${CC} ${CFLAGS}"
+
+# build both flavours of each solver
+sources=(../ex2/laplace_serial.c laplace_omp.c laplace_omp_parallel.c)
+names=(serial omp redblack)
+for k in "${!sources[@]}"
+do
+    ${CC} ${CFLAGS} -DROWS=1000 -DCOLUMNS=1000 ${sources[$k]} -o laplace_${names[$k]}_fixed.out -lm || exit 1
+    ${CC} ${CFLAGS} ${sources[$k]} -o laplace_${names[$k]}_runtime.out -lm || exit 1
+done
+
+# Array of thread counts to test
+thread_counts=(1 8 32)
+
+# pull the solver's own timer out of its output
+solver_time() {
+    grep -E "Total time" | sed -r 's/[^0-9.]*([0-9.]+).*/\1/'
+}
+
+echo "!!!!1000x1000: COMPILE-TIME vs RUN-TIME SIZES!!!!" >> ${output_file}
+printf "%-10s %8s %12s %12s %8s\n" "solver" "threads" "fixed(s)" "runtime(s)" "ratio" >> ${output_file}
+for name in "${names[@]}"
+do
+    for threads in "${thread_counts[@]}"
+    do
+        echo "Running ${name} with ${threads} threads..."
+        export OMP_NUM_THREADS=${threads}
+        fixed=$(./laplace_${name}_fixed.out --max-iterations=${max_itr} | solver_time)
+        runtime=$(./laplace_${name}_runtime.out --size=1000 --max-iterations=${max_itr} | solver_time)
+        ratio=$(echo "${runtime} ${fixed}" | awk '{printf "%.3f", $1/$2}')
+        printf "%-10s %8d %12s %12s %8s\n" ${name} ${threads} ${fixed} ${runtime} ${ratio} >> ${output_file}
+
+        # serial code ignores the thread count
+        if [ "${name}" == "serial" ]; then break; fi
+    done
+done
+echo "----------------------------------------" >> ${output_file}
+echo "" >> ${output_file}
+
+# larger plates only exist in the run-time build; a fixed iteration count
+# keeps the runs short, time per cell update is what matters here
+sizes=(1000 4000 20000)
+bench_itr=100
+echo "!!!!RUN-TIME SIZES: ${bench_itr} ITERATIONS, LARGER PLATES!!!!" >> ${output_file}
+printf "%-10s %8s %8s %12s %14s\n" "solver" "size" "threads" "time(s)" "ns/cell-update" >> ${output_file}
+for name in omp redblack
+do
+    for size in "${sizes[@]}"
+    do
+        for threads in "${thread_counts[@]}"
+        do
+            echo "Running ${name} ${size}x${size} with ${threads} threads..."
+            export OMP_NUM_THREADS=${threads}
+            t=$(./laplace_${name}_runtime.out --size=${size} --max-temp-error=0 --max-iterations=${bench_itr} | solver_time)
+            ns=$(echo "${t} ${size} ${bench_itr}" | awk '{printf "%.3f", $1*1e9/($2*$2*$3)}')
+            printf "%-10s %8d %8d %12s %14s\n" ${name} ${size} ${threads} ${t} ${ns} >> ${output_file}
+        done
+    done
+done
+echo "----------------------------------------" >> ${output_file}
+echo "Run-time size benchmark complete. Results saved in ${output_file}"
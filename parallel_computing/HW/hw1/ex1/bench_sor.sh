@@ -0,0 +1,64 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: red-black Gauss-Seidel vs SOR (fixed and auto omega)
+# Objective:
+#   1. run laplace_omp_parallel.c with omega = 1 (plain Gauss-Seidel),
+#      a few fixed omegas and --omega=auto
+#   2. report iterations and wall clock, and how many times fewer
+#      iterations / less time each mode needs than Gauss-Seidel
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_sor_result.txt"
+max_itr=100000
+
+# compiler: gcc by default, e.g. CC=nvc CFLAGS="-fast -mp" on Delta
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/../../hw3/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${CC} ${CFLAGS}"
+
+${CC} ${CFLAGS} laplace_omp_parallel.c -o laplace_p.out -lm || exit 1
+
+# Arrays of plate sizes, thread counts and relaxation modes to test
+sizes=(200 1000)
+thread_counts=(1 8 32)
+omegas=(1.5 1.9 auto)
+
+# final omega, iterations and time from the solver's own output
+run() {
+    ./laplace_p.out --size=$1 --max-iterations=${max_itr} --omega=$2 |
+        awk '/Relaxation factor/ {w=$4} /Max error/ {itr=$5} /Total time/ {t=$4}
+             END {printf "%9.6f %8s %10s", w, itr, t}'
+}
+
+printf "%-8s %6s %8s %9s %8s %10s %8s %8s\n" "omega" "size" "threads" "final" "iters" "time(s)" "iter_x" "time_x" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for threads in "${thread_counts[@]}"
+    do
+        echo "Running ${size}x${size} with ${threads} threads..."
+        export OMP_NUM_THREADS=${threads}
+
+        gs=$(run ${size} 1)
+        printf "%-8s %6d %8d %s %8s %8s\n" "1" ${size} ${threads} "${gs}" "1.00" "1.00" >> ${output_file}
+        for omega in "${omegas[@]}"
+        do
+            sor=$(run ${size} ${omega})
+            ratios=$(echo "${gs} ${sor}" | awk '{printf "%8.2f %8.2f", $2/$5, $3/$6}')
+            printf "%-8s %6d %8d %s %s\n" ${omega} ${size} ${threads} "${sor}" "${ratios}" >> ${output_file}
+        done
+        echo "----------------------------------------" >> ${output_file}
+
+        # Add a small delay between runs
+        sleep 1
+    done
+done
+echo "SOR benchmark complete. Results saved in ${output_file}"
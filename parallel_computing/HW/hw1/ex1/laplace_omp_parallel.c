@@ -30,36 +30,117 @@
  * - Optimal for modern CPUs
 *************************************************/
 
+/*************************************************
+ * Successive over-relaxation (SOR)
+ *
+ *   ./laplace_p.out [--omega=W | --omega=auto]
+ *
+ * Each point moves omega times its Gauss-Seidel correction:
+ * T += omega * (avg(neighbours) - T). omega = 1 is the plain red-black
+ * Gauss-Seidel above (the default); 1 < omega < 2 over-relaxes.
+ * dt is still the Gauss-Seidel correction |avg - T|, so a larger omega
+ * does not loosen the stop test.
+ *
+ * --omega=auto starts at 1 and, every SOR_WINDOW iterations, turns the
+ * observed decay rate lambda of the correction norm into an estimate
+ * of the Jacobi spectral radius, rho = (lambda + omega - 1) /
+ * (omega sqrt(lambda)), and moves to omega = 2 / (1 + sqrt(1 - rho^2)).
+ * No spectral radius has to be known up front. The 2-norm is used
+ * because the max-norm dt jumps around as the hot spot moves, and a
+ * rate is only trusted once two windows in a row agree (SOR_STEADY),
+ * since every change of omega sets off a transient. omega only ever
+ * grows: too small just converges slower, too large diverges.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+/*************************************************
+ * Split red/black layout
+ *
+ *   ./laplace_p.out --layout=split
+ *
+ * In the interleaved grid above each colour sweep runs at stride 2, so
+ * half of every cache line and vector lane is the other colour. The
+ * split layout keeps two compacted grids, one per colour: cell (i,j)
+ * lives in row i of its colour's grid at column j/2. A cell's vertical
+ * neighbours are then at the same column of the other grid and its
+ * left/right neighbours at two adjacent columns, so both sweeps are
+ * unit-stride loops over 64-byte aligned rows. The plate is packed
+ * after initialize() and unpacked for track_progress() and at the end;
+ * the sweep does the same additions in the same order, so temperatures
+ * and iteration counts match the interleaved layout exactly.
+ *
+ * Both layouts take the dt maximum with a compare and select rather
+ * than fmax(): fmax has to honour NaN operands, which keeps gcc from
+ * vectorizing the reduction and costs far more than the stride does.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+/*************************************************
+ * Counters and roofline
+ *
+ *   ./laplace_p.out --perf [--stream-mb=N] [--layout=split]
+ *
+ * Brackets the red and the black sweep with the hardware counters of
+ * common/laplace_perf.h and prints each against the STREAM and
+ * multiply-add roofs. Per updated cell both layouts do ~9 flops
+ * (average, correction, relaxation, norm, max). The interleaved
+ * sweep streams the whole grid in and out for half of its cells, 32
+ * bytes per update; the split sweep reads and writes its own colour
+ * and reads the other, 24 bytes.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
 
 #include <omp.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
 #include <sys/time.h>
-
-// size of plate
-#define COLUMNS    1000
-#define ROWS       1000
-
-// largest permitted change in temp (This value takes about 3400 steps)
-#define MAX_TEMP_ERROR 0.01
-
-double Temperature[ROWS+2][COLUMNS+2] __attribute__((aligned(64))); //dynamic memory allocation with 64-byte
-//double Temperature_last[ROWS+2][COLUMNS+2]; // temperature grid from last iteration
+#include "../../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
+#include "../../../common/laplace_perf.h"
 
 //   helper routines
-void initialize();
-void track_progress(int iter);
+void initialize(double (*Temperature)[COLUMNS+2]);
+void track_progress(int iter, double (*Temperature)[COLUMNS+2]);
+int64_t split_width(void);
+void split_pack(double (*Temperature)[COLUMNS+2], double *red, double *black, int64_t width);
+void split_unpack(double (*Temperature)[COLUMNS+2], const double *red, const double *black, int64_t width);
+void split_sweep(double *restrict dst, const double *restrict src, int colour, int64_t width,
+                 double omega, double *dt, double *norm);
 
 #define MAX_THREADS 32
+#define SOR_WINDOW 20          // iterations between auto omega updates
+#define SOR_STEADY 0.5         // consecutive rates must agree this well, relative to 1 - rate
+#define SOR_MAX_OMEGA 1.999    // stay clear of omega = 2, where SOR stops converging
 
 int main(int argc, char *argv[]) {
 
-    int i, j;                                            // grid indexes
+    int64_t i, j;                                        // grid indexes
     int max_iterations;                                  // number of iterations
     int iteration=1;                                     // current iteration
     double dt=100;                                       // largest change in t
     struct timeval start_time, stop_time, elapsed_time;  // timers
+    double omega = 1.0;                                  // relaxation factor, 1 = Gauss-Seidel
+    int auto_omega = 0;                                  // estimate omega while running
+    int omega_given = 0;                                 // --omega on the command line
+    double norm = 0.0;                                   // sum of squared corrections this iteration
+    double window_norm = 0.0;                            // norm at the start of the current SOR window
+    double last_lambda = 0.0;                            // decay rate measured over the previous window
+    int split = 0;                                       // red and black cells in separate grids
+    int64_t width = 0;                                   // row length of each split grid
+    double *Red = NULL, *Black = NULL;                   // split grids
+    int perf_report = 0;                                 // --perf: counters and roofline
+    double stream_mb = 0;                                // STREAM array size, 0 = from the LLC
+    laplace_perf perf;
+    int perf_red = 0, perf_black = 0;                    // its kernel phases
+    const char *v;
+    int arg;
 
     // Set number of threads at runtime
     int num_threads = MAX_THREADS;
@@ -69,11 +150,56 @@ int main(int argc, char *argv[]) {
     omp_set_num_threads(num_threads);
     printf("Running with %d OpenMP threads\n", num_threads);
 
-    printf("Maximum iterations [100-4000]?\n");
-    scanf("%d", &max_iterations);
+    max_iterations = laplace_parse_args(argc, argv);
+    for (arg = 1; arg < argc; arg++) {
+        if ((v = laplace_arg_value(argv[arg], "--omega"))) {
+            omega_given = 1;
+            if (strcmp(v, "auto") == 0) {
+                auto_omega = 1;
+            } else {
+                omega = atof(v);
+                if (omega <= 0.0 || omega >= 2.0) {
+                    fprintf(stderr, "--omega must be in (0, 2) or 'auto', got '%s'\n", v);
+                    exit(1);
+                }
+            }
+        } else if ((v = laplace_arg_value(argv[arg], "--layout"))) {
+            if (strcmp(v, "split") == 0) split = 1;
+            else if (strcmp(v, "interleaved") != 0) {
+                fprintf(stderr, "Unknown layout '%s' (interleaved, split)\n", v);
+                exit(1);
+            }
+        } else if (strcmp(argv[arg], "--perf") == 0) {
+            perf_report = 1;
+        } else if ((v = laplace_arg_value(argv[arg], "--stream-mb"))) {
+            stream_mb = (double)laplace_parse_size(v, "--stream-mb");
+        }
+    }
+    if (max_iterations < 0) {
+        printf("Maximum iterations [100-4000]?\n");
+        scanf("%d", &max_iterations);
+    }
+
+    // probe the machine before the grid takes its memory
+    if (perf_report) {
+        laplace_perf_open(&perf, stream_mb);
+        perf_red   = laplace_perf_kernel_add(&perf, split ? "red_split" : "red", 9, split ? 24 : 32);
+        perf_black = laplace_perf_kernel_add(&perf, split ? "black_split" : "black", 9, split ? 24 : 32);
+    }
+
+    // single grid, 64-byte aligned for the simd loops; declared after parsing
+    // because the row type depends on COLUMNS
+    double (*Temperature)[COLUMNS+2] = laplace_alloc_aligned_grid(ROWS, COLUMNS);
 
     gettimeofday(&start_time,NULL); // Unix timer
-    initialize();                   // initialize Temp_last including boundary conditions
+    initialize(Temperature);        // initialize Temp_last including boundary conditions
+
+    if (split) {
+        width = split_width();
+        Red   = laplace_alloc_aligned_grid(ROWS, width - 2);
+        Black = laplace_alloc_aligned_grid(ROWS, width - 2);
+        split_pack(Temperature, Red, Black, width);
+    }
 
     // do until error is minimal or until max steps
     while ( dt > MAX_TEMP_ERROR && iteration <= max_iterations ) {
@@ -81,60 +207,116 @@ int main(int argc, char *argv[]) {
         dt=0.0; // reset largest temperature change
 
         // Process RED squares (checkerboard pattern)
-        double red_dt=0.0;
-        // main calculation: average my four neighbors
-        #pragma omp parallel for reduction(max:red_dt) private(i,j) schedule(static)
-        for(i = 1; i <= ROWS; i++) {
-            // SIMD
-            #pragma omp simd aligned(Temperature:64) reduction(max:red_dt)
-            for(j = 1 + (i % 2); j <= COLUMNS; j += 2) {
-                double old_temp = Temperature[i][j];
-                
-                Temperature[i][j] = 0.25 * (Temperature[i+1][j] + Temperature[i-1][j] +
-                                            Temperature[i][j+1] + Temperature[i][j-1]);
-                red_dt = fmax(fabs(Temperature[i][j] - old_temp), red_dt);
+        double red_dt=0.0, red_norm=0.0;
+        double black_dt = 0.0, black_norm = 0.0;
+        if (split) {
+            if (perf_report) laplace_perf_begin(&perf, perf_red);
+            split_sweep(Red, Black, 0, width, omega, &red_dt, &red_norm);
+            if (perf_report) {
+                laplace_perf_end(&perf, perf_red, ROWS * COLUMNS / 2.0);
+                laplace_perf_begin(&perf, perf_black);
             }
-        }
+            split_sweep(Black, Red, 1, width, omega, &black_dt, &black_norm);
+            if (perf_report) laplace_perf_end(&perf, perf_black, ROWS * COLUMNS / 2.0);
+        } else {
+            // main calculation: average my four neighbors
+            if (perf_report) laplace_perf_begin(&perf, perf_red);
+            #pragma omp parallel for reduction(max:red_dt) reduction(+:red_norm) private(i,j) schedule(static)
+            for(i = 1; i <= ROWS; i++) {
+                // SIMD
+                #pragma omp simd aligned(Temperature:64) reduction(max:red_dt) reduction(+:red_norm)
+                for(j = 1 + (i % 2); j <= COLUMNS; j += 2) {
+                    double old_temp = Temperature[i][j];
+                    double gs_temp = 0.25 * (Temperature[i+1][j] + Temperature[i-1][j] +
+                                             Temperature[i][j+1] + Temperature[i][j-1]);
+                    double change = fabs(gs_temp - old_temp);
+
+                    Temperature[i][j] = old_temp + omega * (gs_temp - old_temp);
+                    red_dt = (change > red_dt) ? change : red_dt;
+                    red_norm += (gs_temp - old_temp) * (gs_temp - old_temp);
+                }
+            }
+            if (perf_report) laplace_perf_end(&perf, perf_red, ROWS * COLUMNS / 2.0);
         
-        // BLACK squares
-        double black_dt = 0.0;
-        // copy grid to old grid for next iteration and find latest dt
-        #pragma omp parallel for reduction(max:black_dt) private(i,j) schedule(static)
-        for(i = 1; i <= ROWS; i++){
-            #pragma omp simd aligned(Temperature:64) reduction(max:black_dt)
-            for(j = 1 + ((i + 1) % 2); j <= COLUMNS; j += 2){
-                double old_temp = Temperature[i][j];
-                Temperature[i][j] = 0.25 * (Temperature[i+1][j] + Temperature[i-1][j] +
-                                           Temperature[i][j+1] + Temperature[i][j-1]);
-                black_dt = fmax( fabs(Temperature[i][j]-old_temp), black_dt);
+            // BLACK squares
+            // copy grid to old grid for next iteration and find latest dt
+            if (perf_report) laplace_perf_begin(&perf, perf_black);
+            #pragma omp parallel for reduction(max:black_dt) reduction(+:black_norm) private(i,j) schedule(static)
+            for(i = 1; i <= ROWS; i++){
+                #pragma omp simd aligned(Temperature:64) reduction(max:black_dt) reduction(+:black_norm)
+                for(j = 1 + ((i + 1) % 2); j <= COLUMNS; j += 2){
+                    double old_temp = Temperature[i][j];
+                    double gs_temp = 0.25 * (Temperature[i+1][j] + Temperature[i-1][j] +
+                                             Temperature[i][j+1] + Temperature[i][j-1]);
+                    double change = fabs(gs_temp - old_temp);
 
+                    Temperature[i][j] = old_temp + omega * (gs_temp - old_temp);
+                    black_dt = (change > black_dt) ? change : black_dt;
+                    black_norm += (gs_temp - old_temp) * (gs_temp - old_temp);
+                }
             }
+            if (perf_report) laplace_perf_end(&perf, perf_black, ROWS * COLUMNS / 2.0);
         }
         dt = fmax(red_dt, black_dt);
+        norm = red_norm + black_norm;
+
+        // auto omega: estimate the Jacobi spectral radius from the decay of the
+        // correction norm over the last window and over-relax accordingly
+        if (auto_omega && (iteration % SOR_WINDOW) == 0) {
+            double measured = window_norm;
+            double lambda = (measured > 0.0) ? pow(norm / measured, 0.5 / SOR_WINDOW) : 0.0;
+            int steady = (lambda > 0.0 && lambda < 1.0 && fabs(lambda - last_lambda) < SOR_STEADY * (1.0 - lambda));
+            window_norm = norm;
+            last_lambda = lambda;
+            if (steady) {
+                double rho = (lambda + omega - 1.0) / (omega * sqrt(lambda));
+                if (rho < 1.0) {
+                    double next = fmin(2.0 / (1.0 + sqrt(1.0 - rho * rho)), SOR_MAX_OMEGA);
+                    // a new omega kicks the corrections up for a while, so
+                    // skip a window before measuring again
+                    if (next > omega) {
+                        omega = next;
+                        window_norm = 0.0;
+                        last_lambda = 0.0;
+                    }
+                }
+            }
+        }
 
 
         // periodically print test values
         if((iteration % 100) == 0) {
- 	        track_progress(iteration);
+            if (split) split_unpack(Temperature, Red, Black, width);
+ 	        track_progress(iteration, Temperature);
         }
 
 	    iteration++;
     }
 
+    if (split) {
+        split_unpack(Temperature, Red, Black, width);
+        free(Red);
+        free(Black);
+    }
+
     gettimeofday(&stop_time,NULL);
     timersub(&stop_time, &start_time, &elapsed_time); // Unix time subtract routine
 
+    // plain Gauss-Seidel runs keep their old output
+    if (omega_given) printf("\nRelaxation factor omega %f%s", omega, auto_omega ? " (auto)" : "");
     printf("\nMax error at iteration %d was %f\n", iteration-1, dt);
     printf("Total time was %f seconds.\n", elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0);
+    if (perf_report) laplace_perf_report(&perf);
 
+    free(Temperature);
     return 0;
 }
 
 // initialize plate and boundary conditions
 // Temp_last is used to to start first iteration
-void initialize(){
+void initialize(double (*Temperature)[COLUMNS+2]){
 
-    int i,j;
+    int64_t i,j;
 
     #pragma omp parallel for private(i,j)
     for(i = 0; i <= ROWS+1; i++){
@@ -162,13 +344,85 @@ void initialize(){
 }
 
 // print diagonal in bottom right corner where most action is
-void track_progress(int iteration) {
+void track_progress(int iteration, double (*Temperature)[COLUMNS+2]) {
 
-    int i;
+    int64_t i;
 
     printf("---------- Iteration number: %d ------------\n", iteration);
-    for(i = ROWS-5; i <= ROWS; i++) {
-        printf("[%d,%d]: %5.2f  ", i, i, Temperature[i][i]);
+    for(i = laplace_progress_reach(ROWS, COLUMNS); i >= 0; i--) {
+        printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", ROWS-i, COLUMNS-i, Temperature[ROWS-i][COLUMNS-i]);
     }
     printf("\n");
-}
\ No newline at end of file
+}
+
+
+// split layout row length: j/2 for j = 0..COLUMNS+1, padded to whole cache lines
+int64_t split_width(void) {
+    return ((COLUMNS + 1) / 2 + 1 + 7) & ~(int64_t)7;
+}
+
+
+// colour 0 (red, swept first) holds the cells with i+j odd, colour 1 (black) i+j even
+void split_pack(double (*Temperature)[COLUMNS+2], double *red, double *black, int64_t width) {
+
+    int64_t i, j;
+
+    #pragma omp parallel for private(i,j) schedule(static)
+    for(i = 0; i <= ROWS+1; i++) {
+        for(j = 0; j <= COLUMNS+1; j++) {
+            double *colour = ((i + j) % 2) ? red : black;
+            colour[i*width + j/2] = Temperature[i][j];
+        }
+    }
+}
+
+
+void split_unpack(double (*Temperature)[COLUMNS+2], const double *red, const double *black, int64_t width) {
+
+    int64_t i, j;
+
+    #pragma omp parallel for private(i,j) schedule(static)
+    for(i = 0; i <= ROWS+1; i++) {
+        for(j = 0; j <= COLUMNS+1; j++) {
+            const double *colour = ((i + j) % 2) ? red : black;
+            Temperature[i][j] = colour[i*width + j/2];
+        }
+    }
+}
+
+
+// one colour of the red-black sweep on the split grids: dst is the colour
+// being updated, src the other one
+void split_sweep(double *restrict dst, const double *restrict src, int colour, int64_t width,
+                 double omega, double *dt, double *norm) {
+
+    int64_t i, k;
+    double colour_dt = 0.0, colour_norm = 0.0;
+
+    #pragma omp parallel for reduction(max:colour_dt) reduction(+:colour_norm) private(i,k) schedule(static)
+    for(i = 1; i <= ROWS; i++) {
+        // first and last interior column of this colour in row i; odd j has
+        // its left/right neighbours at k and k+1, even j at k-1 and k
+        const int64_t jfirst = 1 + ((i + colour) % 2);
+        const int64_t jlast = COLUMNS - ((COLUMNS - jfirst) % 2);
+        double *restrict row = dst + i*width;
+        const double *restrict up    = src + (i-1)*width;
+        const double *restrict down  = src + (i+1)*width;
+        const double *restrict left  = src + i*width - (jfirst % 2 ? 0 : 1);
+        const double *restrict right = src + i*width + (jfirst % 2 ? 1 : 0);
+
+        #pragma omp simd reduction(max:colour_dt) reduction(+:colour_norm)
+        for(k = jfirst / 2; k <= jlast / 2; k++) {
+            double old_temp = row[k];
+            double gs_temp = 0.25 * (down[k] + up[k] + right[k] + left[k]);
+            double change = fabs(gs_temp - old_temp);
+
+            row[k] = old_temp + omega * (gs_temp - old_temp);
+            colour_dt = (change > colour_dt) ? change : colour_dt;
+            colour_norm += (gs_temp - old_temp) * (gs_temp - old_temp);
+        }
+    }
+
+    *dt = colour_dt;
+    *norm = colour_norm;
+}
@@ -1,8 +1,11 @@
 # include <stdlib.h>
 # include <stdio.h>
+# include <string.h>
 # include <omp.h>
 # include <math.h>
 
+#include "../../common/bench_phases.h"   // --bench: in-process timing
+
 #define MAX_THREADS 32
 
 /*
@@ -16,6 +19,7 @@ int main ( int argc, char *argv[] ){
   int n = 500000;
   int not_primes=0; // global_shared_variables
   int i,j;
+  bench_phases bench;
   
   // Set number of threads at runtime
   int num_threads = MAX_THREADS;
@@ -25,6 +29,7 @@ int main ( int argc, char *argv[] ){
   omp_set_num_threads(num_threads);
   printf("Running with %d OpenMP threads\n", num_threads);
 
+  bench_start(&bench);
   #pragma omp parallel for private(i,j) reduction(+:not_primes)
   for ( i = 2; i <= n; i++ ){
     if (i == 2) continue;
@@ -38,5 +43,11 @@ int main ( int argc, char *argv[] ){
       }
     }
   }
+  bench_lap(&bench, BENCH_COMPUTE);
+
   printf("Primes: %d\n", n - not_primes);
+  bench_lap(&bench, BENCH_OUTPUT);
+
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+    bench_report(bench.seconds, bench_total(&bench), n - 1, bench_peak_rss(), num_threads);
 }
\ No newline at end of file
@@ -1,12 +1,16 @@
 # include <stdlib.h>
 # include <stdio.h>
+# include <string.h>
+#include "../../common/bench_phases.h"   // --bench: in-process timing
 
 int main ( int argc, char *argv[] ){
 
   int n = 500000;
   int not_primes=0;
   int i,j;
+  bench_phases bench;
 
+  bench_start(&bench);
   for ( i = 2; i <= n; i++ ){
     for ( j = 2; j < i; j++ ){
       if ( i % j == 0 ){
@@ -16,7 +20,13 @@ int main ( int argc, char *argv[] ){
     }
   }
 
+  bench_lap(&bench, BENCH_COMPUTE);
+
   printf("Primes: %d\n", n - not_primes);
+  bench_lap(&bench, BENCH_OUTPUT);
+
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+    bench_report(bench.seconds, bench_total(&bench), n - 1, bench_peak_rss(), 1);
 
 }
 
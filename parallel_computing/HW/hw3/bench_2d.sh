@@ -0,0 +1,72 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: 1-D row slabs vs 2-D Cartesian blocks
+# Objective:
+#   1. run hw3_laplace_mpi_3.c (row slabs) and laplace_mpi_2d_optimized.c
+#      (P x Q blocks, process grid picked from the plate shape) for a
+#      fixed iteration count over growing PE counts
+#   2. report time, speedup and efficiency against 1 PE, and the halo
+#      cells the busiest PE receives per iteration in each layout
+#   3. check both stop on the same iteration for a full 1000x1000 solve
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_2d_result.txt"
+bench_itr=${BENCH_ITR:-500}
+
+# compiler: mpicc by default
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${MPICC} ${MPIFLAGS}"
+
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_3.c -o laplace_1d.out -lm || exit 1
+${MPICC} ${MPIFLAGS} laplace_mpi_2d_optimized.c -o laplace_2d.out -lm || exit 1
+
+# Arrays of plate sizes and PE counts to test
+sizes=(1000 4000)
+pe_counts=(1 4 8 16 32 64)
+
+# pull the solver's own timer out of its output
+solver_time() {
+    grep -E "Total time" | sed -r 's/[^0-9.]*([0-9.]+).*/\1/'
+}
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN!!!!" >> ${output_file}
+printf "%-6s %6s %5s %6s %10s %8s %8s %10s\n" "layout" "size" "PEs" "grid" "time(s)" "speedup" "effic" "halo/PE" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    base_1d=""
+    base_2d=""
+    for pe in "${pe_counts[@]}"
+    do
+        echo "Running ${size}x${size} on ${pe} PEs..."
+        out=$(${MPIRUN} -n ${pe} ./laplace_2d.out --size=${size} --max-temp-error=0 --max-iterations=${bench_itr})
+        t2=$(echo "${out}" | solver_time)
+        grid=$(echo "${out}" | awk '/Process grid/ {print $3}')
+        halo_2d=$(echo "${out}" | awk '/Halo cells/ {print $7}')
+        halo_1d=$(echo "${out}" | awk '/Halo cells/ {print $10}' | tr -d ')')
+        t1=$(${MPIRUN} -n ${pe} ./laplace_1d.out --size=${size} --max-temp-error=0 --max-iterations=${bench_itr} | solver_time)
+        if [ -z "${base_1d}" ]; then base_1d=${t1}; base_2d=${t2}; fi
+        echo "${base_1d} ${t1} ${pe}" | awk -v s=${size} -v h=${halo_1d} \
+            '{printf "%-6s %6d %5d %6s %10s %8.2f %8.2f %10s\n", "1-D", s, $3, $3"x1", $2, $1/$2, $1/$2/$3, h}' >> ${output_file}
+        echo "${base_2d} ${t2} ${pe}" | awk -v s=${size} -v h=${halo_2d} -v g=${grid} \
+            '{printf "%-6s %6d %5d %6s %10s %8.2f %8.2f %10s\n", "2-D", s, $3, g, $2, $1/$2, $1/$2/$3, h}' >> ${output_file}
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+
+echo "!!!!FULL SOLVE, 1000x1000, 4 PEs!!!!" >> ${output_file}
+echo "=== 1-D ===" >> ${output_file}
+${MPIRUN} -n 4 ./laplace_1d.out --size=1000 --max-iterations=4000 | tail -3 >> ${output_file}
+echo "=== 2-D ===" >> ${output_file}
+${MPIRUN} -n 4 ./laplace_2d.out --size=1000 --max-iterations=4000 | tail -4 >> ${output_file}
+echo "2-D decomposition benchmark complete. Results saved in ${output_file}"
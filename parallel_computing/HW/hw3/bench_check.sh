@@ -0,0 +1,68 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: convergence-check interval and pipelined dt reduction
+# Objective:
+#   1. solve to convergence with hw3_laplace_mpi_3.c checking dt every
+#      iteration (the default), every N iterations, adaptively
+#      (--check-every=auto) and with the Allreduce pipelined
+#      (--check-lag=L, MPI_Iallreduce read L iterations later)
+#   2. report the iteration each run stops on, the iterations it
+#      actually ran, the number of checks and the speedup over the
+#      default; the stop iteration must stay within the check interval
+#   3. the saving grows with the PE count, where the Allreduce latency
+#      is a floor on every iteration
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_check_result.txt"
+max_itr=${MAX_ITR:-20000}
+
+# compiler: mpicc by default
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${MPICC} ${MPIFLAGS}"
+
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_3.c -o laplace_mpi.out -lm || exit 1
+
+# Arrays of plate sizes, PE counts and check policies to test
+sizes=(500 2000)
+pe_counts=(8 32 128)
+policies=("--check-every=1" "--check-every=10" "--check-every=auto"
+          "--check-lag=2" "--check-every=auto --check-lag=2")
+
+# stop iteration, iterations run, checks and total seconds from the solver's output
+run() {
+    ${MPIRUN} -n $1 ./laplace_mpi.out --size=$2 --max-iterations=${max_itr} $3 |
+        awk '/Max error at iteration/ {s=$5} /Total time/ {t=$4}
+             /Convergence checks/ {c=$3; r=$NF}
+             END {printf "%8s %8s %8s %10s", s, r, c, t}'
+}
+
+echo "!!!!RUN TO CONVERGENCE, AT MOST ${max_itr} ITERATIONS!!!!" >> ${output_file}
+printf "%-34s %6s %5s %8s %8s %8s %10s %8s\n" "policy" "size" "PEs" "stop" "run" "checks" "time(s)" "speedup" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for pe in "${pe_counts[@]}"
+    do
+        echo "Running ${size}x${size} on ${pe} PEs..."
+        base=""
+        for policy in "${policies[@]}"
+        do
+            result=$(run ${pe} ${size} "${policy}")
+            [ -z "${base}" ] && base=$(echo "${result}" | awk '{print $4}')
+            speedup=$(echo "${base} ${result}" | awk '{printf "%.2f", $1/$5}')
+            printf "%-34s %6d %5d %s %8s\n" "${policy}" ${size} ${pe} "${result}" ${speedup} >> ${output_file}
+        done
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+echo "Convergence-check benchmark complete. Results saved in ${output_file}"
@@ -0,0 +1,78 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: MPI-IO checkpoint bandwidth and overhead
+# Objective:
+#   1. run hw3_laplace_mpi_3.c for a fixed iteration count with and
+#      without --checkpoint (MPI_File_write_at_all, one shared file)
+#   2. report the solver's checkpoint GB/s, seconds per checkpoint and
+#      the share of the run spent writing them, raw and through the
+#      lossless codec (--checkpoint-codec=xor, GB/s in raw cells)
+#   3. restart the last checkpoint on a different PE count and check
+#      the restarted run stops on the same iteration as a cold one
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_checkpoint_result.txt"
+bench_itr=${BENCH_ITR:-1000}
+checkpoint_every=${CHECKPOINT_EVERY:-250}
+checkpoint_file=${CHECKPOINT_FILE:-"laplace_checkpoint.bin"}
+
+# compiler: mpicc by default
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "Compiler: ${MPICC} ${MPIFLAGS}" \
+    "Checkpoint file: ${checkpoint_file}"
+
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_3.c -o laplace_mpi.out -lm || exit 1
+
+# Arrays of plate sizes and PE counts to test
+sizes=(2000 8000 16000)
+pe_counts=(8 32 128)
+
+# total seconds, and checkpoint seconds each, GB/s and % of the run
+run() {
+    ${MPIRUN} -n $1 ./laplace_mpi.out --size=$2 --max-temp-error=0 --max-iterations=${bench_itr} $3 |
+        awk '/Total time/ {t=$4} /^Checkpoints:/ {s=$5; g=$8; p=$10}
+             END {printf "%10s %10s %8s %8s", t, s ? s : "-", g ? g : "-", p ? p : "-"}'
+}
+
+# the iteration a run stops on
+stop() {
+    ${MPIRUN} -n $1 ./laplace_mpi.out --size=$2 --max-iterations=$3 $4 |
+        awk '/Max error at iteration/ {print $5}'
+}
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN, A CHECKPOINT EVERY ${checkpoint_every}!!!!" >> ${output_file}
+printf "%-6s %6s %5s %10s %10s %8s %8s\n" "ckpt" "size" "PEs" "time(s)" "s/ckpt" "GB/s" "ckpt_%" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for pe in "${pe_counts[@]}"
+    do
+        echo "Running ${size}x${size} on ${pe} PEs..."
+        printf "%-6s %6d %5d %s\n" "off" ${size} ${pe} "$(run ${pe} ${size})" >> ${output_file}
+        printf "%-6s %6d %5d %s\n" "on" ${size} ${pe} \
+            "$(run ${pe} ${size} "--checkpoint=${checkpoint_file} --checkpoint-every=${checkpoint_every}")" >> ${output_file}
+        printf "%-6s %6d %5d %s\n" "xor" ${size} ${pe} \
+            "$(run ${pe} ${size} "--checkpoint=${checkpoint_file} --checkpoint-every=${checkpoint_every} --checkpoint-codec=xor")" >> ${output_file}
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+
+# restart on another PE count must finish where a cold run does
+echo "=== Restart on a different PE count (500x500) ===" >> ${output_file}
+cold=$(stop 8 500 20000)
+stop 8 500 1000 "--checkpoint=${checkpoint_file} --checkpoint-every=1000" > /dev/null
+warm=$(stop 3 500 20000 "--restart=${checkpoint_file}")
+echo "cold run on 8 PEs stops at ${cold}; 8 PEs to iteration 1000, restarted on 3 PEs, stops at ${warm}" >> ${output_file}
+rm -f ${checkpoint_file}
+echo "Checkpoint benchmark complete. Results saved in ${output_file}"
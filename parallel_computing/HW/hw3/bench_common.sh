@@ -0,0 +1,28 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: helpers shared by the bench_*.sh scripts
+# Usage: source it from a bench script, e.g.
+#   source "$(dirname "$0")/../../HW/hw3/bench_common.sh"
+#   bench_system_info ${output_file} "Compiler: ${CC} ${CFLAGS}"
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+
+# bench_system_info FILE [LINE...]
+# start FILE afresh with the system info block; each LINE (compiler,
+# threads, ...) is added after the CPU model
+bench_system_info() {
+    local file=$1 line
+    shift
+    echo "=== Basic System Info ===" > ${file}
+    echo "Date: $(date)" >> ${file}
+    echo "System: $(uname -a)" >> ${file}
+    echo "CPU Info: $(lscpu | grep 'Model name' | sed -r 's/Model name:\s{1,}//g')" >> ${file}
+    for line in "$@"
+    do
+        echo "${line}" >> ${file}
+    done
+    echo "=========================" >> ${file}
+}
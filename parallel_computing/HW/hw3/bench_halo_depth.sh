@@ -0,0 +1,72 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: deep-halo exchange, halo depth k vs rank count
+# Objective:
+#   1. run hw3_laplace_mpi_3.c with --halo-depth=k for a fixed
+#      iteration count over several k and PE counts; small plates
+#      make each PE's slab thin, where message latency dominates
+#   2. report time, speedup over k=1, and messages and Allreduces per
+#      PE per 100 iterations
+#   3. check every k stops on the same iteration as k=1
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_halo_depth_result.txt"
+bench_itr=${BENCH_ITR:-1000}
+max_itr=${MAX_ITR:-100000}
+
+# compiler: mpicc by default
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${MPICC} ${MPIFLAGS}"
+
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_3.c -o laplace_mpi.out -lm || exit 1
+
+# Arrays of plate sizes, PE counts and halo depths to test
+sizes=(512 2048)
+pe_counts=(4 16 64)
+depths=(1 2 4 8 16)
+
+# pull the solver's own timer out of its output
+solver_time() {
+    grep -E "Total time" | sed -r 's/[^0-9.]*([0-9.]+).*/\1/'
+}
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN!!!!" >> ${output_file}
+printf "%6s %5s %6s %10s %8s %12s %12s\n" "size" "PEs" "depth" "time(s)" "speedup" "msgs/100itr" "reduce/100" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for pe in "${pe_counts[@]}"
+    do
+        echo "Running ${size}x${size} on ${pe} PEs..."
+        base=""
+        for k in "${depths[@]}"
+        do
+            t=$(${MPIRUN} -n ${pe} ./laplace_mpi.out --size=${size} --max-temp-error=0 \
+                --max-iterations=${bench_itr} --halo-depth=${k} | solver_time)
+            if [ -z "${base}" ]; then base=${t}; fi
+            # an interior PE sends and receives 2 messages per exchange; blocks
+            # also end on every 100th iteration
+            echo "${base} ${t} ${k}" | awk -v s=${size} -v p=${pe} \
+                '{b = int((100 + $3 - 1) / $3); printf "%6d %5d %6d %10s %8.2f %12d %12d\n", s, p, $3, $2, $1/$2, 4*b, ($3 == 1 ? 100 : b)}' >> ${output_file}
+        done
+        echo "----------------------------------------" >> ${output_file}
+    done
+done
+
+echo "!!!!FULL SOLVE, 1000x1000, 4 PEs!!!!" >> ${output_file}
+for k in "${depths[@]}"
+do
+    echo "=== depth ${k} ===" >> ${output_file}
+    ${MPIRUN} -n 4 ./laplace_mpi.out --size=1000 --max-iterations=${max_itr} --halo-depth=${k} | tail -3 | head -2 >> ${output_file}
+done
+echo "Halo depth benchmark complete. Results saved in ${output_file}"
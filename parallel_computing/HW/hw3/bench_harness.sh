@@ -0,0 +1,129 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: benchmark harness for the Laplace and prime binaries
+# Objective:
+#   1. replace `time echo 4000 | ./x.o` (process startup, MPI launch
+#      and the terminal included, one run) with the programs' own
+#      --bench phase timers: init, compute, halo, reduction, output
+#   2. per configuration: WARMUP discarded runs, then REPEATS runs;
+#      report the median total, min/max and spread, median phases,
+#      cell updates (numbers tested for prime) per second, peak RSS
+#   3. write every configuration to a CSV in the
+#      mpi_performance_analysis.csv schema that laplace.ipynb plots,
+#      speedup and efficiency against the same implementation on 1
+#      process/thread
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output files; CSV_FILE=mpi_performance_analysis.csv feeds the notebook
+output_file="bench_harness_result.txt"
+csv_file=${CSV_FILE:-"bench_harness.csv"}
+repeats=${REPEATS:-5}
+warmup=${WARMUP:-1}
+size=${SIZE:-1000}
+max_itr=${MAX_ITR:-4000}
+tolerance=${MAX_TEMP_ERROR:-0.01}
+prime_n=500000                      # n in the prime sources
+
+# compilers: gcc and mpicc by default
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp -pthread"}
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "Compiler: ${CC} ${CFLAGS}; ${MPICC} ${MPIFLAGS}" \
+    "Runs: ${warmup} warmup + ${repeats} timed per configuration"
+
+${CC} ${CFLAGS} ../../Exercises/OpenMP/laplace_omp.c -o laplace_omp.out -lm || exit 1
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_3.c -o laplace_mpi.out -lm || exit 1
+${CC} ${CFLAGS} ../hw2/prime_serial.c -o prime_serial.out -lm || exit 1
+${CC} ${CFLAGS} ../hw2/prime_parallel_norace_4.c -o prime_parallel.out -lm || exit 1
+
+# Arrays of process and thread counts to test
+pe_counts=(1 2 4 8)
+thread_counts=(1 2 4 8)
+
+runs_file=$(mktemp)
+summary_file=$(mktemp)
+
+# measure IMPLEMENTATION PROCESSES ITERATIONS COMMAND...
+# ITERATIONS is "laplace" to read them from the run, or a fixed count
+measure() {
+    local impl=$1 procs=$2 itr=$3 r
+    shift 3
+    > ${runs_file}
+    for (( r = 0; r < warmup + repeats; r++ ))
+    do
+        "$@" --bench | awk -v keep=$(( r >= warmup )) -v itr=${itr} '
+            /Max error at iteration/ {itr = $5; err = $7}
+            /^Bench:/ {gsub(",", ""); b = $3 " " $5 " " $7 " " $9 " " $11 " " $13 " " $15 " " $19}
+            END {if (keep && b != "") print itr, (err == "" ? "-" : err), b}' >> ${runs_file}
+    done
+    # fields: iterations error init compute halo reduction output total updates/s rss_KB
+    sort -g -k8 ${runs_file} | awk -v impl="${impl}" -v p=${procs} -v tol=${tolerance} \
+        -v out=${output_file} -v summary=${summary_file} '
+        {n++; t[n] = $8; itr = $1; err = $2; rss = ($10 > rss) ? $10 : rss
+         for (k = 3; k <= 7; k++) phase[k, n] = $k; ups[n] = $9}
+        function median(a, m,   v, i, j, x) {
+            for (i = 1; i <= m; i++) v[i] = a[i]
+            for (i = 2; i <= m; i++) for (j = i; j > 1 && v[j-1] > v[j]; j--) {x = v[j]; v[j] = v[j-1]; v[j-1] = x}
+            return (m % 2) ? v[(m+1)/2] : (v[m/2] + v[m/2+1]) / 2
+        }
+        END {
+            if (n == 0) {printf "%-16s %5d  no runs\n", impl, p >> out; exit}
+            med = median(t, n)
+            for (k = 3; k <= 7; k++) {for (i = 1; i <= n; i++) col[i] = phase[k, i]; ph[k] = median(col, n)}
+            printf "%-16s %5d %10.4f %10.4f %10.4f %7.1f%% %9.4f %9.4f %9.4f %9.4f %9.4f %10.1f %9.1f\n",
+                impl, p, med, t[1], t[n], 100 * (t[n] - t[1]) / med,
+                ph[3], ph[4], ph[5], ph[6], ph[7], median(ups, n) / 1e6, rss / 1024 >> out
+            conv = (err == "-" || err <= tol) ? "True" : "False"
+            printf "%s\t%d\t%d\t%s\t%s\t%.6f\n", impl, p, itr, conv, (err == "-" ? "" : err), med >> summary
+        }'
+}
+
+printf "%-16s %5s %10s %10s %10s %8s %9s %9s %9s %9s %9s %10s %9s\n" "implementation" "procs" \
+    "median(s)" "min(s)" "max(s)" "spread" "init" "compute" "halo" "reduction" "output" "Mupdates/s" "RSS_MB" >> ${output_file}
+for threads in "${thread_counts[@]}"
+do
+    echo "Laplace OpenMP, ${threads} threads..."
+    OMP_NUM_THREADS=${threads} measure "Laplace OpenMP" ${threads} laplace \
+        ./laplace_omp.out --size=${size} --max-iterations=${max_itr}
+done
+for pe in "${pe_counts[@]}"
+do
+    echo "Laplace MPI, ${pe} PEs..."
+    measure "Laplace MPI" ${pe} laplace \
+        ${MPIRUN} -n ${pe} ./laplace_mpi.out --size=${size} --max-iterations=${max_itr}
+done
+echo "Prime serial..."
+measure "Prime serial" 1 $(( prime_n - 1 )) ./prime_serial.out
+for threads in "${thread_counts[@]}"
+do
+    echo "Prime OpenMP, ${threads} threads..."
+    OMP_NUM_THREADS=${threads} measure "Prime OpenMP" ${threads} $(( prime_n - 1 )) ./prime_parallel.out
+done
+
+# CSV: speedup and efficiency against the 1-process row of the same implementation
+echo "Implementation,Processes,Iterations,Converged,Final_Error,Time_Seconds,Speedup,Efficiency,Iterations_Per_Second,Label" > ${csv_file}
+awk -F'\t' '
+    {row[NR] = $0; if ($2 == 1) base[$1] = $6}
+    END {
+        for (r = 1; r <= NR; r++) {
+            split(row[r], f, "\t")
+            s = (f[1] in base && f[6] > 0) ? sprintf("%.6f", base[f[1]] / f[6]) : ""
+            e = (s != "") ? sprintf("%.6f", s / f[2]) : ""
+            printf "%s,%d,%d,%s,%s,%s,%s,%s,%.6f,\"%s\n(%dP)\"\n", f[1], f[2], f[3], f[4], f[5], f[6],
+                   s, e, (f[6] > 0 ? f[3] / f[6] : 0), f[1], f[2]
+        }
+    }' ${summary_file} >> ${csv_file}
+
+rm -f ${runs_file} ${summary_file}
+echo "Harness complete. Results saved in ${output_file} and ${csv_file}"
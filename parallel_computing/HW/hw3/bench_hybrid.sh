@@ -0,0 +1,76 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: pure MPI vs hybrid MPI + OpenMP
+# Objective:
+#   1. for a fixed core count, run hw3_laplace_mpi_3.c with one rank
+#      per core and laplace_mpi_hybrid.c with every ranks x threads
+#      split of those cores
+#   2. report time and speedup over pure MPI for a fixed iteration
+#      count and the iterations of a full solve
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_hybrid_result.txt"
+bench_itr=${BENCH_ITR:-500}
+max_itr=${MAX_ITR:-100000}
+
+# compiler: mpicc by default
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native -fopenmp"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} \
+    "NUMA: $(lscpu | grep 'NUMA node(s)' | sed -r 's/NUMA node\(s\):\s{1,}//g') domains" \
+    "Compiler: ${MPICC} ${MPIFLAGS}"
+
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_3.c -o laplace_mpi.out -lm || exit 1
+${MPICC} ${MPIFLAGS} laplace_mpi_hybrid.c -o laplace_hybrid.out -lm || exit 1
+
+# total cores per run and plate sizes to test; a Delta CPU node has 128
+cores=${CORES:-128}
+sizes=(2000 8000)
+
+# pull the solver's own timer out of its output
+solver_time() {
+    grep -E "Total time" | sed -r 's/[^0-9.]*([0-9.]+).*/\1/'
+}
+
+export OMP_PROC_BIND=close
+export OMP_PLACES=cores
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN, ${cores} CORES!!!!" >> ${output_file}
+printf "%-8s %6s %6s %8s %10s %8s\n" "mode" "size" "ranks" "threads" "time(s)" "speedup" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    echo "Running ${size}x${size} as pure MPI..."
+    base=$(${MPIRUN} -n ${cores} -x OMP_NUM_THREADS=1 ./laplace_mpi.out --size=${size} \
+           --max-temp-error=0 --max-iterations=${bench_itr} | solver_time)
+    printf "%-8s %6d %6d %8d %10s %8s\n" "mpi" ${size} ${cores} 1 ${base} "1.00" >> ${output_file}
+
+    # every split of the cores into ranks x threads, threads >= 2
+    for (( threads=2; threads<=cores; threads*=2 ))
+    do
+        ranks=$(( cores / threads ))
+        echo "Running ${size}x${size} as ${ranks} ranks x ${threads} threads..."
+        t=$(${MPIRUN} -n ${ranks} --map-by ppr:${ranks}:node:pe=${threads} \
+            ./laplace_hybrid.out --threads=${threads} --size=${size} \
+            --max-temp-error=0 --max-iterations=${bench_itr} | solver_time)
+        speedup=$(echo "${base} ${t}" | awk '{printf "%.2f", $1/$2}')
+        printf "%-8s %6d %6d %8d %10s %8s\n" "hybrid" ${size} ${ranks} ${threads} ${t} ${speedup} >> ${output_file}
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+
+echo "!!!!FULL SOLVE, 1000x1000!!!!" >> ${output_file}
+echo "=== mpi, 4 ranks ===" >> ${output_file}
+${MPIRUN} -n 4 ./laplace_mpi.out --size=1000 --max-iterations=${max_itr} | tail -3 >> ${output_file}
+echo "=== hybrid, 2 ranks x 2 threads ===" >> ${output_file}
+${MPIRUN} -n 2 ./laplace_hybrid.out --threads=2 --size=1000 --max-iterations=${max_itr} | tail -3 >> ${output_file}
+echo "Hybrid benchmark complete. Results saved in ${output_file}"
@@ -0,0 +1,91 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: grid row pitch and the old per-row allocation
+# Objective:
+#   1. run hw3_laplace_mpi_2.c as it was (a malloc per row, double**)
+#      and with one aligned block at --pitch=packed (COLUMNS+2, the
+#      layout of the other variants), aligned and padded
+#   2. run ../hw1/ex1/laplace_omp.c with the three pitches at 1, 8 and
+#      32 threads
+#   3. compare ns per cell update over a fixed iteration count; the
+#      sizes include 510, 1022 and 2046 columns, whose packed rows are
+#      a multiple of 4 KB apart, next to 1000 and 4000
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_pitch_result.txt"
+bench_itr=${BENCH_ITR:-300}
+
+# compilers: gcc and mpicc by default
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O3 -march=native -fopenmp"}
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native -pthread"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${CC} ${CFLAGS}; ${MPICC} ${MPIFLAGS}"
+
+# the double** version is the parent of the commit that replaced it
+rows_rev=$(git log -S'sizeof(double*)' --format=%h -1 -- hw3_laplace_mpi_2.c)
+git show ${rows_rev}^:./hw3_laplace_mpi_2.c > hw3_laplace_mpi_2_rows.c || exit 1
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_2_rows.c -o laplace_rows.out -lm || exit 1
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_2.c -o laplace_pitch.out -lm || exit 1
+${CC} ${CFLAGS} ../hw1/ex1/laplace_omp.c -o laplace_omp.out -lm || exit 1
+rm -f hw3_laplace_mpi_2_rows.c
+
+# Arrays of plate sizes, PE counts, thread counts and pitches to test
+sizes=(510 1000 1022 2046 4000)
+pe_counts=(1 4 16)
+thread_counts=(1 8 32)
+pitches=(packed aligned padded)
+
+# pull the solver's own timer out of its output
+solver_time() {
+    grep -E "Total time" | sed -r 's/[^0-9.]*([0-9.]+).*/\1/'
+}
+
+# one result row; the first run of a group is the speedup base
+report() {
+    local ns=$(echo "$5 $3 ${bench_itr}" | awk '{printf "%.3f", $1*1e9/($2*$2*$3)}')
+    [ -z "${base}" ] && base=$5
+    local speedup=$(echo "${base} $5" | awk '{printf "%.2f", $1/$2}')
+    printf "%-10s %-10s %6d %6d %10s %14s %8s\n" $1 $2 $3 $4 $5 ${ns} ${speedup} >> ${output_file}
+}
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN!!!!" >> ${output_file}
+printf "%-10s %-10s %6s %6s %10s %14s %8s\n" "solver" "layout" "size" "PEs/T" "time(s)" "ns/cell-update" "speedup" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for pe in "${pe_counts[@]}"
+    do
+        echo "Running hw3_laplace_mpi_2 ${size}x${size} on ${pe} PEs..."
+        base=""
+        t=$(${MPIRUN} -n ${pe} ./laplace_rows.out --size=${size} --max-temp-error=0 --max-iterations=${bench_itr} | solver_time)
+        report mpi_2 rows ${size} ${pe} ${t}
+        for pitch in "${pitches[@]}"
+        do
+            t=$(${MPIRUN} -n ${pe} ./laplace_pitch.out --size=${size} --max-temp-error=0 --max-iterations=${bench_itr} --pitch=${pitch} | solver_time)
+            report mpi_2 ${pitch} ${size} ${pe} ${t}
+        done
+    done
+    for threads in "${thread_counts[@]}"
+    do
+        echo "Running laplace_omp ${size}x${size} with ${threads} threads..."
+        export OMP_NUM_THREADS=${threads}
+        base=""
+        for pitch in "${pitches[@]}"
+        do
+            t=$(./laplace_omp.out --size=${size} --max-temp-error=0 --max-iterations=${bench_itr} --pitch=${pitch} | solver_time)
+            report omp ${pitch} ${size} ${threads} ${t}
+        done
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+echo "Pitch benchmark complete. Results saved in ${output_file}"
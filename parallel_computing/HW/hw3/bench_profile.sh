@@ -0,0 +1,65 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: PMPI communication profile of the MPI Laplace variants
+# Objective:
+#   1. link each MPI Laplace code against mpi_profile.c (no source
+#      change) and run it for a fixed iteration count
+#   2. keep the per-rank split of compute, point to point, waits,
+#      collectives, RMA and I/O, the per-routine table, load imbalance
+#      and the overlap efficiency of the non-blocking halo exchange
+#   3. MPI_PROFILE_CSV rows per variant for the notebook
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_profile_result.txt"
+bench_itr=${BENCH_ITR:-1000}
+size=${SIZE:-2000}
+pe=${PES:-8}
+csv_dir=${CSV_DIR:-"profile_csv"}
+
+# compiler: mpicc by default
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native -fopenmp"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${MPICC} ${MPIFLAGS}"
+
+# variant name, source and extra solver arguments; laplace_mpi.c is
+# written for exactly 4 PEs and always gets 4
+variants=(
+    "laplace_mpi ../../Exercises/MPI/laplace_mpi.c"
+    "hw3_isend hw3_laplace_mpi_3.c --halo=isend"
+    "hw3_put hw3_laplace_mpi_3.c --halo=put"
+    "hw3_shm hw3_laplace_mpi_3.c --halo=shm"
+    "hw3_lag4 hw3_laplace_mpi_3.c --check-lag=4"
+    "mpi_2d laplace_mpi_2d_optimized.c"
+    "hybrid laplace_mpi_hybrid.c"
+)
+
+mkdir -p ${csv_dir}
+echo "!!!!${bench_itr} ITERATIONS, ${size}x${size}, ${pe} PEs PER RUN!!!!" >> ${output_file}
+for variant in "${variants[@]}"
+do
+    set -- ${variant}
+    name=$1
+    source=$2
+    shift 2
+    np=${pe}
+    if [ ${name} = laplace_mpi ]; then np=4; fi
+    echo "Running ${name}..."
+    ${MPICC} ${MPIFLAGS} ${source} mpi_profile.c -o ${name}_profile.out -lm || exit 1
+    echo "--- ${name}${*:+ $*} on ${np} PEs ---" >> ${output_file}
+    # laplace_mpi.c asks for the iteration count on stdin
+    echo ${bench_itr} | OMP_NUM_THREADS=${OMP_NUM_THREADS:-1} MPI_PROFILE_CSV=${csv_dir}/${name}.csv \
+        ${MPIRUN} -n ${np} ./${name}_profile.out --size=${size} \
+        --max-temp-error=0 --max-iterations=${bench_itr} "$@" | grep -E "^Profile:|Total time" >> ${output_file}
+    rm -f ${name}_profile.out
+done
+echo "Profile benchmark complete. Results saved in ${output_file}, CSV rows in ${csv_dir}/"
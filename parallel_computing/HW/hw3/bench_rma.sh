@@ -0,0 +1,58 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: two-sided vs one-sided (MPI_Put) halo exchange
+# Objective:
+#   1. run hw3_laplace_mpi_3.c with --halo=isend (Isend/Irecv/Waitall)
+#      and --halo=put (MPI_Put into the neighbours' ghost rows,
+#      lock_all + flush) for a fixed iteration count
+#   2. report the halo time per iteration of the slowest PE (the
+#      solver's own "Halo time per iteration" line) and the total time
+#   3. run across nodes too (e.g. 2 nodes) where put can use RDMA
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_rma_result.txt"
+bench_itr=${BENCH_ITR:-1000}
+
+# compiler: mpicc by default
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${MPICC} ${MPIFLAGS}"
+
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_3.c -o laplace_mpi.out -lm || exit 1
+
+# Arrays of plate sizes and PE counts to test
+sizes=(500 2000 8000)
+pe_counts=(8 32 128)
+
+# halo microseconds per iteration and total seconds from the solver's output
+run() {
+    ${MPIRUN} -n $1 ./laplace_mpi.out --size=$2 --max-temp-error=0 --max-iterations=${bench_itr} --halo=$3 |
+        awk '/Halo time per iteration/ {h=$5} /Total time/ {t=$4} END {printf "%12s %10s", h, t}'
+}
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN!!!!" >> ${output_file}
+printf "%-6s %6s %5s %12s %10s %10s\n" "halo" "size" "PEs" "halo_us/itr" "time(s)" "halo_x" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for pe in "${pe_counts[@]}"
+    do
+        echo "Running ${size}x${size} on ${pe} PEs..."
+        two=$(run ${pe} ${size} isend)
+        one=$(run ${pe} ${size} put)
+        printf "%-6s %6d %5d %s %10s\n" "isend" ${size} ${pe} "${two}" "1.00" >> ${output_file}
+        ratio=$(echo "${two} ${one}" | awk '{printf "%.2f", $1/$3}')
+        printf "%-6s %6d %5d %s %10s\n" "put" ${size} ${pe} "${one}" ${ratio} >> ${output_file}
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+echo "RMA halo benchmark complete. Results saved in ${output_file}"
@@ -0,0 +1,69 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: Isend/Irecv halos vs MPI-3 shared-memory windows
+# Objective:
+#   1. run hw3_laplace_mpi_3.c on one node with --halo=isend (ghost
+#      rows copied through MPI) and --halo=shm (neighbours read each
+#      other's edge rows in place)
+#   2. report time, microseconds per iteration and speedup for a fixed
+#      iteration count, for growing plate widths (= halo row length)
+#   3. check both stop on the same iteration for a full solve
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_shm_result.txt"
+bench_itr=${BENCH_ITR:-1000}
+max_itr=${MAX_ITR:-100000}
+
+# compiler: mpicc by default
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${MPICC} ${MPIFLAGS}"
+
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_3.c -o laplace_mpi.out -lm || exit 1
+
+# Arrays of plate sizes and PE counts to test, all on one node
+sizes=(500 2000 8000)
+pe_counts=(8 32)
+
+# pull the solver's own timer out of its output
+solver_time() {
+    grep -E "Total time" | sed -r 's/[^0-9.]*([0-9.]+).*/\1/'
+}
+
+echo "!!!!${bench_itr} ITERATIONS PER RUN!!!!" >> ${output_file}
+printf "%-6s %6s %5s %10s %10s %8s\n" "halo" "size" "PEs" "time(s)" "us/iter" "speedup" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for pe in "${pe_counts[@]}"
+    do
+        echo "Running ${size}x${size} on ${pe} PEs..."
+        base=""
+        for halo in isend shm
+        do
+            t=$(${MPIRUN} -n ${pe} ./laplace_mpi.out --size=${size} --max-temp-error=0 \
+                --max-iterations=${bench_itr} --halo=${halo} | solver_time)
+            if [ -z "${base}" ]; then base=${t}; fi
+            echo "${base} ${t}" | awk -v h=${halo} -v s=${size} -v p=${pe} -v n=${bench_itr} \
+                '{printf "%-6s %6d %5d %10s %10.1f %8.2f\n", h, s, p, $2, $2*1e6/n, $1/$2}' >> ${output_file}
+        done
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+
+echo "!!!!FULL SOLVE, 1000x1000, 8 PEs!!!!" >> ${output_file}
+for halo in isend shm
+do
+    echo "=== ${halo} ===" >> ${output_file}
+    ${MPIRUN} -n 8 ./laplace_mpi.out --size=1000 --max-iterations=${max_itr} --halo=${halo} | tail -3 | head -2 >> ${output_file}
+done
+echo "Shared-memory halo benchmark complete. Results saved in ${output_file}"
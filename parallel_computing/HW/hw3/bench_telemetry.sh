@@ -0,0 +1,80 @@
+#!/bin/bash
+
+#################################################################
+# Project: CI Pathway Parallel computing
+# Title: progress printf versus the non-blocking telemetry sink
+# Objective:
+#   1. run hw3_laplace_mpi_3.c to convergence with the usual printf
+#      from the loop and with --telemetry to stdout, a CSV file and a
+#      Prometheus text file, every 100 iterations and every iteration
+#   2. repeat each run and report the mean, spread (max - min) and
+#      standard deviation of the total time, and the records the
+#      rings dropped: the sink should cut the spread, not the answer
+#   3. the gap widens with the PE count and on a slow terminal
+# Author: Hochan Son
+# Email: ohsono@gmail.com or hochanson@g.ucla.edu
+#################################################################
+# Output file
+output_file="bench_telemetry_result.txt"
+max_itr=${MAX_ITR:-4000}
+repeats=${REPEATS:-5}
+
+# compiler: mpicc by default; the sink is a pthread
+MPICC=${MPICC:-mpicc}
+MPIFLAGS=${MPIFLAGS:-"-O3 -march=native -pthread"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+# shared helpers: bench_system_info
+source "$(dirname "$0")/bench_common.sh"
+
+# Add header with system information
+bench_system_info ${output_file} "Compiler: ${MPICC} ${MPIFLAGS}"
+
+${MPICC} ${MPIFLAGS} hw3_laplace_mpi_3.c -o laplace_mpi.out -lm || exit 1
+
+# Arrays of plate sizes, PE counts and output modes to test
+sizes=(1000 4000)
+pe_counts=(4 16 64)
+modes=("printf" "--telemetry=stdout" "--telemetry=telemetry.csv" "--telemetry=prom:telemetry.prom"
+       "--telemetry=stdout --telemetry-every=1" "--telemetry=telemetry.csv --telemetry-every=1")
+
+# total seconds and dropped records of one run
+run() {
+    local flags="$3"
+    [ "${flags}" = "printf" ] && flags=""
+    ${MPIRUN} -n $1 ./laplace_mpi.out --size=$2 --max-iterations=${max_itr} ${flags} |
+        awk '/Total time/ {t=$4} /^Telemetry:/ {d=$4; gsub(/\(/, "", d)}
+             END {printf "%s %s", t, (d == "" ? "-" : d)}'
+}
+
+echo "!!!!RUN TO CONVERGENCE, AT MOST ${max_itr} ITERATIONS, ${repeats} RUNS EACH!!!!" >> ${output_file}
+printf "%-48s %6s %5s %10s %10s %10s %8s\n" "mode" "size" "PEs" "mean(s)" "spread(s)" "stddev(s)" "dropped" >> ${output_file}
+for size in "${sizes[@]}"
+do
+    for pe in "${pe_counts[@]}"
+    do
+        echo "Running ${size}x${size} on ${pe} PEs..."
+        for mode in "${modes[@]}"
+        do
+            results=""
+            for ((r = 0; r < repeats; r++))
+            do
+                results="${results} $(run ${pe} ${size} "${mode}")"
+            done
+            echo "${results}" |
+                awk -v mode="${mode}" -v size=${size} -v pe=${pe} '
+                    { for (k = 1; k < NF; k += 2) {
+                          t = $k; n++; sum += t; sq += t * t
+                          if (n == 1 || t < lo) lo = t
+                          if (n == 1 || t > hi) hi = t
+                          if ($(k+1) != "-") dropped += $(k+1); else nodrop = 1
+                      } }
+                    END { mean = sum / n; var = sq / n - mean * mean
+                          printf "%-48s %6d %5d %10.4f %10.4f %10.4f %8s\n", mode, size, pe,
+                                 mean, hi - lo, sqrt(var > 0 ? var : 0), nodrop ? "-" : dropped }' >> ${output_file}
+        done
+        rm -f telemetry.csv* telemetry.prom*
+    done
+    echo "----------------------------------------" >> ${output_file}
+done
+echo "Telemetry benchmark complete. Results saved in ${output_file}"
@@ -13,6 +13,13 @@
  * - Dynamic process count support
  * - Proper convergence checking
  * - Fixed ghost cell communication
+ * - One contiguous, 64-byte aligned block per grid, rows padded apart
+ *   ([--pitch=packed|aligned|padded|N], padded by default) instead of a
+ *   malloc per row; see laplace_grid_pitch() in common/laplace_args.h
+ * - Optional telemetry (--telemetry=stdout|FILE|prom:FILE
+ *   [--telemetry-every=N]): progress lines, dt and phase times go
+ *   through a lock-free ring to a sink thread instead of printf in
+ *   the loop; see common/laplace_telemetry.h
  *******************************************************************/
 
 #include <stdlib.h>
@@ -20,25 +27,23 @@
 #include <math.h>
 #include <sys/time.h>
 #include <mpi.h>
-
-#define COLUMNS      1000
-#define ROWS_GLOBAL  1000
-#define MAX_TEMP_ERROR 0.01
+#include "../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
+#include "../../common/bench_phases.h"
+#include "../../common/laplace_telemetry.h"
 
 // Communication tags
 #define DOWN     100
 #define UP       101   
 
-// Global variables for temperature arrays
-double **Temperature;
-double **Temperature_last;
-
 // Function prototypes
-void initialize(int npes, int my_PE_num, int my_rows);
-void track_progress(int iteration, int my_rows, int npes, int my_PE_num);
+void initialize(int npes, int my_PE_num, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]);
+void track_progress(int iteration, int64_t my_rows, int npes, int my_PE_num, int64_t pitch,
+                    double (*Temperature)[pitch]);
+void sample_progress(laplace_telemetry_record *r, int64_t my_rows, int npes, int my_PE_num, int64_t pitch,
+                     double (*Temperature)[pitch]);
 
 int main(int argc, char *argv[]) {
-    int i, j;
+    int64_t i, j;
     int max_iterations;
     int iteration = 1;
     double dt;
@@ -48,18 +53,38 @@ int main(int argc, char *argv[]) {
     int my_PE_num;           // my PE number
     double dt_global = 100;  // delta t across all PEs
     MPI_Status status;       // status returned by MPI calls
+    const char *telemetry_spec = NULL;  // --telemetry sink, NULL = print directly
+    int telemetry_every = 100;          // iterations between records
+    laplace_telemetry telemetry;
+    bench_phases phases;     // seconds per phase, for the telemetry records
+    int64_t pitch;           // doubles from one row to the next
+    const char *v;
+    int arg;
 
     // MPI startup routines
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &my_PE_num);
     MPI_Comm_size(MPI_COMM_WORLD, &npes);
 
+    // every PE parses the same command line
+    max_iterations = laplace_parse_args(argc, argv);
+    pitch = laplace_grid_pitch(COLUMNS, LAPLACE_PITCH_PADDED);
+    for (arg = 1; arg < argc; arg++) {
+        if ((v = laplace_arg_value(argv[arg], "--pitch"))) {
+            pitch = laplace_parse_pitch(v, COLUMNS);
+        } else if ((v = laplace_arg_value(argv[arg], "--telemetry-every"))) {
+            telemetry_every = laplace_parse_int(v, "--telemetry-every");
+        } else if ((v = laplace_arg_value(argv[arg], "--telemetry"))) {
+            telemetry_spec = v;
+        }
+    }
+
     // Calculate dynamic local dimensions
-    int rows_per_process = ROWS_GLOBAL / npes;
-    int ghost_rows = ROWS_GLOBAL % npes;
+    int64_t rows_per_process = ROWS / npes;
+    int64_t ghost_rows = ROWS % npes;
     
     // Handle uneven division
-    int my_rows = rows_per_process;
+    int64_t my_rows = rows_per_process;
     if (my_PE_num < ghost_rows) {
         my_rows++;  // First 'ghost_rows' processes get one ghost row
     }
@@ -67,21 +92,17 @@ int main(int argc, char *argv[]) {
     if (my_PE_num == 0) {
         printf("=== Complete Working 1D Linear Laplace MPI Solver ===\n");
         printf("Running with %d processes\n", npes);
-        printf("Grid size: %d x %d\n", ROWS_GLOBAL, COLUMNS);
-        printf("Process 0 managing %d rows\n", my_rows);
+        printf("Grid size: %" PRId64 " x %" PRId64 "\n", (int64_t)ROWS, (int64_t)COLUMNS);
+        printf("Process 0 managing %" PRId64 " rows\n", my_rows);
+        printf("Row pitch: %" PRId64 " doubles\n", pitch);
     }
 
-    // Dynamic memory allocation for 1D arrays
-    Temperature = malloc((my_rows + 2) * sizeof(double*));
-    Temperature_last = malloc((my_rows + 2) * sizeof(double*));
-    
-    for(i = 0; i < my_rows + 2; i++) {
-        Temperature[i] = malloc((COLUMNS + 2) * sizeof(double));
-        Temperature_last[i] = malloc((COLUMNS + 2) * sizeof(double));
-    }
+    // one aligned block per grid, rows pitch doubles apart
+    double (*Temperature)[pitch]      = laplace_alloc_pitched_grid(my_rows, pitch);
+    double (*Temperature_last)[pitch] = laplace_alloc_pitched_grid(my_rows, pitch);
 
     // PE 0 asks for input
-    if(my_PE_num == 0) {
+    if(my_PE_num == 0 && max_iterations < 0) {
         printf("Maximum iterations [100-4000]?\n");
         fflush(stdout);
         scanf("%d", &max_iterations);
@@ -91,9 +112,12 @@ int main(int argc, char *argv[]) {
     MPI_Bcast(&max_iterations, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
     if (my_PE_num == 0) gettimeofday(&start_time, NULL);
+    bench_start(&phases);
 
     // Initialize boundary conditions
-    initialize(npes, my_PE_num, my_rows);
+    initialize(npes, my_PE_num, my_rows, pitch, Temperature_last);
+    laplace_telemetry_open(&telemetry, telemetry_spec, my_PE_num, npes, 1);
+    bench_lap(&phases, BENCH_INIT);
 
     // Main iteration loop
     while (dt_global > MAX_TEMP_ERROR && iteration <= max_iterations) {
@@ -105,6 +129,7 @@ int main(int argc, char *argv[]) {
                                             Temperature_last[i][j+1] + Temperature_last[i][j-1]);
             }
         }
+        bench_lap(&phases, BENCH_COMPUTE);
 
         // === COMMUNICATION PHASE: send ghost rows for next iteration ===
 
@@ -127,6 +152,7 @@ int main(int argc, char *argv[]) {
         if(my_PE_num != npes-1) {  // unless we are bottom PE
             MPI_Recv(&Temperature_last[my_rows+1][1], COLUMNS, MPI_DOUBLE, my_PE_num+1, UP, MPI_COMM_WORLD, &status);
         }
+        bench_lap(&phases, BENCH_HALO);
 
         // === CONVERGENCE CHECK ===
         dt = 0.0;
@@ -140,20 +166,35 @@ int main(int argc, char *argv[]) {
         // Find global dt                                                        
         MPI_Reduce(&dt, &dt_global, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
         MPI_Bcast(&dt_global, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        bench_lap(&phases, BENCH_REDUCTION);
 
         // Periodically print test values - only for PE in lower corner
-        if((iteration % 100) == 0) {
+        if (telemetry.enabled) {
+            if ((iteration % telemetry_every) == 0) {
+                laplace_telemetry_record r;
+                laplace_telemetry_record_init(&telemetry, &r, iteration, dt_global, phases.seconds);
+                if (my_PE_num == npes-1) sample_progress(&r, my_rows, npes, my_PE_num, pitch, Temperature);
+                if (my_PE_num == 0) r.flags |= LAPLACE_TELEMETRY_HAS_DT;
+                laplace_telemetry_push(&telemetry, &r);
+            }
+        } else if((iteration % 100) == 0) {
             if (my_PE_num == npes-1) {
-                track_progress(iteration, my_rows, npes, my_PE_num);
+                track_progress(iteration, my_rows, npes, my_PE_num, pitch, Temperature);
             }
             if (my_PE_num == 0) {
                 printf("Iteration %d: dt_global = %f\n", iteration, dt_global);
             }
         }
 
+        bench_lap(&phases, BENCH_OUTPUT);
+
         iteration++;
     }
 
+    // the sinks finish the progress lines before the results
+    int64_t telemetry_pushed, telemetry_dropped;
+    laplace_telemetry_close(&telemetry, &telemetry_pushed, &telemetry_dropped);
+
     // Synchronize for accurate timing
     MPI_Barrier(MPI_COMM_WORLD);
 
@@ -173,11 +214,15 @@ int main(int argc, char *argv[]) {
         printf("====================================\n");
     }
 
-    // Free memory
-    for(i = 0; i < my_rows + 2; i++) {
-        free(Temperature[i]);
-        free(Temperature_last[i]);
+    if (telemetry_spec) {
+        int64_t counts[2] = {telemetry_pushed, telemetry_dropped}, sums[2];
+        MPI_Reduce(counts, sums, 2, MPI_INT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (my_PE_num == 0)
+            printf("Telemetry: %" PRId64 " records (%" PRId64 " dropped) from %d PEs to %s\n",
+                   sums[0], sums[1], npes, telemetry_spec);
     }
+
+    // Free memory
     free(Temperature);
     free(Temperature_last);
 
@@ -185,9 +230,9 @@ int main(int argc, char *argv[]) {
     return 0;
 }
 
-void initialize(int npes, int my_PE_num, int my_rows) {
+void initialize(int npes, int my_PE_num, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]) {
     double tMin, tMax;  // Local boundary limits
-    int i, j;
+    int64_t i, j;
 
     // Initialize all points to 0.0
     for(i = 0; i <= my_rows + 1; i++) {
@@ -221,21 +266,22 @@ void initialize(int npes, int my_PE_num, int my_rows) {
         }
     }
 
-    printf("Process %d: initialized boundaries (tMin=%.1f, tMax=%.1f, rows=%d)\n", 
+    printf("Process %d: initialized boundaries (tMin=%.1f, tMax=%.1f, rows=%" PRId64 ")\n", 
            my_PE_num, tMin, tMax, my_rows);
 }
 
-void track_progress(int iteration, int my_rows, int npes, int my_PE_num) {
-    int i;
+void track_progress(int iteration, int64_t my_rows, int npes, int my_PE_num, int64_t pitch,
+                    double (*Temperature)[pitch]) {
+    int64_t i;
     
     printf("---------- Iteration number: %d ------------\n", iteration);
 
     // Calculate global coordinates for display
     // This matches the original algorithm exactly
-    int rows_per_process = ROWS_GLOBAL / npes;
-    int ghost_rows = ROWS_GLOBAL % npes;
+    int64_t rows_per_process = ROWS / npes;
+    int64_t ghost_rows = ROWS % npes;
     
-    int global_start_row = my_PE_num * rows_per_process;
+    int64_t global_start_row = my_PE_num * rows_per_process;
     if (my_PE_num < ghost_rows) {
         global_start_row += my_PE_num;
     } else {
@@ -243,11 +289,35 @@ void track_progress(int iteration, int my_rows, int npes, int my_PE_num) {
     }
 
     // Output global coordinates so user doesn't have to understand decomposition
-    for(i = 5; i >= 0; i--) {
-        if (my_rows - i > 0) {
-            int global_row = global_start_row + (my_rows - i);
-            printf("[%d,%d]: %5.2f  ", global_row, COLUMNS - i, Temperature[my_rows - i][COLUMNS - i]);
-        }
+    for(i = laplace_progress_reach(my_rows, COLUMNS); i >= 0; i--) {
+        int64_t global_row = global_start_row + (my_rows - i);
+        printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", global_row, COLUMNS - i, Temperature[my_rows - i][COLUMNS - i]);
     }
     printf("\n");
-}
\ No newline at end of file
+}
+
+// the track_progress values as a telemetry record, printed by the sink
+void sample_progress(laplace_telemetry_record *r, int64_t my_rows, int npes, int my_PE_num, int64_t pitch,
+                     double (*Temperature)[pitch]) {
+    int64_t i;
+
+    // same global rows as track_progress
+    int64_t rows_per_process = ROWS / npes;
+    int64_t ghost_rows = ROWS % npes;
+
+    int64_t global_start_row = my_PE_num * rows_per_process;
+    if (my_PE_num < ghost_rows) {
+        global_start_row += my_PE_num;
+    } else {
+        global_start_row += ghost_rows;
+    }
+
+    r->flags |= LAPLACE_TELEMETRY_HAS_SAMPLES;
+    for(i = laplace_progress_reach(my_rows, COLUMNS); i >= 0; i--) {
+        if (r->samples == 0) {
+            r->sample_row = global_start_row + (my_rows - i);
+            r->sample_column = COLUMNS - i;
+        }
+        r->sample[r->samples++] = Temperature[my_rows - i][COLUMNS - i];
+    }
+}
@@ -7,7 +7,58 @@
  * - Loop fusion for better cache locality
  * - AllReduce instead of Reduce+Bcast
  * - Dynamic memory allocation for scalability
+ * - Rows are pitch doubles apart in one 64-byte aligned block per grid
+ *   (--pitch=packed|aligned|padded|N, padded by default; see
+ *   laplace_grid_pitch() in common/laplace_args.h). --precision=mixed
+ *   keeps packed rows, which common/laplace_mixed.h indexes
  * - Removed hardcoded processor count limitation
+ * - Explicit SSE2/AVX2/AVX-512 row kernels picked by CPUID
+ *   (--simd=auto|avx512|avx2|sse2|scalar, --simd-report;
+ *   see common/laplace_simd.h)
+ * - Mixed precision (--precision=mixed): float sweeps on a correction
+ *   with float ghost rows, refined in double every 100 iterations;
+ *   see common/laplace_mixed.h
+ * - Deep halos (--halo-depth=K): exchange K ghost rows every K
+ *   iterations and recompute the shrinking overlap redundantly, with
+ *   one Allreduce of K dts per block; same iterates as K = 1
+ * - On-node zero-copy halos (--halo=shm): PEs on the same node keep
+ *   their grids in an MPI-3 shared window and read the neighbour's
+ *   edge row in place; off-node neighbours still use Isend/Irecv
+ * - One-sided halos (--halo=put): each PE MPI_Puts its new edge rows
+ *   into the neighbours' ghost rows as soon as they are computed, in a
+ *   lock_all epoch, flushed before the dt Allreduce
+ * - Every run reports the halo time per iteration (slowest PE)
+ * - Sparse convergence checks (--check-every=N|auto): dt and its
+ *   Allreduce only on the iterations common/laplace_check.h picks
+ * - Pipelined checks (--check-lag=L): the dt Allreduce is an
+ *   MPI_Iallreduce read L iterations later, while the sweeps go on.
+ *   One is in flight at a time; the reported iteration is the one dt
+ *   was measured on, and the run stops at most L iterations after it
+ * - Checkpoint/restart (--checkpoint=FILE [--checkpoint-every=N],
+ *   --restart=FILE): every N iterations all PEs write their rows into
+ *   one shared file with MPI_File_write_at_all through a subarray view;
+ *   the file holds the global interior in row order, so a restart may
+ *   use any PE count. Reports GB/s and seconds per checkpoint.
+ *   --checkpoint-codec=xor stores each PE's rows through the lossless
+ *   codec of common/laplace_codec.h instead
+ * - In-situ analysis (--analysis=PREFIX [--analysis-every=N]
+ *   [--decimate=F] [--isotherms=L1,...]): each PE reduces statistics,
+ *   thumbnail block sums and isotherm segments over its own rows with
+ *   common/laplace_analysis.h; MPI_Reduce and MPI_Gatherv bring only
+ *   those small results to PE 0, which writes them. The field is never
+ *   gathered or written
+ * - Phase timers (--bench): init, compute, halo, reduction and output
+ *   time, the slowest PE's each, for HW/hw3/bench_harness.sh; see
+ *   common/bench_phases.h
+ * - Timeline tracing (--trace=FILE [--trace-events=N]): every PE
+ *   records halo post, interior sweep, wait, boundary rows, reduction
+ *   and output of each iteration; PE 0 merges them into one Chrome
+ *   trace JSON for Perfetto. See common/laplace_trace.h
+ * - Telemetry (--telemetry=stdout|FILE|prom:FILE [--telemetry-every=N]):
+ *   the loop pushes dt, phase times and the corner samples into a
+ *   lock-free ring instead of printing, and a sink thread on each PE
+ *   writes them out; a full ring drops records, it never stalls the
+ *   sweep. See common/laplace_telemetry.h
  *                                                               
  * T is initially 0.0                                            
  * Boundaries are as follows                                     
@@ -33,28 +84,80 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <limits.h>
 #include <sys/time.h>
 #include <mpi.h>
-
-#define COLUMNS      1000
-#define ROWS_GLOBAL  1000        // this is a "global" row count
+#include "../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
+#include "../../common/laplace_simd.h"
+#include "../../common/laplace_mixed.h"
+#include "../../common/laplace_check.h"
+#include "../../common/laplace_codec.h"
+#include "../../common/laplace_analysis.h"
+#include "../../common/bench_phases.h"
+#include "../../common/laplace_trace.h"
+#include "../../common/laplace_telemetry.h"
 
 // communication tags
 #define DOWN     100
 #define UP       101   
+#define ANALYSIS 102      // first row to the PE above, for its last isotherm cells
+
+// ghost-row exchange backends (--halo=...)
+#define HALO_ISEND  0     // Isend/Irecv into the ghost rows
+#define HALO_SHM    1     // MPI-3 shared window on the node, Isend/Irecv off it
+#define HALO_PUT    2     // MPI_Put into the neighbours' ghost rows, passive target
 
-#define MAX_TEMP_ERROR 0.01
+// checkpoint file: a CKPT_HEADER-byte header, then
+//   raw: the ROWS x COLUMNS interior in global row order
+//   xor: a table of one checkpoint_segment per writing PE, then each
+//        PE's rows as a laplace_codec_encode stream
+// initialize() rebuilds the boundaries
+#define CKPT_MAGIC   "LAPCKPT1"
+#define CKPT_HEADER  64
+#define CKPT_RAW     0
+#define CKPT_XOR     1
 
-// Global pointers for dynamic arrays
-double (*Temperature)[COLUMNS+2];
-double (*Temperature_last)[COLUMNS+2];
+typedef struct {
+    char    magic[8];
+    int64_t rows;
+    int64_t columns;
+    int64_t iteration;          // iterations done when written
+    double  dt;                 // dt_global at that iteration
+    int64_t encoding;           // CKPT_RAW or CKPT_XOR
+    int64_t segments;           // xor: entries in the segment table
+    char    pad[CKPT_HEADER - 8 - 6*8];
+} checkpoint_header;
 
-void initialize(int npes, int my_PE_num, int my_rows);
-void track_progress(int iteration, int my_rows);
+typedef struct {
+    int64_t start_row;          // first global interior row, from 0
+    int64_t rows;
+    int64_t offset;             // of the stream in the file
+    int64_t bytes;
+} checkpoint_segment;
+
+void initialize(int npes, int my_PE_num, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]);
+void track_progress(int iteration, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]);
+void sample_progress(laplace_telemetry_record *r, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]);
+void exchange_ghost_rows(void *grid, MPI_Datatype type, size_t cell_bytes,
+                         int npes, int my_PE_num, int64_t my_rows);
+int deep_halo_solve(int npes, int my_PE_num, int64_t my_rows, int depth, int iteration,
+                    int max_iterations, const laplace_simd_kernels *simd, int64_t pitch, double (*Temperature)[pitch],
+                    double (*Temperature_last)[pitch], double *dt_global);
+double *shm_neighbour(MPI_Win win, MPI_Comm node, int world_rank);
+void put_edge_rows(MPI_Win win, int npes, int my_PE_num, int64_t my_rows, int64_t up_rows,
+                   int64_t down_rows, int64_t buffer, int64_t pitch, double (*Temperature)[pitch]);
+void neighbour_sync(int npes, int my_PE_num);
+double write_checkpoint(const char *path, int npes, int my_PE_num, int64_t my_rows, int64_t my_start_row,
+                        int encoding, int iteration, double dt_global,
+                        int64_t pitch, double (*Temperature_last)[pitch], double *file_bytes);
+int read_checkpoint(const char *path, int my_PE_num, int64_t my_rows, int64_t my_start_row,
+                    int *iteration, double *dt_global, int64_t pitch, double (*Temperature_last)[pitch]);
+void analyze(laplace_analysis *a, int npes, int my_PE_num, int64_t my_rows, int64_t my_start_row,
+             int iteration, int64_t pitch, double (*Temperature_last)[pitch]);
 
 int main(int argc, char *argv[]) {
 
-    int i, j;
+    int64_t i;
     int max_iterations;
     int iteration=1;
     double dt;
@@ -68,19 +171,164 @@ int main(int argc, char *argv[]) {
     int        req_count;           // number of active requests
     
     // Dynamic row distribution
-    int rows_per_process;
-    int extra_rows;
-    int my_rows;
-    int my_start_row;
+    int64_t rows_per_process;
+    int64_t extra_rows;
+    int64_t my_rows;
+    int64_t my_start_row;
+    int64_t pitch;                  // doubles from one row to the next
+
+    const char *simd_name = NULL;   // row kernel set, NULL = widest supported
+    int simd_report = 0;            // time the kernel sets first
+    const laplace_simd_kernels *simd;
+    int mixed = 0;                  // float sweeps with double refinement
+    laplace_mixed m = {0};
+    int depth = 1;                  // ghost rows per neighbour, exchanged every depth iterations
+    int halo = HALO_ISEND;          // ghost-row exchange backend
+    MPI_Comm node_comm;             // PEs sharing this node's memory (--halo=shm)
+    MPI_Win shm_win = MPI_WIN_NULL; // both grids of every PE on the node
+    double *shm_up = NULL;          // grids of the PE above / below, if on this node
+    double *shm_down = NULL;
+    MPI_Win put_win = MPI_WIN_NULL; // both grids, open to MPI_Put (--halo=put)
+    int msg_up, msg_down;           // neighbours reached by Isend/Irecv
+    bench_phases bench;             // seconds per phase; halo is posting, waiting and syncing halos
+    int bench_line = 0;             // --bench: PE 0 prints the slowest PE's phases
+    const char *trace_path = NULL;  // --trace file, NULL = no tracing
+    int64_t trace_events = 0;       // events per PE, 0 = default
+    laplace_trace trace;
+    const char *telemetry_spec = NULL;  // --telemetry sink, NULL = print directly
+    int telemetry_every = 100;      // iterations between records
+    laplace_telemetry telemetry;
+    int64_t up_rows = 0;            // rows of the PE above / below
+    int64_t down_rows = 0;
+    const char *check_spec = NULL;  // --check-every, NULL = every iteration
+    laplace_check check;            // when to measure dt
+    char check_name[32];
+    int check_lag = 0;              // iterations an Iallreduce of dt stays in flight
+    MPI_Request dt_request = MPI_REQUEST_NULL;
+    double dt_send, dt_recv;        // buffers of the dt Iallreduce in flight
+    int dt_iteration = 0;           // iteration that dt was measured on
+    int converged_at = 0;           // check that saw dt under MAX_TEMP_ERROR (lagged checks)
+    const char *checkpoint_path = NULL; // --checkpoint file, NULL = none
+    int checkpoint_every = 1000;    // iterations between checkpoints
+    const char *restart_path = NULL;    // --restart file to resume from
+    int checkpoints = 0;            // checkpoints written
+    double checkpoint_time = 0.0;   // seconds spent writing them
+    double checkpoint_bytes = 0.0;  // file bytes written
+    int checkpoint_encoding = CKPT_RAW; // --checkpoint-codec
+    const char *analysis_prefix = NULL; // --analysis output prefix, NULL = none
+    int analysis_every = 0;         // iterations between analyses, 0 = final only
+    int64_t decimate = 0;           // thumbnail factor, 0 = fit 256 pixels
+    const char *isotherms = NULL;   // isotherm levels, NULL = 10, 20, ..., 90
+    laplace_analysis analysis;
+    const char *v;
+    int arg;
 
     // the usual MPI startup routines
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &my_PE_num);
     MPI_Comm_size(MPI_COMM_WORLD, &npes);
 
+    // every PE parses the same command line
+    max_iterations = laplace_parse_args(argc, argv);
+    pitch = laplace_grid_pitch(COLUMNS, LAPLACE_PITCH_PADDED);
+    for (arg = 1; arg < argc; arg++) {
+        if ((v = laplace_arg_value(argv[arg], "--pitch"))) {
+            pitch = laplace_parse_pitch(v, COLUMNS);
+        } else if ((v = laplace_arg_value(argv[arg], "--simd"))) {
+            simd_name = v;
+        } else if (strcmp(argv[arg], "--simd-report") == 0) {
+            simd_report = 1;
+        } else if (strcmp(argv[arg], "--bench") == 0) {
+            bench_line = 1;
+        } else if ((v = laplace_arg_value(argv[arg], "--trace-events"))) {
+            trace_events = laplace_parse_size(v, "--trace-events");
+        } else if ((v = laplace_arg_value(argv[arg], "--trace"))) {
+            trace_path = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--telemetry-every"))) {
+            telemetry_every = laplace_parse_int(v, "--telemetry-every");
+        } else if ((v = laplace_arg_value(argv[arg], "--telemetry"))) {
+            telemetry_spec = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--precision"))) {
+            mixed = (strcmp(v, "mixed") == 0);
+        } else if ((v = laplace_arg_value(argv[arg], "--check-every"))) {
+            check_spec = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--check-lag"))) {
+            char *end;
+            long lag = strtol(v, &end, 10);
+            if (end == v || *end != '\0' || lag < 0 || lag > INT_MAX) {
+                if (my_PE_num == 0) fprintf(stderr, "--check-lag=%s must be an integer >= 0\n", v);
+                MPI_Barrier(MPI_COMM_WORLD);   // let PE 0 report first
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            check_lag = (int)lag;
+        } else if ((v = laplace_arg_value(argv[arg], "--checkpoint-every"))) {
+            checkpoint_every = (int)laplace_parse_size(v, "--checkpoint-every");
+        } else if ((v = laplace_arg_value(argv[arg], "--checkpoint-codec"))) {
+            if (strcmp(v, "xor") == 0) checkpoint_encoding = CKPT_XOR;
+            else if (strcmp(v, "raw") != 0) {
+                if (my_PE_num == 0) fprintf(stderr, "Unknown checkpoint codec '%s' (raw, xor)\n", v);
+                MPI_Barrier(MPI_COMM_WORLD);   // let PE 0 report first
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        } else if ((v = laplace_arg_value(argv[arg], "--checkpoint"))) {
+            checkpoint_path = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--restart"))) {
+            restart_path = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--analysis-every"))) {
+            analysis_every = (int)laplace_parse_size(v, "--analysis-every");
+        } else if ((v = laplace_arg_value(argv[arg], "--analysis"))) {
+            analysis_prefix = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--decimate"))) {
+            decimate = laplace_parse_size(v, "--decimate");
+        } else if ((v = laplace_arg_value(argv[arg], "--isotherms"))) {
+            isotherms = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--halo-depth"))) {
+            depth = (int)laplace_parse_size(v, "--halo-depth");
+        } else if ((v = laplace_arg_value(argv[arg], "--halo"))) {
+            if (strcmp(v, "shm") == 0) halo = HALO_SHM;
+            else if (strcmp(v, "put") == 0) halo = HALO_PUT;
+            else if (strcmp(v, "isend") != 0) {
+                if (my_PE_num == 0) fprintf(stderr, "Unknown halo exchange '%s' (isend, shm, put)\n", v);
+                MPI_Barrier(MPI_COMM_WORLD);   // let PE 0 report first
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+    }
+    if (halo != HALO_ISEND && (mixed || depth > 1)) {
+        if (my_PE_num == 0) fprintf(stderr, "--halo=shm and --halo=put need the default precision and halo depth\n");
+        MPI_Barrier(MPI_COMM_WORLD);   // let PE 0 report first
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if ((check_spec || check_lag > 0) && (mixed || depth > 1)) {
+        if (my_PE_num == 0) fprintf(stderr, "--check-every and --check-lag need the default precision and halo depth\n");
+        MPI_Barrier(MPI_COMM_WORLD);   // let PE 0 report first
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if ((checkpoint_path || analysis_prefix || trace_path || telemetry_spec) && (mixed || depth > 1)) {
+        if (my_PE_num == 0) fprintf(stderr, "--checkpoint, --analysis, --trace and --telemetry need the default precision and halo depth\n");
+        MPI_Barrier(MPI_COMM_WORLD);   // let PE 0 report first
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (mixed && depth > 1) {
+        if (my_PE_num == 0) fprintf(stderr, "--halo-depth is not available with --precision=mixed\n");
+        MPI_Barrier(MPI_COMM_WORLD);   // let PE 0 report first
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    // the mixed helpers index the plate with a COLUMNS+2 stride
+    if (mixed) pitch = laplace_grid_pitch(COLUMNS, LAPLACE_PITCH_PACKED);
+    simd = laplace_simd_select(simd_name);
+    if (my_PE_num == 0) {
+        if (simd_report) laplace_simd_report(COLUMNS);
+        if (mixed) printf("Precision: mixed (float sweeps, double refinement)\n");
+        else printf("Row kernels: %s\n", simd->name);
+        printf("Row pitch: %" PRId64 " doubles\n", pitch);
+        if (depth > 1) printf("Halo depth: %d\n", depth);
+    }
+    laplace_check_init(&check, check_spec, MAX_TEMP_ERROR);
+
     // Calculate dynamic load balancing
-    rows_per_process = ROWS_GLOBAL / npes;
-    extra_rows = ROWS_GLOBAL % npes;
+    rows_per_process = ROWS / npes;
+    extra_rows = ROWS % npes;
     
     // Distribute extra rows to first few processes
     if (my_PE_num < extra_rows) {
@@ -92,18 +340,73 @@ int main(int argc, char *argv[]) {
                        (my_PE_num - extra_rows) * rows_per_process;
     }
 
-    // Allocate dynamic memory
-    Temperature = (double (*)[COLUMNS+2])malloc((my_rows+2) * (COLUMNS+2) * sizeof(double));
-    Temperature_last = (double (*)[COLUMNS+2])malloc((my_rows+2) * (COLUMNS+2) * sizeof(double));
-    
-    if (!Temperature || !Temperature_last) {
+    // every PE has at least rows_per_process rows, so all agree on this
+    if (rows_per_process < depth) {
+        if (my_PE_num == 0) fprintf(stderr, "--halo-depth=%d is deeper than a PE's %" PRId64 " rows\n",
+                                    depth, rows_per_process);
+        MPI_Barrier(MPI_COMM_WORLD);   // let PE 0 report first
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    bench_start(&bench);
+
+    // Allocate dynamic memory (after parsing: the row type depends on the pitch).
+    // Deep halos add depth-1 more ghost rows on each side, rows 1-depth..0
+    // and my_rows+1..my_rows+depth, so real rows keep indices 1..my_rows.
+    double (*grid_a)[pitch];
+    double (*grid_b)[pitch];
+    if (my_PE_num != 0) up_rows = rows_per_process + (my_PE_num-1 < extra_rows ? 1 : 0);
+    if (my_PE_num != npes-1) down_rows = rows_per_process + (my_PE_num+1 < extra_rows ? 1 : 0);
+    if (halo == HALO_SHM) {
+        // both grids in one shared segment, placed near this PE
+        MPI_Info info;
+        double *base;
+        MPI_Info_create(&info);
+        MPI_Info_set(info, "alloc_shared_noncontig", "true");
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, my_PE_num, MPI_INFO_NULL, &node_comm);
+        MPI_Win_allocate_shared(2 * (my_rows+2) * pitch * (MPI_Aint)sizeof(double), sizeof(double), info,
+                                node_comm, &base, &shm_win);
+        MPI_Info_free(&info);
+        grid_a = (double (*)[pitch])base;
+        grid_b = grid_a + (my_rows+2);
+
+        if (my_PE_num != 0) shm_up = shm_neighbour(shm_win, node_comm, my_PE_num-1);
+        if (my_PE_num != npes-1) shm_down = shm_neighbour(shm_win, node_comm, my_PE_num+1);
+
+        // passive epoch for the whole run, MPI_Win_sync orders the loads and stores
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, shm_win);
+        if (my_PE_num == 0) {
+            int node_pes;
+            MPI_Comm_size(node_comm, &node_pes);
+            printf("Halo exchange: shm, %d PEs on PE 0's node\n", node_pes);
+        }
+    } else if (halo == HALO_PUT) {
+        // both grids in one window, so a put names the buffer by offset
+        double *base;
+        MPI_Win_allocate(2 * (my_rows+2) * pitch * (MPI_Aint)sizeof(double), sizeof(double), MPI_INFO_NULL,
+                         MPI_COMM_WORLD, &base, &put_win);
+        grid_a = (double (*)[pitch])base;
+        grid_b = grid_a + (my_rows+2);
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, put_win);
+        if (my_PE_num == 0) printf("Halo exchange: put\n");
+    } else {
+        grid_a = laplace_alloc_pitched_grid(my_rows + 2*(depth-1), pitch);
+        grid_b = laplace_alloc_pitched_grid(my_rows + 2*(depth-1), pitch);
+    }
+    double (*Temperature)[pitch] = grid_a + (depth-1);
+    double (*Temperature_last)[pitch] = grid_b + (depth-1);
+
+    if (!grid_a || !grid_b) {
         printf("PE %d: Memory allocation failed\n", my_PE_num);
         MPI_Finalize();
         exit(1);
     }
 
+    if (analysis_prefix) laplace_analysis_init(&analysis, analysis_prefix, analysis_every, decimate,
+                                               isotherms, ROWS, COLUMNS, my_rows+1, my_PE_num == 0);
+
     // PE 0 asks for input
-    if(my_PE_num==0) {
+    if(my_PE_num==0 && max_iterations < 0) {
         printf("Maximum iterations [100-4000]?\n");
         printf("Running on %d processes with dynamic load balancing\n", npes);
         fflush(stdout);
@@ -115,111 +418,357 @@ int main(int argc, char *argv[]) {
 
     if (my_PE_num==0) gettimeofday(&start_time,NULL);
 
-    initialize(npes, my_PE_num, my_rows);
+    // both buffers: after the first swap Temperature holds the boundaries
+    initialize(npes, my_PE_num, my_rows, pitch, Temperature_last);
+    initialize(npes, my_PE_num, my_rows, pitch, Temperature);
+    if (restart_path) {
+        // any PE count may resume: each reads its own rows of the interior
+        double restart_wtime = MPI_Wtime();
+        if (read_checkpoint(restart_path, my_PE_num, my_rows, my_start_row,
+                            &iteration, &dt_global, pitch, Temperature_last) != 0) {
+            MPI_Barrier(MPI_COMM_WORLD);   // let PE 0 report first
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        if (my_PE_num == 0) printf("Restarted from %s at iteration %d (%.3f s)\n",
+                                   restart_path, iteration, MPI_Wtime() - restart_wtime);
+        iteration++;
+    }
+    if (halo == HALO_SHM) {
+        // neighbours read these rows from the first iteration on
+        MPI_Win_sync(shm_win);
+        MPI_Barrier(node_comm);
+        MPI_Win_sync(shm_win);
+    }
+    if (halo == HALO_PUT) {
+        // ghost rows for the first iteration: Temperature is grid_a
+        put_edge_rows(put_win, npes, my_PE_num, my_rows, up_rows, down_rows, 0, pitch, Temperature_last);
+        MPI_Win_flush_all(put_win);
+        MPI_Win_sync(put_win);
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Win_sync(put_win);
+    }
+    msg_up = (my_PE_num != 0) && !shm_up && halo != HALO_PUT;
+    msg_down = (my_PE_num != npes-1) && !shm_down && halo != HALO_PUT;
+    bench_lap(&bench, BENCH_INIT);
 
-    while ( dt_global > MAX_TEMP_ERROR && iteration <= max_iterations ) {
+    if (mixed) {
+        laplace_mixed_init(&m, my_rows, COLUMNS, Temperature_last);
+        exchange_ghost_rows(m.u, MPI_DOUBLE, sizeof(double), npes, my_PE_num, my_rows);
+        laplace_mixed_residual(&m);
+    }
+
+    if (depth > 1) {
+        iteration = deep_halo_solve(npes, my_PE_num, my_rows, depth, iteration-1, max_iterations, simd,
+                                    pitch, Temperature, Temperature_last, &dt_global) + 1;
+    }
+
+    // mixed precision: half the bytes per sweep and per ghost row
+    while ( mixed && dt_global > MAX_TEMP_ERROR && iteration <= max_iterations ) {
+
+        exchange_ghost_rows(m.e, MPI_FLOAT, sizeof(float), npes, my_PE_num, my_rows);
+        dt = laplace_mixed_sweep(&m);
+        MPI_Allreduce(&dt, &dt_global, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+        // refine in double where the progress is printed
+        if((iteration % 100) == 0) {
+            laplace_mixed_fold(&m);
+            exchange_ghost_rows(m.u, MPI_DOUBLE, sizeof(double), npes, my_PE_num, my_rows);
+            laplace_mixed_residual(&m);
+            if (my_PE_num == npes-1){
+                track_progress(iteration, my_rows, pitch, Temperature_last);
+            }
+        }
+
+        iteration++;
+    }
+    if (mixed) {
+        laplace_mixed_fold(&m);
+        laplace_mixed_free(&m);
+    }
+    bench_lap(&bench, BENCH_COMPUTE);   // mixed and deep halos count as compute
+
+    // one timeline per PE, started together
+    if (trace_path) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        laplace_trace_open(&trace, trace_path, my_PE_num, 1, trace_events);
+    } else {
+        laplace_trace_open(&trace, NULL, my_PE_num, 1, 0);
+    }
+    laplace_telemetry_open(&telemetry, telemetry_spec, my_PE_num, npes, 1);
+
+    while ( !mixed && depth == 1 && dt_global > MAX_TEMP_ERROR && iteration <= max_iterations ) {
 
         // PHASE 1: Start non-blocking communication for ghost rows
+        // (shared-window neighbours and puts need no messages)
         req_count = 0;
         
         // Send bottom real row down and receive top ghost row
-        if(my_PE_num != npes-1) {
+        if(msg_down) {
             MPI_Isend(&Temperature_last[my_rows][1], COLUMNS, MPI_DOUBLE, 
                      my_PE_num+1, DOWN, MPI_COMM_WORLD, &requests[req_count++]);
         }
-        if(my_PE_num != 0) {
+        if(msg_up) {
             MPI_Irecv(&Temperature[0][1], COLUMNS, MPI_DOUBLE, 
                      my_PE_num-1, DOWN, MPI_COMM_WORLD, &requests[req_count++]);
         }
         
         // Send top real row up and receive bottom ghost row
-        if(my_PE_num != 0) {
+        if(msg_up) {
             MPI_Isend(&Temperature_last[1][1], COLUMNS, MPI_DOUBLE, 
                      my_PE_num-1, UP, MPI_COMM_WORLD, &requests[req_count++]);
         }
-        if(my_PE_num != npes-1) {
+        if(msg_down) {
             MPI_Irecv(&Temperature[my_rows+1][1], COLUMNS, MPI_DOUBLE, 
                      my_PE_num+1, UP, MPI_COMM_WORLD, &requests[req_count++]);
         }
+        bench_lap(&bench, BENCH_HALO);
+        laplace_trace_lap(&trace, TRACE_HALO_POST, iteration);
 
         // PHASE 2: Calculate interior points (can overlap with communication)
         // Interior points don't need ghost cells
         for(i = 2; i < my_rows; i++) {
-            for(j = 1; j <= COLUMNS; j++) {
-                Temperature[i][j] = 0.25 * (Temperature_last[i+1][j] + Temperature_last[i-1][j] +
-                                           Temperature_last[i][j+1] + Temperature_last[i][j-1]);
-            }
+            simd->stencil(&Temperature[i][1], &Temperature_last[i-1][1],
+                          &Temperature_last[i][1], &Temperature_last[i+1][1], COLUMNS);
         }
 
         // PHASE 3: Wait for communication completion
+        bench_lap(&bench, BENCH_COMPUTE);
+        laplace_trace_lap(&trace, TRACE_SWEEP, iteration);
         if (req_count > 0) {
             MPI_Waitall(req_count, requests, MPI_STATUSES_IGNORE);
         }
+        bench_lap(&bench, BENCH_HALO);
+        laplace_trace_lap(&trace, TRACE_WAIT, iteration);
 
         // PHASE 4: Calculate boundary rows that need ghost cells
-        // Top boundary row (row 1)
-        for(j = 1; j <= COLUMNS; j++) {
-            Temperature[1][j] = 0.25 * (Temperature_last[2][j] + Temperature[0][j] +
-                                       Temperature_last[1][j+1] + Temperature_last[1][j-1]);
+        // Ghost rows arrived in Temperature[0] and Temperature[my_rows+1];
+        // on-node neighbours' edge rows are read in place from the buffer
+        // matching my Temperature_last, as every PE swaps in step
+        const double *above = &Temperature[0][1];
+        const double *below = &Temperature[my_rows+1][1];
+        if (shm_up || shm_down) {
+            int64_t buffer = (Temperature_last == grid_a) ? 0 : 1;
+            if (shm_up) above = shm_up + (buffer*(up_rows+2) + up_rows) * pitch + 1;
+            if (shm_down) below = shm_down + (buffer*(down_rows+2) + 1) * pitch + 1;
         }
+
+        // Top boundary row (row 1)
+        simd->stencil(&Temperature[1][1], above,
+                      &Temperature_last[1][1], &Temperature_last[2][1], COLUMNS);
         
         // Bottom boundary row (row my_rows)
-        for(j = 1; j <= COLUMNS; j++) {
-            Temperature[my_rows][j] = 0.25 * (Temperature[my_rows+1][j] + Temperature_last[my_rows-1][j] +
-                                             Temperature_last[my_rows][j+1] + Temperature_last[my_rows][j-1]);
+        simd->stencil(&Temperature[my_rows][1], &Temperature_last[my_rows-1][1],
+                      &Temperature_last[my_rows][1], below, COLUMNS);
+
+        // put: push the new edge rows now so they travel during the dt
+        // sweep; they land in the neighbours' ghost rows of the buffer that
+        // becomes their Temperature next iteration (my Temperature_last)
+        bench_lap(&bench, BENCH_COMPUTE);
+        laplace_trace_lap(&trace, TRACE_BOUNDARY, iteration);
+        if (halo == HALO_PUT) {
+            put_edge_rows(put_win, npes, my_PE_num, my_rows, up_rows, down_rows,
+                          (Temperature_last == grid_a) ? 0 : 1, pitch, Temperature);
+            bench_lap(&bench, BENCH_HALO);
+            laplace_trace_lap(&trace, TRACE_HALO_POST, iteration);
         }
 
-        // PHASE 5: Calculate convergence with loop fusion and pointer swapping
-        dt = 0.0;
-        for(i = 1; i <= my_rows; i++){
-            for(j = 1; j <= COLUMNS; j++){
-                dt = fmax(fabs(Temperature[i][j] - Temperature_last[i][j]), dt);
+        // PHASE 5: Calculate convergence with loop fusion and pointer swapping,
+        // on the iterations the check policy asks for and no dt is in flight
+        int measure = laplace_check_due(&check, iteration) && dt_request == MPI_REQUEST_NULL;
+        if (measure) {
+            dt = 0.0;
+            for(i = 1; i <= my_rows; i++){
+                dt = fmax(simd->maxdiff(&Temperature[i][1], &Temperature_last[i][1], COLUMNS), dt);
             }
         }
 
         // Pointer swapping instead of array copying
-        double (*temp_ptr)[COLUMNS+2] = Temperature_last;
+        double (*temp_ptr)[pitch] = Temperature_last;
         Temperature_last = Temperature;
         Temperature = temp_ptr;
 
-        // find global dt using AllReduce (more efficient than Reduce+Bcast)
-        MPI_Allreduce(&dt, &dt_global, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        // find global dt using AllReduce (more efficient than Reduce+Bcast).
+        // It also orders the windows: nobody reads a ghost row before its
+        // put was flushed, nobody overwrites a shared buffer before every
+        // neighbour has read it, and the syncs publish the rows. Without
+        // it, an empty message to each neighbour gives the same order
+        bench_lap(&bench, BENCH_REDUCTION);
+        laplace_trace_lap(&trace, TRACE_REDUCTION, iteration);
+        if (halo != HALO_ISEND) {
+            if (halo == HALO_PUT) {
+                MPI_Win_flush_all(put_win);
+                MPI_Win_sync(put_win);
+            }
+            if (halo == HALO_SHM) MPI_Win_sync(shm_win);
+            if (!(measure && check_lag == 0)) neighbour_sync(npes, my_PE_num);
+            laplace_trace_lap(&trace, TRACE_WAIT, iteration);
+        }
+        bench_lap(&bench, BENCH_HALO);
+        if (measure && check_lag == 0) {
+            MPI_Allreduce(&dt, &dt_global, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+            laplace_check_update(&check, iteration, dt_global);
+            laplace_trace_lap(&trace, TRACE_REDUCTION, iteration);
+        }
+        bench_lap(&bench, BENCH_REDUCTION);
+        if (halo == HALO_SHM) MPI_Win_sync(shm_win);
+        if (halo == HALO_PUT) MPI_Win_sync(put_win);
+        bench_lap(&bench, BENCH_HALO);
+
+        // pipelined checks: start a reduction now, read it check_lag
+        // iterations later; the loop test sees the result only then
+        if (check_lag > 0) {
+            if (measure) {
+                dt_send = dt;
+                dt_iteration = iteration;
+                MPI_Iallreduce(&dt_send, &dt_recv, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD, &dt_request);
+            } else if (dt_request != MPI_REQUEST_NULL && iteration >= dt_iteration + check_lag) {
+                MPI_Wait(&dt_request, MPI_STATUS_IGNORE);
+                dt_global = dt_recv;
+                laplace_check_update(&check, dt_iteration, dt_global);
+                if (dt_global <= MAX_TEMP_ERROR) converged_at = dt_iteration;
+            }
+            laplace_trace_lap(&trace, TRACE_REDUCTION, iteration);
+        }
+        bench_lap(&bench, BENCH_REDUCTION);
+        laplace_trace_mark(&trace);
 
         // periodically print test values - only for PE in lower corner
-        if((iteration % 100) == 0) {
+        if (telemetry.enabled) {
+            if ((iteration % telemetry_every) == 0) {
+                laplace_telemetry_record r;
+                laplace_telemetry_record_init(&telemetry, &r, iteration, dt_global, bench.seconds);
+                if (my_PE_num == npes-1) sample_progress(&r, my_rows, pitch, Temperature_last);
+                laplace_telemetry_push(&telemetry, &r);
+            }
+        } else if((iteration % 100) == 0) {
             if (my_PE_num == npes-1){
-                track_progress(iteration, my_rows);
+                track_progress(iteration, my_rows, pitch, Temperature_last);
             }
         }
 
+        // periodically save the grid for a restart
+        if (checkpoint_path && (iteration % checkpoint_every) == 0) {
+            double file_bytes;
+            checkpoint_time += write_checkpoint(checkpoint_path, npes, my_PE_num, my_rows, my_start_row,
+                                                checkpoint_encoding, iteration, dt_global,
+                                                pitch, Temperature_last, &file_bytes);
+            checkpoint_bytes += file_bytes;
+            checkpoints++;
+        }
+
+        // in-situ analysis: only the reduced results reach PE 0
+        if (analysis_prefix && analysis_every && (iteration % analysis_every) == 0) {
+            analyze(&analysis, npes, my_PE_num, my_rows, my_start_row, iteration, pitch, Temperature_last);
+        }
+        bench_lap(&bench, BENCH_OUTPUT);
+        laplace_trace_lap(&trace, TRACE_OUTPUT, iteration);
+
         iteration++;
     }
 
+    // a reduction still in flight at max_iterations is not needed
+    if (dt_request != MPI_REQUEST_NULL) MPI_Wait(&dt_request, MPI_STATUS_IGNORE);
+
+    // the sinks finish the progress lines before the summary
+    int64_t telemetry_pushed, telemetry_dropped;
+    laplace_telemetry_close(&telemetry, &telemetry_pushed, &telemetry_dropped);
+
     // Slightly more accurate timing and cleaner output 
     MPI_Barrier(MPI_COMM_WORLD);
+    bench_lap(&bench, BENCH_REDUCTION);
+
+    // the slowest PE's halo time, before PE 0 stops the clock
+    double halo_max;
+    MPI_Reduce(&bench.seconds[BENCH_HALO], &halo_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
 
     // PE 0 finish timing and output values
     if (my_PE_num==0){
         gettimeofday(&stop_time,NULL);
         timersub(&stop_time, &start_time, &elapsed_time);
 
-        printf("\nMax error at iteration %d was %f\n", iteration-1, dt_global);
+        printf("\nMax error at iteration %d was %f\n", converged_at ? converged_at : iteration-1, dt_global);
         printf("Total time was %f seconds.\n", elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0);
-        printf("Grid size: %dx%d, Processes: %d\n", ROWS_GLOBAL, COLUMNS, npes);
+        printf("Grid size: %" PRId64 "x%" PRId64 ", Processes: %d\n", (int64_t)ROWS, (int64_t)COLUMNS, npes);
+        if (check_spec || check_lag > 0)
+            printf("Convergence checks: %d (%s, lag %d), iterations run: %d\n", check.checks,
+                   laplace_check_name(&check, check_name, sizeof(check_name)), check_lag, iteration-1);
+        if (!mixed && depth == 1 && iteration > 1)
+            printf("Halo time per iteration: %.2f us\n", halo_max * 1e6 / (iteration-1));
+        if (checkpoints > 0) {
+            double seconds = elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0;
+            double bytes = CKPT_HEADER + (double)ROWS * COLUMNS * sizeof(double);
+            printf("Checkpoints: %d to %s, %.3f s each, %.2f GB/s, %.1f%% of the run\n",
+                   checkpoints, checkpoint_path, checkpoint_time / checkpoints,
+                   bytes * checkpoints / checkpoint_time / 1e9, 100.0 * checkpoint_time / seconds);
+            if (checkpoint_encoding == CKPT_XOR)
+                printf("Checkpoint codec: xor, ratio %.2f (GB/s above in raw cells)\n",
+                       bytes * checkpoints / checkpoint_bytes);
+        }
+    }
+
+    if (analysis_prefix) {
+        analyze(&analysis, npes, my_PE_num, my_rows, my_start_row,
+                converged_at ? converged_at : iteration-1, pitch, Temperature_last);
+        laplace_analysis_close(&analysis);
+    }
+
+    // each phase of the slowest PE, and the memory of all of them
+    if (bench_line) {
+        double bench_max[BENCH_PHASES], total, total_max;
+        long rss = bench_peak_rss(), rss_sum;
+        bench_lap(&bench, BENCH_OUTPUT);
+        total = bench_total(&bench);
+        MPI_Reduce(bench.seconds, bench_max, BENCH_PHASES, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&total, &total_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&rss, &rss_sum, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (my_PE_num == 0)
+            bench_report(bench_max, total_max, (double)ROWS * COLUMNS * (iteration-1),
+                         rss_sum, npes);
+    }
+
+    if (telemetry_spec) {
+        int64_t counts[2] = {telemetry_pushed, telemetry_dropped}, sums[2];
+        MPI_Reduce(counts, sums, 2, MPI_INT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (my_PE_num == 0)
+            printf("Telemetry: %" PRId64 " records (%" PRId64 " dropped) from %d PEs to %s\n",
+                   sums[0], sums[1], npes, telemetry_spec);
+    }
+
+    // every PE writes its part, then PE 0 merges them into one file
+    if (trace_path) {
+        int64_t events = laplace_trace_write_part(&trace, trace_path), events_sum;
+        int64_t dropped = laplace_trace_dropped(&trace), dropped_sum;
+        MPI_Reduce(&events, &events_sum, 1, MPI_INT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&dropped, &dropped_sum, 1, MPI_INT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (my_PE_num == 0) {
+            laplace_trace_merge(trace_path, npes);
+            printf("Trace: %" PRId64 " events (%" PRId64 " dropped) from %d PEs to %s\n",
+                   events_sum, dropped_sum, npes, trace_path);
+        }
+        laplace_trace_free(&trace);
     }
 
     // Clean up dynamic memory
-    free(Temperature);
-    free(Temperature_last);
+    if (halo == HALO_SHM) {
+        MPI_Win_unlock_all(shm_win);
+        MPI_Win_free(&shm_win);
+        MPI_Comm_free(&node_comm);
+    } else if (halo == HALO_PUT) {
+        MPI_Win_unlock_all(put_win);
+        MPI_Win_free(&put_win);
+    } else {
+        free(grid_a);
+        free(grid_b);
+    }
 
     MPI_Finalize();
     return 0;
 }
 
-void initialize(int npes, int my_PE_num, int my_rows){
+void initialize(int npes, int my_PE_num, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]){
 
     double tMin, tMax;  //Local boundary limits
-    int i,j;
+    int64_t i, j;
 
     // Initialize all cells to 0.0
     for(i = 0; i <= my_rows+1; i++){
@@ -229,9 +778,9 @@ void initialize(int npes, int my_PE_num, int my_rows){
     }
 
     // Calculate this PE's portion of the global boundary
-    int rows_per_process = ROWS_GLOBAL / npes;
-    int extra_rows = ROWS_GLOBAL % npes;
-    int my_start_row;
+    int64_t rows_per_process = ROWS / npes;
+    int64_t extra_rows = ROWS % npes;
+    int64_t my_start_row;
     
     if (my_PE_num < extra_rows) {
         my_start_row = my_PE_num * (rows_per_process + 1);
@@ -241,8 +790,8 @@ void initialize(int npes, int my_PE_num, int my_rows){
     }
 
     // Local boundary condition endpoints
-    tMin = my_start_row * 100.0 / ROWS_GLOBAL;
-    tMax = (my_start_row + my_rows) * 100.0 / ROWS_GLOBAL;
+    tMin = my_start_row * 100.0 / ROWS;
+    tMax = (my_start_row + my_rows) * 100.0 / ROWS;
 
     // Left and right boundaries
     for (i = 0; i <= my_rows+1; i++) {
@@ -261,16 +810,507 @@ void initialize(int npes, int my_PE_num, int my_rows){
             Temperature_last[my_rows+1][j] = (100.0/COLUMNS) * j;
 }
 
+// swap the first and last real rows with the neighbouring PEs; edge PEs
+// keep their boundary rows. Rows are (COLUMNS+2) cells of cell_bytes.
+void exchange_ghost_rows(void *grid, MPI_Datatype type, size_t cell_bytes,
+                         int npes, int my_PE_num, int64_t my_rows) {
+
+    char *rows = grid;
+    size_t row_bytes = (size_t)(COLUMNS+2) * cell_bytes;
+    int up   = (my_PE_num != 0)      ? my_PE_num-1 : MPI_PROC_NULL;
+    int down = (my_PE_num != npes-1) ? my_PE_num+1 : MPI_PROC_NULL;
+
+    MPI_Sendrecv(rows + my_rows*row_bytes + cell_bytes, COLUMNS, type, down, DOWN,
+                 rows + cell_bytes, COLUMNS, type, up, DOWN,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(rows + row_bytes + cell_bytes, COLUMNS, type, up, UP,
+                 rows + (my_rows+1)*row_bytes + cell_bytes, COLUMNS, type, down, UP,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+}
+
+// both grids of a world rank in the node's shared window, NULL when it
+// lives on another node
+double *shm_neighbour(MPI_Win win, MPI_Comm node, int world_rank) {
+
+    MPI_Group world_group, node_group;
+    MPI_Aint size;
+    int disp_unit, node_rank;
+    double *base = NULL;
+
+    MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+    MPI_Comm_group(node, &node_group);
+    MPI_Group_translate_ranks(world_group, 1, &world_rank, node_group, &node_rank);
+    if (node_rank != MPI_UNDEFINED) {
+        MPI_Win_shared_query(win, node_rank, &size, &disp_unit, &base);
+    }
+    MPI_Group_free(&world_group);
+    MPI_Group_free(&node_group);
+    return base;
+}
+
+// put my edge rows 1 and my_rows into the neighbours' ghost rows of their
+// grid `buffer` (0 or 1, each grid is rows+2 rows of pitch doubles);
+// completes at the next MPI_Win_flush_all
+void put_edge_rows(MPI_Win win, int npes, int my_PE_num, int64_t my_rows, int64_t up_rows,
+                   int64_t down_rows, int64_t buffer, int64_t pitch, double (*Temperature)[pitch]) {
+
+    if (my_PE_num != 0) {
+        MPI_Aint ghost = (buffer*(up_rows+2) + up_rows+1) * pitch + 1;
+        MPI_Put(&Temperature[1][1], COLUMNS, MPI_DOUBLE, my_PE_num-1,
+                ghost, COLUMNS, MPI_DOUBLE, win);
+    }
+    if (my_PE_num != npes-1) {
+        MPI_Aint ghost = (buffer*(down_rows+2)) * pitch + 1;
+        MPI_Put(&Temperature[my_rows][1], COLUMNS, MPI_DOUBLE, my_PE_num+1,
+                ghost, COLUMNS, MPI_DOUBLE, win);
+    }
+}
+
+// empty messages to and from both neighbours: every window access either
+// side made before the call is ordered before every access after it
+void neighbour_sync(int npes, int my_PE_num) {
+
+    int up = (my_PE_num != 0) ? my_PE_num-1 : MPI_PROC_NULL;
+    int down = (my_PE_num != npes-1) ? my_PE_num+1 : MPI_PROC_NULL;
+
+    MPI_Sendrecv(NULL, 0, MPI_BYTE, down, DOWN, NULL, 0, MPI_BYTE, up, DOWN,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(NULL, 0, MPI_BYTE, up, UP, NULL, 0, MPI_BYTE, down, UP,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+}
+
+// this PE's rows of the global interior in the file, and the same cells
+// in its grid, rows 1..my_rows and columns 1..COLUMNS. Subarray types
+// take int sizes, so a plate past INT_MAX rows or columns aborts here;
+// the limit can trip on some PEs only, so each one reports for itself
+static void checkpoint_types(int64_t my_rows, int64_t my_start_row, int64_t pitch,
+                             MPI_Datatype *file_type, MPI_Datatype *grid_type) {
+
+    if (ROWS > INT_MAX || pitch > INT_MAX || my_rows+2 > INT_MAX || my_start_row > INT_MAX) {
+        int my_PE_num;
+        MPI_Comm_rank(MPI_COMM_WORLD, &my_PE_num);
+        fprintf(stderr, "PE %d: a %" PRId64 "x%" PRId64 " plate is too large for a raw checkpoint, "
+                "use --checkpoint-codec=xor\n", my_PE_num, (int64_t)ROWS, (int64_t)COLUMNS);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int global[2] = {(int)ROWS, (int)COLUMNS};
+    int local[2]  = {(int)my_rows+2, (int)pitch};
+    int mine[2]   = {(int)my_rows, (int)COLUMNS};
+    int file_start[2] = {(int)my_start_row, 0};
+    int grid_start[2] = {1, 1};
+
+    MPI_Type_create_subarray(2, global, mine, file_start, MPI_ORDER_C, MPI_DOUBLE, file_type);
+    MPI_Type_create_subarray(2, local, mine, grid_start, MPI_ORDER_C, MPI_DOUBLE, grid_type);
+    MPI_Type_commit(file_type);
+    MPI_Type_commit(grid_type);
+}
+
+// collective: write Temperature_last to path.tmp, then rename it over
+// path so a job killed mid-write keeps the previous checkpoint.
+// Returns the seconds it took this PE, and the file size in file_bytes
+double write_checkpoint(const char *path, int npes, int my_PE_num, int64_t my_rows, int64_t my_start_row,
+                        int encoding, int iteration, double dt_global,
+                        int64_t pitch, double (*Temperature_last)[pitch], double *file_bytes) {
+
+    MPI_Datatype file_type, grid_type;
+    MPI_File fh;
+    char tmp[4096];
+    double wtime = MPI_Wtime();
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    if (MPI_File_open(MPI_COMM_WORLD, tmp, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                      MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        if (my_PE_num == 0) fprintf(stderr, "Cannot write checkpoint %s\n", tmp);
+        MPI_Barrier(MPI_COMM_WORLD);   // let PE 0 report first
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_File_set_size(fh, 0);
+
+    if (my_PE_num == 0) {
+        checkpoint_header header = {0};
+        memcpy(header.magic, CKPT_MAGIC, sizeof(header.magic));
+        header.rows = ROWS;
+        header.columns = COLUMNS;
+        header.iteration = iteration;
+        header.dt = dt_global;
+        header.encoding = encoding;
+        header.segments = (encoding == CKPT_XOR) ? npes : 0;
+        MPI_File_write_at(fh, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+
+    if (encoding == CKPT_XOR) {
+        // streams differ in length: an exclusive scan places them, and
+        // the table tells a restart on any PE count where each one is
+        unsigned char *stream = malloc(laplace_codec_bound(my_rows, COLUMNS));
+        checkpoint_segment segment;
+        int64_t bytes, before = 0, total;
+        MPI_Offset data = CKPT_HEADER + (MPI_Offset)npes * sizeof(checkpoint_segment);
+
+        bytes = laplace_codec_encode(&Temperature_last[1][1], pitch, my_rows, COLUMNS, stream, 1);
+        if (bytes > INT32_MAX) {
+            fprintf(stderr, "PE %d: checkpoint segment over 2 GB, use --checkpoint-codec=raw\n", my_PE_num);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        MPI_Exscan(&bytes, &before, 1, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+        if (my_PE_num == 0) before = 0;
+        MPI_Allreduce(&bytes, &total, 1, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+        segment.start_row = my_start_row;
+        segment.rows = my_rows;
+        segment.offset = data + before;
+        segment.bytes = bytes;
+        MPI_File_write_at_all(fh, CKPT_HEADER + (MPI_Offset)my_PE_num * sizeof(segment),
+                              &segment, 4, MPI_INT64_T, MPI_STATUS_IGNORE);
+        MPI_File_write_at_all(fh, segment.offset, stream, (int)bytes, MPI_BYTE, MPI_STATUS_IGNORE);
+        free(stream);
+        *file_bytes = data + total;
+    } else {
+        checkpoint_types(my_rows, my_start_row, pitch, &file_type, &grid_type);
+        MPI_File_set_view(fh, CKPT_HEADER, MPI_DOUBLE, file_type, "native", MPI_INFO_NULL);
+        MPI_File_write_at_all(fh, 0, Temperature_last, 1, grid_type, MPI_STATUS_IGNORE);
+        MPI_Type_free(&file_type);
+        MPI_Type_free(&grid_type);
+        *file_bytes = CKPT_HEADER + (double)ROWS * COLUMNS * sizeof(double);
+    }
+    MPI_File_close(&fh);
+
+    if (my_PE_num == 0 && rename(tmp, path) != 0) perror(path);
+    return MPI_Wtime() - wtime;
+}
+
+// xor checkpoint: decode every segment that holds some of my rows and
+// keep those rows; returns non-zero on a damaged file
+static int read_checkpoint_segments(MPI_File fh, int64_t segments, int64_t my_rows, int64_t my_start_row,
+                                    int64_t pitch, double (*Temperature_last)[pitch]) {
+
+    checkpoint_segment *table = malloc(segments * sizeof(checkpoint_segment));
+    int64_t s, g, bad = 0;
+
+    MPI_File_read_at_all(fh, CKPT_HEADER, table, (int)(4 * segments), MPI_INT64_T, MPI_STATUS_IGNORE);
+    for (s = 0; s < segments && !bad; s++) {
+        int64_t lo = (table[s].start_row > my_start_row) ? table[s].start_row : my_start_row;
+        int64_t hi = (table[s].start_row + table[s].rows < my_start_row + my_rows) ?
+                      table[s].start_row + table[s].rows : my_start_row + my_rows;
+        if (lo >= hi) continue;
+
+        unsigned char *stream = malloc(table[s].bytes + 8);
+        double *rows = malloc(table[s].rows * COLUMNS * sizeof(double));
+        memset(stream + table[s].bytes, 0, 8);
+        MPI_File_read_at(fh, table[s].offset, stream, (int)table[s].bytes, MPI_BYTE, MPI_STATUS_IGNORE);
+        if (laplace_codec_decode(stream, table[s].bytes, rows, COLUMNS, table[s].rows, COLUMNS, 1) != 0) {
+            bad = 1;
+        } else {
+            for (g = lo; g < hi; g++) {
+                memcpy(&Temperature_last[1 + g - my_start_row][1],
+                       rows + (g - table[s].start_row) * COLUMNS, COLUMNS * sizeof(double));
+            }
+        }
+        free(stream);
+        free(rows);
+    }
+    free(table);
+    return (int)bad;
+}
+
+// collective: fill rows 1..my_rows of Temperature_last from a checkpoint
+// and return the iteration and dt it was written at; non-zero if the file
+// is missing or holds another plate (PE 0 says why)
+int read_checkpoint(const char *path, int my_PE_num, int64_t my_rows, int64_t my_start_row,
+                    int *iteration, double *dt_global, int64_t pitch, double (*Temperature_last)[pitch]) {
+
+    MPI_Datatype file_type, grid_type;
+    MPI_File fh;
+    checkpoint_header header;
+    int bad = 0, any_bad;
+
+    if (MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        if (my_PE_num == 0) fprintf(stderr, "Cannot open checkpoint %s\n", path);
+        return 1;
+    }
+    MPI_File_read_at_all(fh, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+    if (memcmp(header.magic, CKPT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.rows != ROWS || header.columns != COLUMNS) {
+        if (my_PE_num == 0) fprintf(stderr, "%s is not a checkpoint of a %" PRId64 "x%" PRId64 " plate\n",
+                                    path, (int64_t)ROWS, (int64_t)COLUMNS);
+        MPI_File_close(&fh);
+        return 1;
+    }
+
+    if (header.encoding == CKPT_XOR) {
+        bad = read_checkpoint_segments(fh, header.segments, my_rows, my_start_row, pitch, Temperature_last);
+    } else {
+        checkpoint_types(my_rows, my_start_row, pitch, &file_type, &grid_type);
+        MPI_File_set_view(fh, CKPT_HEADER, MPI_DOUBLE, file_type, "native", MPI_INFO_NULL);
+        MPI_File_read_at_all(fh, 0, Temperature_last, 1, grid_type, MPI_STATUS_IGNORE);
+        MPI_Type_free(&file_type);
+        MPI_Type_free(&grid_type);
+    }
+    MPI_File_close(&fh);
+
+    MPI_Allreduce(&bad, &any_bad, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (any_bad) {
+        if (my_PE_num == 0) fprintf(stderr, "%s: damaged codec stream\n", path);
+        return 1;
+    }
+
+    *iteration = (int)header.iteration;
+    *dt_global = header.dt;
+    return 0;
+}
+
+// post a depth-row exchange with both neighbours into Temperature_last's
+// ghost rows; whole rows, so the right boundary column travels too
+static int post_deep_halo(int npes, int my_PE_num, int64_t my_rows, int depth,
+                          int64_t pitch, double (*Temperature_last)[pitch], MPI_Request *requests) {
+
+    int count = (int)(depth * pitch);
+    int n = 0;
+
+    if(my_PE_num != npes-1) {
+        MPI_Isend(&Temperature_last[my_rows-depth+1][0], count, MPI_DOUBLE,
+                  my_PE_num+1, DOWN, MPI_COMM_WORLD, &requests[n++]);
+        MPI_Irecv(&Temperature_last[my_rows+1][0], count, MPI_DOUBLE,
+                  my_PE_num+1, UP, MPI_COMM_WORLD, &requests[n++]);
+    }
+    if(my_PE_num != 0) {
+        MPI_Isend(&Temperature_last[1][0], count, MPI_DOUBLE,
+                  my_PE_num-1, UP, MPI_COMM_WORLD, &requests[n++]);
+        MPI_Irecv(&Temperature_last[1-depth][0], count, MPI_DOUBLE,
+                  my_PE_num-1, DOWN, MPI_COMM_WORLD, &requests[n++]);
+    }
+    return n;
+}
+
+// steps Jacobi iterations from one deep-halo exchange: iteration s
+// (0-based) updates rows lo-s .. hi+s short of the ghost edge, so the
+// last one covers exactly 1..my_rows. Plate edges never shrink. Each
+// iteration's local dt goes in dt_step[s].
+static void deep_halo_block(int npes, int my_PE_num, int64_t my_rows, int depth, int steps,
+                            const laplace_simd_kernels *simd,
+                            int64_t pitch, double (**Temperature)[pitch], double (**Temperature_last)[pitch],
+                            double *dt_step) {
+
+    MPI_Request requests[4];
+    int64_t i, lo, hi;
+    int s, n;
+
+    n = post_deep_halo(npes, my_PE_num, my_rows, depth, pitch, *Temperature_last, requests);
+    MPI_Waitall(n, requests, MPI_STATUSES_IGNORE);
+
+    // the sweeps only write columns 1..COLUMNS, so the other buffer needs
+    // the received boundary columns too
+    for (i = 1-depth; i <= my_rows+depth; i++) {
+        if (i >= 1 && i <= my_rows) continue;
+        if ((i < 1 && my_PE_num == 0) || (i > my_rows && my_PE_num == npes-1)) continue;
+        (*Temperature)[i][0] = (*Temperature_last)[i][0];
+        (*Temperature)[i][COLUMNS+1] = (*Temperature_last)[i][COLUMNS+1];
+    }
+
+    for (s = 0; s < steps; s++) {
+        double (*next)[pitch] = *Temperature;
+        double (*last)[pitch] = *Temperature_last;
+
+        lo = (my_PE_num == 0)      ? 1       : 2 - depth + s;
+        hi = (my_PE_num == npes-1) ? my_rows : my_rows + depth - 1 - s;
+        for (i = lo; i <= hi; i++) {
+            simd->stencil(&next[i][1], &last[i-1][1], &last[i][1], &last[i+1][1], COLUMNS);
+        }
+
+        // dt only over my own rows, as in the one-row exchange
+        dt_step[s] = 0.0;
+        for (i = 1; i <= my_rows; i++) {
+            dt_step[s] = fmax(simd->maxdiff(&next[i][1], &last[i][1], COLUMNS), dt_step[s]);
+        }
+
+        *Temperature_last = next;
+        *Temperature = last;
+    }
+}
+
+// Jacobi with depth-row halos from iteration (already done, non-zero on
+// a restart); returns the number of iterations done.
+// Blocks end on every 100th iteration for track_progress. A block whose
+// global dt crosses MAX_TEMP_ERROR part way is rerun short from a
+// snapshot, so the solve stops on the iteration the one-row exchange
+// would. Snapshots are only taken when the decay of dt says convergence
+// is near, as in the wavefront engine of laplace_omp.c.
+int deep_halo_solve(int npes, int my_PE_num, int64_t my_rows, int depth, int iteration,
+                    int max_iterations, const laplace_simd_kernels *simd, int64_t pitch, double (*Temperature)[pitch],
+                    double (*Temperature_last)[pitch], double *dt_global) {
+
+    size_t bytes = (size_t)(my_rows + 2*depth) * (size_t)pitch * sizeof(double);
+    double (*snapshot)[pitch] = NULL;   // Temperature_last at the start of the block
+    double *dt_step = malloc(2 * depth * sizeof(double));
+    double *dt_all = dt_step + depth;
+    int near = 1;                           // convergence may fall in the next block
+    int overshoot = 0;                      // iterations past convergence (no snapshot)
+    int steps, t;
+
+    *dt_global = 100;
+    while ( *dt_global > MAX_TEMP_ERROR && iteration < max_iterations ) {
+
+        steps = depth;
+        if (steps > max_iterations - iteration) steps = max_iterations - iteration;
+        if (steps > 100 - iteration % 100) steps = 100 - iteration % 100;
+
+        // whole buffer, ghost rows included; Temperature has the same fixed rows
+        if (near) {
+            if (!snapshot) snapshot = malloc(bytes);
+            memcpy(snapshot, Temperature_last - (depth-1), bytes);
+        }
+
+        deep_halo_block(npes, my_PE_num, my_rows, depth, steps, simd,
+                        pitch, &Temperature, &Temperature_last, dt_step);
+        MPI_Allreduce(dt_step, dt_all, steps, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+        // the one-row solver would have stopped at the first dt under the tolerance
+        for (t = 0; t < steps-1 && dt_all[t] > MAX_TEMP_ERROR; t++) ;
+        if (t < steps-1) {
+            if (near) {
+                // steps was even or odd: rerun into the same buffers from the snapshot
+                if (steps % 2 == 1) {
+                    double (*swap)[pitch] = Temperature;
+                    Temperature = Temperature_last;
+                    Temperature_last = swap;
+                }
+                memcpy(Temperature_last - (depth-1), snapshot, bytes);
+                deep_halo_block(npes, my_PE_num, my_rows, depth, t+1, simd,
+                                pitch, &Temperature, &Temperature_last, dt_step);
+            } else {
+                overshoot += steps - (t+1);
+            }
+            steps = t+1;
+        }
+
+        iteration += steps;
+        *dt_global = dt_all[steps-1];
+
+        // geometric decay over this block predicts whether the next one converges
+        if (steps > 1 && dt_all[0] > *dt_global && *dt_global > 0.0) {
+            double rate = pow(*dt_global / dt_all[0], 1.0 / (steps - 1));
+            near = log(MAX_TEMP_ERROR / *dt_global) / log(rate) < 2 * depth;
+        }
+
+        if((iteration % 100) == 0) {
+            if (my_PE_num == npes-1){
+                track_progress(iteration, my_rows, pitch, Temperature_last);
+            }
+        }
+    }
+
+    if (overshoot && my_PE_num == 0) {
+        printf("Deep halo: converged %d iterations before the end of a block\n", overshoot);
+    }
+
+    free(snapshot);
+    free(dt_step);
+    return iteration;
+}
+
+// collective: statistics, thumbnail and isotherms of Temperature_last.
+// Each PE covers the cells below its rows, so it needs the first row of
+// the PE below; the ghost rows may be a sweep old, so it comes by
+// message. PE 0 gets the reductions and every PE's segments, in row order
+void analyze(laplace_analysis *a, int npes, int my_PE_num, int64_t my_rows, int64_t my_start_row,
+             int iteration, int64_t pitch, double (*Temperature_last)[pitch]) {
+
+    int up = (my_PE_num != 0) ? my_PE_num-1 : MPI_PROC_NULL;
+    int down = (my_PE_num != npes-1) ? my_PE_num+1 : MPI_PROC_NULL;
+    double start = MPI_Wtime();
+    double *below = NULL;
+    laplace_stats s;
+    int64_t total = 0, *segments = NULL;
+    laplace_segment *gathered = NULL;
+    int *counts = NULL, *displs = NULL;
+    int l, pe;
+
+    if (down != MPI_PROC_NULL) below = malloc((COLUMNS+2) * sizeof(double));
+    MPI_Sendrecv(&Temperature_last[1][0], COLUMNS+2, MPI_DOUBLE, up, ANALYSIS,
+                 below, below ? COLUMNS+2 : 0, MPI_DOUBLE, down, ANALYSIS,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    laplace_analysis_compute(a, &Temperature_last[0][0], pitch, my_start_row, my_rows,
+                             my_PE_num == 0 ? 0 : 1, my_rows, below);
+    free(below);
+
+    MPI_Reduce(&a->stats.min, &s.min, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&a->stats.max, &s.max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&a->stats.sum, &s.sum, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(a->stats.histogram, s.histogram, LAPLACE_ANALYSIS_BINS, MPI_INT64_T, MPI_SUM,
+               0, MPI_COMM_WORLD);
+    MPI_Reduce(my_PE_num == 0 ? MPI_IN_PLACE : a->thumb, a->thumb, (int)(a->thumb_rows * a->thumb_columns),
+               MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    // segments level by level, each level in PE (so row) order
+    if (my_PE_num == 0) {
+        segments = malloc((size_t)npes * a->levels * sizeof(int64_t));
+        counts = malloc(npes * sizeof(int));
+        displs = malloc(npes * sizeof(int));
+    }
+    MPI_Gather(a->level_segments, a->levels, MPI_INT64_T, segments, a->levels, MPI_INT64_T,
+               0, MPI_COMM_WORLD);
+    if (my_PE_num == 0) {
+        for (l = 0; l < a->levels; l++) {
+            for (pe = 1; pe < npes; pe++) segments[l] += segments[pe * a->levels + l];
+            total += segments[l];
+        }
+        gathered = malloc((total ? total : 1) * sizeof(laplace_segment));
+    }
+    {
+        const laplace_segment *mine = a->segments;
+        laplace_segment *level_start = gathered;
+        for (l = 0; l < a->levels; l++) {
+            if (my_PE_num == 0) {
+                int offset = 0;
+                for (pe = 0; pe < npes; pe++) {
+                    // a PE's own count for this level, still in the gathered table
+                    int n = (int)(pe == 0 ? a->level_segments[l] : segments[pe * a->levels + l]) * 4;
+                    counts[pe] = n;
+                    displs[pe] = offset;
+                    offset += n;
+                }
+            }
+            MPI_Gatherv(mine, (int)a->level_segments[l] * 4, MPI_FLOAT, level_start, counts, displs,
+                        MPI_FLOAT, 0, MPI_COMM_WORLD);
+            mine += a->level_segments[l];
+            if (my_PE_num == 0) level_start += segments[l];
+        }
+    }
+
+    if (my_PE_num == 0) {
+        laplace_analysis_write(a, iteration, &s, a->thumb, gathered, segments);
+        free(gathered);
+        free(segments);
+        free(counts);
+        free(displs);
+    }
+    a->seconds += MPI_Wtime() - start;
+}
+
 // only called by last PE
-void track_progress(int iteration, int my_rows) {
+void track_progress(int iteration, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]) {
 
-    int i;
+    int64_t i;
 
     printf("---------- Iteration number: %d ------------\n", iteration);
 
     // output global coordinates so user doesn't have to understand decomposition
-    for(i = 5; i >= 0; i--) {
-        printf("[%d,%d]: %5.2f  ", ROWS_GLOBAL-i, COLUMNS-i, Temperature_last[my_rows-i][COLUMNS-i]);
+    for(i = laplace_progress_reach(my_rows, COLUMNS); i >= 0; i--) {
+        printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", ROWS-i, COLUMNS-i, Temperature_last[my_rows-i][COLUMNS-i]);
     }
     printf("\n");
-}
\ No newline at end of file
+}
+
+// the track_progress values as a telemetry record, printed by the sink
+void sample_progress(laplace_telemetry_record *r, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]) {
+
+    int64_t i, reach = laplace_progress_reach(my_rows, COLUMNS);
+
+    r->flags |= LAPLACE_TELEMETRY_HAS_SAMPLES;
+    r->samples = (int32_t)reach + 1;
+    r->sample_row = ROWS-reach;
+    r->sample_column = COLUMNS-reach;
+    for(i = reach; i >= 0; i--) {
+        r->sample[reach-i] = Temperature_last[my_rows-i][COLUMNS-i];
+    }
+}
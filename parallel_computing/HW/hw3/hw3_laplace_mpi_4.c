@@ -18,7 +18,8 @@
   - Added timing and result summary: The code measures and reports total runtime 
   and final error on PE 0.
   - Memory management: Dynamic allocation and cleanup of 2D arrays for temperature 
-  grids.
+  grids, each one contiguous 64-byte aligned block with rows padded apart
+  ([--pitch=packed|aligned|padded|N], see laplace_grid_pitch()).
   - Verbose control: Communication messages are printed only if the verbose flag is 
   enabled.
  *******************************************************************/
@@ -28,45 +29,42 @@
 #include <math.h>
 #include <sys/time.h>
 #include <mpi.h>
-
-
-#define COLUMNS      1000
-#define ROWS_GLOBAL  1000        // this is a "global" row count
+#include "../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
 
 // communication tags
 #define DOWN     100
 #define UP       101   
 
-#define MAX_TEMP_ERROR 0.01
 #define verbose 0
 
-void initialze_circular(int ROWS, int npes, int my_PE_num, double **Temperature_last) {
+void initialze_circular(int64_t my_rows, int npes, int my_PE_num, int64_t pitch,
+                        double (*Temperature_last)[pitch]) {
     //All: generic boundary 
-    for (int i = 0; i <= ROWS + 1; i++) {
+    for (int64_t i = 0; i <= my_rows + 1; i++) {
         Temperature_last[i][0] = 0.0;           // Left boundary
         Temperature_last[i][COLUMNS+1] = 100.0; // Right boundary  
     }
 
     //PE_0: set top boundary
     if (my_PE_num == 0) {
-        for (int j = 0; j <= COLUMNS + 1; j++)
+        for (int64_t j = 0; j <= COLUMNS + 1; j++)
             Temperature_last[0][j] = 0.0; // Top boundary
     }
 
     //PE_7: set bottom boundary
     if (my_PE_num == npes-1) {
-        for (int j = 0; j <= COLUMNS + 1; j++)
-            Temperature_last[ROWS+1][j] = 100.0; // Bottom boundary
+        for (int64_t j = 0; j <= COLUMNS + 1; j++)
+            Temperature_last[my_rows+1][j] = 100.0; // Bottom boundary
     }
 }
 
 // only called by last PE
-void track_progress(int iteration, int ROWS, double **Temperature) {
+void track_progress(int iteration, int64_t my_rows, int64_t pitch, double (*Temperature)[pitch]) {
 
     printf("---------- Iteration number: %d ------------\n", iteration);
     // output global coordinates so user doesn't have to understand decomposition
-    for(int i = 5; i >= 0; i--) {
-      printf("[%d,%d]: %5.2f  ", ROWS-i, COLUMNS-i, Temperature[ROWS-i][COLUMNS-i]);
+    for(int64_t i = laplace_progress_reach(my_rows, COLUMNS); i >= 0; i--) {
+      printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", my_rows-i, COLUMNS-i, Temperature[my_rows-i][COLUMNS-i]);
     }
     printf("\n");
 }
@@ -85,7 +83,16 @@ int main(int argc, char** argv) {
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &my_PE_num);
     MPI_Comm_size(MPI_COMM_WORLD, &npes);
-    
+
+    // every PE parses the same command line; 4000 iterations unless given
+    int parsed_iterations = laplace_parse_args(argc, argv);
+    if (parsed_iterations > 0) max_iterations = parsed_iterations;
+    int64_t pitch = laplace_grid_pitch(COLUMNS, LAPLACE_PITCH_PADDED);
+    for (int arg = 1; arg < argc; arg++) {
+        const char *v = laplace_arg_value(argv[arg], "--pitch");
+        if (v) pitch = laplace_parse_pitch(v, COLUMNS);
+    }
+
 
     // Calculate ring neighbors
     next_PE = (my_PE_num + 1) % npes;
@@ -101,23 +108,19 @@ int main(int argc, char** argv) {
     
     if (my_PE_num==0) gettimeofday(&start_time,NULL);
 
-    int rows_per_process = ROWS_GLOBAL / npes; // Dynamically Calculate local dimensions
-    int ghost_rows = ROWS_GLOBAL % npes;
-    int ROWS = rows_per_process + (my_PE_num < ghost_rows ? 1 : 0); // for even distribution of the ghost_rows in case the rows are not exactly divisible by process X.
+    int64_t rows_per_process = ROWS / npes; // Dynamically Calculate local dimensions
+    int64_t ghost_rows = ROWS % npes;
+    int64_t my_rows = rows_per_process + (my_PE_num < ghost_rows ? 1 : 0); // for even distribution of the ghost_rows in case the rows are not exactly divisible by process X.
 
-    // Dynamically allocate memory space
-    double **Temperature = (double **)malloc((ROWS + 2) * sizeof(double *));
-    double **Temperature_last = (double **)malloc((ROWS + 2) * sizeof(double *));
-    for (int i = 0; i < ROWS + 2; i++) {
-        Temperature[i] = (double *)malloc((COLUMNS + 2) * sizeof(double));
-        Temperature_last[i] = (double *)malloc((COLUMNS + 2) * sizeof(double));
-    }
-    initialze_circular(ROWS, npes, my_PE_num, Temperature_last);
+    // Dynamically allocate memory space: one aligned block per grid, rows pitch doubles apart
+    double (*Temperature)[pitch]      = laplace_alloc_pitched_grid(my_rows, pitch);
+    double (*Temperature_last)[pitch] = laplace_alloc_pitched_grid(my_rows, pitch);
+    initialze_circular(my_rows, npes, my_PE_num, pitch, Temperature_last);
 
     while (dt_global > MAX_TEMP_ERROR && iteration <= max_iterations) {
         // Main calculation: average four neighbors
-        for (int i = 1; i <= ROWS; i++) {
-            for (int j = 1; j <= COLUMNS; j++) {
+        for (int64_t i = 1; i <= my_rows; i++) {
+            for (int64_t j = 1; j <= COLUMNS; j++) {
                 Temperature[i][j] = 0.25 * (Temperature_last[i+1][j] + Temperature_last[i-1][j] +
                                             Temperature_last[i][j+1] + Temperature_last[i][j-1]);
             }
@@ -129,14 +132,14 @@ int main(int argc, char** argv) {
             // Each PE sends its bottom row to next_PE and receives top ghost row from prev_PE
             if (my_PE_num % 2 == 0) {
                 if (verbose) printf("PE %d sending bottom row to PE %d\n", my_PE_num, next_PE);
-                MPI_Send(&Temperature[ROWS][1], COLUMNS, MPI_DOUBLE, next_PE, DOWN, MPI_COMM_WORLD);
+                MPI_Send(&Temperature[my_rows][1], COLUMNS, MPI_DOUBLE, next_PE, DOWN, MPI_COMM_WORLD);
                 if (verbose) printf("PE %d receiving top ghost row from PE %d\n", my_PE_num, prev_PE);
                 MPI_Recv(&Temperature[0][1], COLUMNS, MPI_DOUBLE, prev_PE, DOWN, MPI_COMM_WORLD, &status);
             } else {
                 if (verbose) printf("PE %d receiving top ghost row from PE %d\n", my_PE_num, prev_PE);
                 MPI_Recv(&Temperature[0][1], COLUMNS, MPI_DOUBLE, prev_PE, DOWN, MPI_COMM_WORLD, &status);
                 if (verbose) printf("PE %d sending bottom row to PE %d\n", my_PE_num, next_PE);
-                MPI_Send(&Temperature[ROWS][1], COLUMNS, MPI_DOUBLE, next_PE, DOWN, MPI_COMM_WORLD);
+                MPI_Send(&Temperature[my_rows][1], COLUMNS, MPI_DOUBLE, next_PE, DOWN, MPI_COMM_WORLD);
             }
 
             // Each PE sends its top row to prev_PE and receives bottom ghost row from next_PE
@@ -144,10 +147,10 @@ int main(int argc, char** argv) {
                 if (verbose) printf("PE %d sending top row to PE %d\n", my_PE_num, prev_PE);
                 MPI_Send(&Temperature[1][1], COLUMNS, MPI_DOUBLE, prev_PE, UP, MPI_COMM_WORLD);
                 if (verbose) printf("PE %d receiving bottom ghost row from PE %d\n", my_PE_num, next_PE);
-                MPI_Recv(&Temperature[ROWS+1][1], COLUMNS, MPI_DOUBLE, next_PE, UP, MPI_COMM_WORLD, &status);
+                MPI_Recv(&Temperature[my_rows+1][1], COLUMNS, MPI_DOUBLE, next_PE, UP, MPI_COMM_WORLD, &status);
             } else {
                 if (verbose) printf("PE %d receiving bottom ghost row from PE %d\n", my_PE_num, next_PE);
-                MPI_Recv(&Temperature[ROWS+1][1], COLUMNS, MPI_DOUBLE, next_PE, UP, MPI_COMM_WORLD, &status);
+                MPI_Recv(&Temperature[my_rows+1][1], COLUMNS, MPI_DOUBLE, next_PE, UP, MPI_COMM_WORLD, &status);
                 if (verbose) printf("PE %d sending top row to PE %d\n", my_PE_num, prev_PE);
                 MPI_Send(&Temperature[1][1], COLUMNS, MPI_DOUBLE, prev_PE, UP, MPI_COMM_WORLD);
             }
@@ -155,8 +158,8 @@ int main(int argc, char** argv) {
 
         // Compute local max difference and update Temperature_last
         dt = 0.0;
-        for (int i = 1; i <= ROWS; i++) {
-            for (int j = 1; j <= COLUMNS; j++) {
+        for (int64_t i = 1; i <= my_rows; i++) {
+            for (int64_t j = 1; j <= COLUMNS; j++) {
                 dt = fmax(fabs(Temperature[i][j] - Temperature_last[i][j]), dt);
                 Temperature_last[i][j] = Temperature[i][j];
             }
@@ -169,7 +172,7 @@ int main(int argc, char** argv) {
         // periodically print test values - only for PE in lower corner
         if((iteration % 100) == 0) {
             if (my_PE_num == npes-1){
-                track_progress(iteration, ROWS, Temperature);
+                track_progress(iteration, my_rows, pitch, Temperature);
             }
         }   
 
@@ -186,10 +189,6 @@ int main(int argc, char** argv) {
     }
 
     // Free memory after all of the communication has finished
-    for (int i = 0; i < ROWS + 2; i++) {
-        free(Temperature[i]);
-        free(Temperature_last[i]);
-    }
     free(Temperature);
     free(Temperature_last);
 
@@ -22,20 +22,17 @@
 #include <math.h>
 #include <sys/time.h>
 #include <mpi.h>
-
-#define COLUMNS      1000
-#define ROWS_GLOBAL  1000        // this is a "global" row count
+#include "../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
 
 // communication tags
 #define DOWN     100
 #define UP       101   
 
-#define MAX_TEMP_ERROR 0.01
 #define VERBOSE 0
 
 // Function prototypes
-void initialize_optimized(int ROWS, int npes, int my_PE_num, double (*Temperature_last)[COLUMNS+2]);
-void track_progress(int iteration, int ROWS, double (*Temperature)[COLUMNS+2]);
+void initialize_optimized(int64_t my_rows, int npes, int my_PE_num, double (*Temperature_last)[COLUMNS+2]);
+void track_progress(int iteration, int64_t my_rows, double (*Temperature)[COLUMNS+2]);
 
 int main(int argc, char** argv) {
     int my_PE_num;                  // Current PE
@@ -55,6 +52,10 @@ int main(int argc, char** argv) {
     MPI_Comm_rank(MPI_COMM_WORLD, &my_PE_num);
     MPI_Comm_size(MPI_COMM_WORLD, &npes);
 
+    // every PE parses the same command line; 4000 iterations unless given
+    int parsed_iterations = laplace_parse_args(argc, argv);
+    if (parsed_iterations > 0) max_iterations = parsed_iterations;
+
     // Calculate ring neighbors
     next_PE = (my_PE_num + 1) % npes;
     prev_PE = (my_PE_num - 1 + npes) % npes;
@@ -64,20 +65,18 @@ int main(int argc, char** argv) {
     
     if (my_PE_num == 0) {
         printf("Running optimized version on %d processes\n", npes);
-        printf("Grid size: %dx%d, Max iterations: %d\n", ROWS_GLOBAL, COLUMNS, max_iterations);
+        printf("Grid size: %" PRId64 "x%" PRId64 ", Max iterations: %d\n", (int64_t)ROWS, (int64_t)COLUMNS, max_iterations);
         gettimeofday(&start_time, NULL);
     }
 
     // Dynamic load balancing
-    int rows_per_process = ROWS_GLOBAL / npes;
-    int ghost_rows = ROWS_GLOBAL % npes;
-    int ROWS = rows_per_process + (my_PE_num < ghost_rows ? 1 : 0);
+    int64_t rows_per_process = ROWS / npes;
+    int64_t ghost_rows = ROWS % npes;
+    int64_t my_rows = rows_per_process + (my_PE_num < ghost_rows ? 1 : 0);
 
     // OPTIMIZATION 1: Contiguous memory allocation for better cache locality
-    double (*Temperature)[COLUMNS+2] = 
-        (double (*)[COLUMNS+2])malloc((ROWS+2) * (COLUMNS+2) * sizeof(double));
-    double (*Temperature_last)[COLUMNS+2] = 
-        (double (*)[COLUMNS+2])malloc((ROWS+2) * (COLUMNS+2) * sizeof(double));
+    double (*Temperature)[COLUMNS+2] = malloc(laplace_grid_bytes(my_rows, COLUMNS));
+    double (*Temperature_last)[COLUMNS+2] = malloc(laplace_grid_bytes(my_rows, COLUMNS));
     
     if (!Temperature || !Temperature_last) {
         printf("PE %d: Memory allocation failed\n", my_PE_num);
@@ -86,7 +85,7 @@ int main(int argc, char** argv) {
     }
 
     // Initialize temperature arrays
-    initialize_optimized(ROWS, npes, my_PE_num, Temperature_last);
+    initialize_optimized(my_rows, npes, my_PE_num, Temperature_last);
 
     // Main computation loop
     while (dt_global > MAX_TEMP_ERROR && iteration <= max_iterations) {
@@ -98,7 +97,7 @@ int main(int argc, char** argv) {
         if (npes > 1) {
             // Post non-blocking sends and receives for ghost row exchange
             if (my_PE_num != npes-1) {
-                MPI_Isend(&Temperature_last[ROWS][1], COLUMNS, MPI_DOUBLE, 
+                MPI_Isend(&Temperature_last[my_rows][1], COLUMNS, MPI_DOUBLE, 
                          next_PE, DOWN, MPI_COMM_WORLD, &requests[req_count++]);
             }
             if (my_PE_num != 0) {
@@ -110,15 +109,15 @@ int main(int argc, char** argv) {
                          prev_PE, UP, MPI_COMM_WORLD, &requests[req_count++]);
             }
             if (my_PE_num != npes-1) {
-                MPI_Irecv(&Temperature[ROWS+1][1], COLUMNS, MPI_DOUBLE, 
+                MPI_Irecv(&Temperature[my_rows+1][1], COLUMNS, MPI_DOUBLE, 
                          next_PE, UP, MPI_COMM_WORLD, &requests[req_count++]);
             }
         }
 
         // Calculate interior points (can overlap with communication)
         // Interior points don't need ghost cells
-        for (int i = 2; i < ROWS; i++) {
-            for (int j = 1; j <= COLUMNS; j++) {
+        for (int64_t i = 2; i < my_rows; i++) {
+            for (int64_t j = 1; j <= COLUMNS; j++) {
                 Temperature[i][j] = 0.25 * (Temperature_last[i+1][j] + Temperature_last[i-1][j] +
                                            Temperature_last[i][j+1] + Temperature_last[i][j-1]);
             }
@@ -131,21 +130,21 @@ int main(int argc, char** argv) {
 
         // Calculate boundary rows that need ghost cells
         // Top boundary row (row 1)
-        for (int j = 1; j <= COLUMNS; j++) {
+        for (int64_t j = 1; j <= COLUMNS; j++) {
             Temperature[1][j] = 0.25 * (Temperature_last[2][j] + Temperature[0][j] +
                                        Temperature_last[1][j+1] + Temperature_last[1][j-1]);
         }
         
-        // Bottom boundary row (row ROWS)
-        for (int j = 1; j <= COLUMNS; j++) {
-            Temperature[ROWS][j] = 0.25 * (Temperature[ROWS+1][j] + Temperature_last[ROWS-1][j] +
-                                          Temperature_last[ROWS][j+1] + Temperature_last[ROWS][j-1]);
+        // Bottom boundary row (row my_rows)
+        for (int64_t j = 1; j <= COLUMNS; j++) {
+            Temperature[my_rows][j] = 0.25 * (Temperature[my_rows+1][j] + Temperature_last[my_rows-1][j] +
+                                          Temperature_last[my_rows][j+1] + Temperature_last[my_rows][j-1]);
         }
 
         // Calculate convergence criterion
         dt = 0.0;
-        for (int i = 1; i <= ROWS; i++) {
-            for (int j = 1; j <= COLUMNS; j++) {
+        for (int64_t i = 1; i <= my_rows; i++) {
+            for (int64_t j = 1; j <= COLUMNS; j++) {
                 dt = fmax(fabs(Temperature[i][j] - Temperature_last[i][j]), dt);
             }
         }
@@ -161,7 +160,7 @@ int main(int argc, char** argv) {
         // Periodically print progress
         if ((iteration % 100) == 0) {
             if (my_PE_num == npes-1) {
-                track_progress(iteration, ROWS, Temperature_last);
+                track_progress(iteration, my_rows, Temperature_last);
             }
         }
 
@@ -175,7 +174,7 @@ int main(int argc, char** argv) {
         printf("\n================================= RESULTS ===================================\n");
         printf("Max error at iteration %d was %f\n", iteration-1, dt_global);
         printf("Total time was %f seconds.\n", elapsed_time.tv_sec + elapsed_time.tv_usec/1000000.0);
-        printf("Grid size: %dx%d, Processes: %d\n", ROWS_GLOBAL, COLUMNS, npes);
+        printf("Grid size: %" PRId64 "x%" PRId64 ", Processes: %d\n", (int64_t)ROWS, (int64_t)COLUMNS, npes);
         printf("============================================================================\n");
     }
 
@@ -187,18 +186,18 @@ int main(int argc, char** argv) {
     return 0;
 }
 
-void initialize_optimized(int ROWS, int npes, int my_PE_num, double (*Temperature_last)[COLUMNS+2]) {
+void initialize_optimized(int64_t my_rows, int npes, int my_PE_num, double (*Temperature_last)[COLUMNS+2]) {
     // Initialize all cells to 0.0
-    for (int i = 0; i <= ROWS + 1; i++) {
-        for (int j = 0; j <= COLUMNS + 1; j++) {
+    for (int64_t i = 0; i <= my_rows + 1; i++) {
+        for (int64_t j = 0; j <= COLUMNS + 1; j++) {
             Temperature_last[i][j] = 0.0;
         }
     }
 
     // Calculate this PE's portion of the global boundary
-    int rows_per_process = ROWS_GLOBAL / npes;
-    int ghost_rows = ROWS_GLOBAL % npes;
-    int my_start_row = 0;
+    int64_t rows_per_process = ROWS / npes;
+    int64_t ghost_rows = ROWS % npes;
+    int64_t my_start_row = 0;
     
     // Calculate starting row for this PE
     if (my_PE_num < ghost_rows) {
@@ -210,38 +209,38 @@ void initialize_optimized(int ROWS, int npes, int my_PE_num, double (*Temperatur
 
     // Set boundary conditions
     // Left boundary (always 0.0)
-    for (int i = 0; i <= ROWS + 1; i++) {
+    for (int64_t i = 0; i <= my_rows + 1; i++) {
         Temperature_last[i][0] = 0.0;
     }
     
     // Right boundary (temperature gradient)
-    double t_min = my_start_row * 100.0 / ROWS_GLOBAL;
-    double t_max = (my_start_row + ROWS) * 100.0 / ROWS_GLOBAL;
-    for (int i = 0; i <= ROWS + 1; i++) {
-        Temperature_last[i][COLUMNS+1] = t_min + ((t_max - t_min) / ROWS) * i;
+    double t_min = my_start_row * 100.0 / ROWS;
+    double t_max = (my_start_row + my_rows) * 100.0 / ROWS;
+    for (int64_t i = 0; i <= my_rows + 1; i++) {
+        Temperature_last[i][COLUMNS+1] = t_min + ((t_max - t_min) / my_rows) * i;
     }
 
     // Top boundary (PE 0 only)
     if (my_PE_num == 0) {
-        for (int j = 0; j <= COLUMNS + 1; j++) {
+        for (int64_t j = 0; j <= COLUMNS + 1; j++) {
             Temperature_last[0][j] = 0.0;
         }
     }
 
     // Bottom boundary (last PE only)
     if (my_PE_num == npes-1) {
-        for (int j = 0; j <= COLUMNS + 1; j++) {
-            Temperature_last[ROWS+1][j] = 100.0 * j / COLUMNS;
+        for (int64_t j = 0; j <= COLUMNS + 1; j++) {
+            Temperature_last[my_rows+1][j] = 100.0 * j / COLUMNS;
         }
     }
 }
 
-void track_progress(int iteration, int ROWS, double (*Temperature)[COLUMNS+2]) {
+void track_progress(int iteration, int64_t my_rows, double (*Temperature)[COLUMNS+2]) {
     printf("---------- Iteration number: %d ------------\n", iteration);
     
     // Output representative values
-    for (int i = 5; i >= 0; i--) {
-        printf("[%d,%d]: %5.2f  ", ROWS_GLOBAL-i, COLUMNS-i, Temperature[ROWS-i][COLUMNS-i]);
+    for (int64_t i = laplace_progress_reach(my_rows, COLUMNS); i >= 0; i--) {
+        printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", ROWS-i, COLUMNS-i, Temperature[my_rows-i][COLUMNS-i]);
     }
     printf("\n");
 }
\ No newline at end of file
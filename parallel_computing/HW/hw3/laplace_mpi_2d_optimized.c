@@ -0,0 +1,323 @@
+/****************************************************************
+ * 2 Dimension Cartesian Laplace MPI C Version
+ *
+ * hw3_laplace_mpi_3.c cuts the plate into row slabs, so every PE
+ * exchanges two COLUMNS-wide halos however many PEs there are. Here
+ * the PEs form a P x Q Cartesian grid (MPI_Cart_create) and each one
+ * owns a block, exchanging four faces whose length shrinks with both
+ * P and Q:
+ *
+ *                T                    2 x 3 process grid
+ *   0  +-------------------+  0    +------+------+------+
+ *      |                   |       | 0,0  | 0,1  | 0,2  |
+ *      |                   |       |      |      |      |
+ *   T  |                   |  T    +------+------+------+
+ *      |                   |       | 1,0  | 1,1  | 1,2  |
+ *      |                   |       |      |      |      |
+ *   0  +-------------------+ 100   +------+------+------+
+ *      0         T       100
+ *
+ * - Neighbours from MPI_Cart_shift; edge PEs get MPI_PROC_NULL, so the
+ *   same exchange code runs everywhere
+ * - Row faces are contiguous, column faces use an MPI_Type_vector
+ *   (one cell per row, stride the row pitch), all received in place
+ * - Rows are pitch doubles apart in one 64-byte aligned block,
+ *   [--pitch=packed|aligned|padded|N], padded by default, chosen for
+ *   each PE's block width; see laplace_grid_pitch() in common/laplace_args.h
+ * - All four faces are non-blocking and overlap the block interior
+ * - The process grid minimises the largest per-PE halo for the plate's
+ *   aspect ratio; --dims=PxQ overrides it
+ * - Same row kernels as hw3_laplace_mpi_3.c (--simd=..., --simd-report)
+ *
+ * Iterates are bit-identical to the 1-D version: 3372 iterations for
+ * the 1000 x 1000 plate.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ *******************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <sys/time.h>
+#include <mpi.h>
+#include "../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
+#include "../../common/laplace_simd.h"
+
+// communication tags, named for the direction the data travels
+#define DOWN     100
+#define UP       101
+#define RIGHT    102
+#define LEFT     103
+
+int64_t halo_cells(int p, int q);
+void choose_dims(int npes, int dims[2]);
+void block_range(int64_t n, int parts, int coord, int64_t *count, int64_t *start);
+void initialize(int64_t my_rows, int64_t my_cols, int64_t row0, int64_t col0,
+                int64_t pitch, double (*Temperature_last)[pitch]);
+void track_progress(int iteration, int64_t my_rows, int64_t my_cols, int64_t row0, int64_t col0,
+                    int64_t pitch, double (*Temperature_last)[pitch]);
+
+int main(int argc, char *argv[]) {
+
+    int64_t i;
+    int max_iterations;
+    int iteration=1;
+    double dt;
+    struct timeval start_time, stop_time, elapsed_time;
+
+    int        npes;                // number of PEs
+    int        my_PE_num;           // my PE number in the Cartesian communicator
+    double     dt_global=100;       // delta t across all PEs
+    MPI_Comm   cart;                // P x Q process grid
+    int        dims[2] = {0, 0};    // P rows by Q columns of PEs
+    int        periods[2] = {0, 0}; // the plate does not wrap
+    int        coords[2];           // my place in the process grid
+    int        up, down, left, right;
+    MPI_Datatype column_face;       // one cell per row of my block
+    MPI_Request requests[8];        // four sends, four receives
+    int        req_count;
+
+    // my block of the plate
+    int64_t my_rows, my_cols;       // interior cells
+    int64_t row0, col0;             // global index of my ghost row/column 0
+    int64_t pitch;                  // doubles from one row to the next
+    const char *pitch_spec = NULL;  // --pitch, NULL = padded
+
+    const char *simd_name = NULL;   // row kernel set, NULL = widest supported
+    int simd_report = 0;            // time the kernel sets first
+    const laplace_simd_kernels *simd;
+    const char *v;
+    int arg;
+
+    // the usual MPI startup routines
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &npes);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_PE_num);   // until the Cartesian renumbering below
+
+    // every PE parses the same command line
+    max_iterations = laplace_parse_args(argc, argv);
+    for (arg = 1; arg < argc; arg++) {
+        if ((v = laplace_arg_value(argv[arg], "--dims"))) {
+            if (sscanf(v, "%dx%d", &dims[0], &dims[1]) != 2 || dims[0] < 1 || dims[1] < 1 ||
+                dims[0] * dims[1] != npes) {
+                if (my_PE_num == 0)
+                    fprintf(stderr, "--dims=%s must be PxQ with P*Q = %d PEs\n", v, npes);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        } else if ((v = laplace_arg_value(argv[arg], "--pitch"))) {
+            pitch_spec = v;
+        } else if ((v = laplace_arg_value(argv[arg], "--simd"))) {
+            simd_name = v;
+        } else if (strcmp(argv[arg], "--simd-report") == 0) {
+            simd_report = 1;
+        }
+    }
+    if (dims[0] == 0) choose_dims(npes, dims);
+
+    // let MPI renumber PEs to match the machine, then find the neighbours
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 1, &cart);
+    MPI_Comm_rank(cart, &my_PE_num);
+    MPI_Cart_coords(cart, my_PE_num, 2, coords);
+    MPI_Cart_shift(cart, 0, 1, &up, &down);
+    MPI_Cart_shift(cart, 1, 1, &left, &right);
+
+    block_range(ROWS, dims[0], coords[0], &my_rows, &row0);
+    block_range(COLUMNS, dims[1], coords[1], &my_cols, &col0);
+    if (my_rows < 1 || my_cols < 1) {
+        if (my_PE_num == 0)
+            fprintf(stderr, "%dx%d PEs leave empty blocks on a %" PRId64 "x%" PRId64 " plate\n",
+                    dims[0], dims[1], (int64_t)ROWS, (int64_t)COLUMNS);
+        MPI_Abort(cart, 1);
+    }
+    // the pitch fits my block, so it is only known now
+    pitch = pitch_spec ? laplace_parse_pitch(pitch_spec, my_cols)
+                       : laplace_grid_pitch(my_cols, LAPLACE_PITCH_PADDED);
+
+    simd = laplace_simd_select(simd_name);
+    if (my_PE_num == 0) {
+        if (simd_report) laplace_simd_report(COLUMNS);
+        printf("Row kernels: %s\n", simd->name);
+        printf("Process grid: %dx%d\n", dims[0], dims[1]);
+        printf("Row pitch: %" PRId64 " doubles (PE 0)\n", pitch);
+    }
+
+    MPI_Type_vector((int)my_rows, 1, (int)pitch, MPI_DOUBLE, &column_face);
+    MPI_Type_commit(&column_face);
+
+    // one aligned block per grid; the row type depends on my pitch
+    double (*Temperature)[pitch]      = laplace_alloc_pitched_grid(my_rows, pitch);
+    double (*Temperature_last)[pitch] = laplace_alloc_pitched_grid(my_rows, pitch);
+
+    // PE 0 asks for input
+    if(my_PE_num==0 && max_iterations < 0) {
+        printf("Maximum iterations [100-4000]?\n");
+        fflush(stdout);
+        scanf("%d", &max_iterations);
+    }
+
+    // bcast max iterations to other PEs
+    MPI_Bcast(&max_iterations, 1, MPI_INT, 0, cart);
+
+    if (my_PE_num==0) gettimeofday(&start_time,NULL);
+
+    // both buffers: after the first swap Temperature holds the boundaries
+    initialize(my_rows, my_cols, row0, col0, pitch, Temperature_last);
+    initialize(my_rows, my_cols, row0, col0, pitch, Temperature);
+
+    while ( dt_global > MAX_TEMP_ERROR && iteration <= max_iterations ) {
+
+        // PHASE 1: post all four faces; ghosts land in Temperature_last,
+        // which nobody writes this iteration
+        req_count = 0;
+        MPI_Irecv(&Temperature_last[0][1], (int)my_cols, MPI_DOUBLE, up, DOWN, cart, &requests[req_count++]);
+        MPI_Irecv(&Temperature_last[my_rows+1][1], (int)my_cols, MPI_DOUBLE, down, UP, cart, &requests[req_count++]);
+        MPI_Irecv(&Temperature_last[1][0], 1, column_face, left, RIGHT, cart, &requests[req_count++]);
+        MPI_Irecv(&Temperature_last[1][my_cols+1], 1, column_face, right, LEFT, cart, &requests[req_count++]);
+
+        MPI_Isend(&Temperature_last[my_rows][1], (int)my_cols, MPI_DOUBLE, down, DOWN, cart, &requests[req_count++]);
+        MPI_Isend(&Temperature_last[1][1], (int)my_cols, MPI_DOUBLE, up, UP, cart, &requests[req_count++]);
+        MPI_Isend(&Temperature_last[1][my_cols], 1, column_face, right, RIGHT, cart, &requests[req_count++]);
+        MPI_Isend(&Temperature_last[1][1], 1, column_face, left, LEFT, cart, &requests[req_count++]);
+
+        // PHASE 2: block interior, no ghost cells needed
+        for(i = 2; i < my_rows; i++) {
+            if (my_cols > 2)
+                simd->stencil(&Temperature[i][2], &Temperature_last[i-1][2],
+                              &Temperature_last[i][2], &Temperature_last[i+1][2], my_cols-2);
+        }
+
+        // PHASE 3: wait for the faces
+        MPI_Waitall(req_count, requests, MPI_STATUSES_IGNORE);
+
+        // PHASE 4: the ring of cells next to the ghosts
+        simd->stencil(&Temperature[1][1], &Temperature_last[0][1],
+                      &Temperature_last[1][1], &Temperature_last[2][1], my_cols);
+        simd->stencil(&Temperature[my_rows][1], &Temperature_last[my_rows-1][1],
+                      &Temperature_last[my_rows][1], &Temperature_last[my_rows+1][1], my_cols);
+        for(i = 2; i < my_rows; i++) {
+            simd->stencil(&Temperature[i][1], &Temperature_last[i-1][1],
+                          &Temperature_last[i][1], &Temperature_last[i+1][1], 1);
+            simd->stencil(&Temperature[i][my_cols], &Temperature_last[i-1][my_cols],
+                          &Temperature_last[i][my_cols], &Temperature_last[i+1][my_cols], 1);
+        }
+
+        // PHASE 5: local dt, then swap buffers
+        dt = 0.0;
+        for(i = 1; i <= my_rows; i++){
+            dt = fmax(simd->maxdiff(&Temperature[i][1], &Temperature_last[i][1], my_cols), dt);
+        }
+
+        double (*temp_ptr)[pitch] = Temperature_last;
+        Temperature_last = Temperature;
+        Temperature = temp_ptr;
+
+        MPI_Allreduce(&dt, &dt_global, 1, MPI_DOUBLE, MPI_MAX, cart);
+
+        // periodically print test values - only for the PE in the lower right corner
+        if((iteration % 100) == 0) {
+            if (coords[0] == dims[0]-1 && coords[1] == dims[1]-1){
+                track_progress(iteration, my_rows, my_cols, row0, col0, pitch, Temperature_last);
+            }
+        }
+
+        iteration++;
+    }
+
+    // Slightly more accurate timing and cleaner output
+    MPI_Barrier(cart);
+
+    // PE 0 finish timing and output values
+    if (my_PE_num==0){
+        gettimeofday(&stop_time,NULL);
+        timersub(&stop_time, &start_time, &elapsed_time);
+
+        printf("\nMax error at iteration %d was %f\n", iteration-1, dt_global);
+        printf("Total time was %f seconds.\n", elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0);
+        printf("Grid size: %" PRId64 "x%" PRId64 ", Processes: %d (%dx%d)\n",
+               (int64_t)ROWS, (int64_t)COLUMNS, npes, dims[0], dims[1]);
+        printf("Halo cells per PE per iteration: %" PRId64 " (1-D rows: %" PRId64 ")\n",
+               halo_cells(dims[0], dims[1]), halo_cells(npes, 1));
+    }
+
+    free(Temperature);
+    free(Temperature_last);
+    MPI_Type_free(&column_face);
+    MPI_Comm_free(&cart);
+
+    MPI_Finalize();
+    return 0;
+}
+
+// cells the busiest PE of a P x Q grid receives per iteration: one or
+// two rows of up to COLUMNS/Q cells and one or two columns of up to
+// ROWS/P cells
+int64_t halo_cells(int p, int q) {
+
+    int64_t row_faces = (p > 2) ? 2 : p - 1;
+    int64_t column_faces = (q > 2) ? 2 : q - 1;
+
+    return row_faces * ((COLUMNS + q - 1) / q) + column_faces * ((ROWS + p - 1) / p);
+}
+
+// P x Q with P*Q = npes that minimises the largest per-PE halo
+void choose_dims(int npes, int dims[2]) {
+
+    int64_t best = -1;
+    int p;
+
+    for (p = 1; p <= npes; p++) {
+        if (npes % p) continue;
+        int64_t halo = halo_cells(p, npes / p);
+        if (best < 0 || halo < best) {
+            best = halo;
+            dims[0] = p;
+            dims[1] = npes / p;
+        }
+    }
+}
+
+// n cells over parts PEs, the first n % parts getting one extra; start is
+// the global index of the block's ghost cell 0
+void block_range(int64_t n, int parts, int coord, int64_t *count, int64_t *start) {
+
+    int64_t base = n / parts;
+    int64_t extra = n % parts;
+
+    *count = base + (coord < extra ? 1 : 0);
+    *start = coord * base + (coord < extra ? coord : extra);
+}
+
+// local cell (i,j) is global cell (row0+i, col0+j); ghosts on the plate
+// edge get the boundary conditions, the rest start at 0
+void initialize(int64_t my_rows, int64_t my_cols, int64_t row0, int64_t col0,
+                int64_t pitch, double (*Temperature_last)[pitch]){
+
+    int64_t i, j;
+
+    for(i = 0; i <= my_rows+1; i++){
+        for (j = 0; j <= my_cols+1; j++){
+            int64_t gi = row0 + i, gj = col0 + j;
+            double t = 0.0;
+            if (gj == COLUMNS+1) t = (100.0/ROWS) * gi;     // right edge
+            if (gi == ROWS+1) t = (100.0/COLUMNS) * gj;     // bottom edge
+            Temperature_last[i][j] = t;
+        }
+    }
+}
+
+// only called by the lower right PE; prints the corner cells it owns
+void track_progress(int iteration, int64_t my_rows, int64_t my_cols, int64_t row0, int64_t col0,
+                    int64_t pitch, double (*Temperature_last)[pitch]) {
+
+    int64_t i;
+
+    printf("---------- Iteration number: %d ------------\n", iteration);
+
+    // output global coordinates so user doesn't have to understand decomposition
+    for(i = laplace_progress_reach(my_rows, my_cols); i >= 0; i--) {
+        printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", row0+my_rows-i, col0+my_cols-i,
+               Temperature_last[my_rows-i][my_cols-i]);
+    }
+    printf("\n");
+}
@@ -0,0 +1,305 @@
+/****************************************************************
+ * Hybrid MPI + OpenMP Laplace C Version
+ *
+ * Same row slabs as hw3_laplace_mpi_3.c, but a rank is a group of
+ * OpenMP threads rather than a single core: run one rank per node or
+ * per NUMA domain and let the threads share the slab. Halo rows and the
+ * dt Allreduce are then paid once per rank instead of once per core.
+ *
+ *   mpirun -n RANKS --map-by ppr:1:numa:pe=THREADS \
+ *       ./laplace_mpi_hybrid.out --threads=THREADS [--size=N ...]
+ *
+ * --threads defaults to OMP_NUM_THREADS. MPI runs under
+ * MPI_THREAD_FUNNELED: thread 0 is the communication thread and makes
+ * every MPI call. Each iteration it posts the halo exchange and waits
+ * on it while threads 1..n-1 sweep the interior rows; then all threads
+ * finish the two edge rows and the dt reduction together. With one
+ * thread it falls back to the hw3_laplace_mpi_3.c overlap (post,
+ * sweep, wait).
+ *
+ * Iterates are bit-identical to hw3_laplace_mpi_3.c.
+ *
+ * Rows are pitch doubles apart in one 64-byte aligned block,
+ * [--pitch=packed|aligned|padded|N], padded by default; see
+ * laplace_grid_pitch() in common/laplace_args.h
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ *******************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <sys/time.h>
+#include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../../common/laplace_args.h"   // ROWS, COLUMNS, MAX_TEMP_ERROR
+#include "../../common/laplace_simd.h"
+
+// communication tags
+#define DOWN     100
+#define UP       101
+
+void initialize(int npes, int my_PE_num, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]);
+void track_progress(int iteration, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]);
+
+int main(int argc, char *argv[]) {
+
+    int max_iterations;
+    int iteration=1;
+    double dt = 0.0;
+    struct timeval start_time, stop_time, elapsed_time;
+
+    int        npes;                // number of PEs
+    int        my_PE_num;           // my PE number
+    int        provided;            // thread support MPI gives us
+    int        threads = 1;         // OpenMP threads per rank
+    double     dt_global=100;       // delta t across all PEs
+    MPI_Request requests[4];        // for non-blocking communication
+    int        req_count = 0;       // number of active requests
+
+    int64_t rows_per_process;
+    int64_t extra_rows;
+    int64_t my_rows;
+    int64_t pitch;                  // doubles from one row to the next
+
+    const char *simd_name = NULL;   // row kernel set, NULL = widest supported
+    int simd_report = 0;            // time the kernel sets first
+    const laplace_simd_kernels *simd;
+    const char *v;
+    int arg;
+
+    // only the master thread talks to MPI
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_PE_num);
+    MPI_Comm_size(MPI_COMM_WORLD, &npes);
+    if (provided < MPI_THREAD_FUNNELED) {
+        if (my_PE_num == 0) fprintf(stderr, "MPI library does not support MPI_THREAD_FUNNELED\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+
+    // every PE parses the same command line
+    max_iterations = laplace_parse_args(argc, argv);
+    pitch = laplace_grid_pitch(COLUMNS, LAPLACE_PITCH_PADDED);
+    for (arg = 1; arg < argc; arg++) {
+        if ((v = laplace_arg_value(argv[arg], "--pitch"))) {
+            pitch = laplace_parse_pitch(v, COLUMNS);
+        } else if ((v = laplace_arg_value(argv[arg], "--threads"))) {
+            threads = (int)laplace_parse_size(v, "--threads");
+        } else if ((v = laplace_arg_value(argv[arg], "--simd"))) {
+            simd_name = v;
+        } else if (strcmp(argv[arg], "--simd-report") == 0) {
+            simd_report = 1;
+        }
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#else
+    threads = 1;
+#endif
+    simd = laplace_simd_select(simd_name);
+    if (my_PE_num == 0) {
+        if (simd_report) laplace_simd_report(COLUMNS);
+        printf("Row kernels: %s\n", simd->name);
+        printf("Ranks: %d x threads: %d\n", npes, threads);
+        printf("Row pitch: %" PRId64 " doubles\n", pitch);
+    }
+
+    // same slabs as hw3_laplace_mpi_3.c
+    rows_per_process = ROWS / npes;
+    extra_rows = ROWS % npes;
+    my_rows = rows_per_process + (my_PE_num < extra_rows ? 1 : 0);
+
+    // one aligned block per grid, rows pitch doubles apart (after parsing:
+    // the row type depends on the pitch)
+    double (*Temperature)[pitch]      = laplace_alloc_pitched_grid(my_rows, pitch);
+    double (*Temperature_last)[pitch] = laplace_alloc_pitched_grid(my_rows, pitch);
+
+    // PE 0 asks for input
+    if(my_PE_num==0 && max_iterations < 0) {
+        printf("Maximum iterations [100-4000]?\n");
+        fflush(stdout);
+        scanf("%d", &max_iterations);
+    }
+
+    // bcast max iterations to other PEs
+    MPI_Bcast(&max_iterations, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (my_PE_num==0) gettimeofday(&start_time,NULL);
+
+    // both buffers: after the first swap Temperature holds the boundaries
+    initialize(npes, my_PE_num, my_rows, pitch, Temperature_last);
+    initialize(npes, my_PE_num, my_rows, pitch, Temperature);
+
+    // one parallel region for the whole solve; the loop test only reads
+    // values thread 0 wrote before the last barrier
+    #pragma omp parallel
+    {
+        int tid = 0, nth = 1;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        nth = omp_get_num_threads();
+#endif
+        // interior rows 2..my_rows-1 go to the workers: threads 1..n-1,
+        // or thread 0 alone when there is nobody else
+        int workers = (nth > 1) ? nth - 1 : 1;
+        int me = (nth > 1) ? tid - 1 : 0;
+        int64_t interior = (my_rows > 2) ? my_rows - 2 : 0;
+        int64_t lo = 2 + interior * me / workers;
+        int64_t hi = 2 + interior * (me + 1) / workers;
+        int64_t i;
+
+        while ( dt_global > MAX_TEMP_ERROR && iteration <= max_iterations ) {
+
+            // PHASE 1: the communication thread posts the ghost rows
+            if (tid == 0) {
+                req_count = 0;
+                if(my_PE_num != npes-1) {
+                    MPI_Isend(&Temperature_last[my_rows][1], COLUMNS, MPI_DOUBLE,
+                              my_PE_num+1, DOWN, MPI_COMM_WORLD, &requests[req_count++]);
+                    MPI_Irecv(&Temperature[my_rows+1][1], COLUMNS, MPI_DOUBLE,
+                              my_PE_num+1, UP, MPI_COMM_WORLD, &requests[req_count++]);
+                }
+                if(my_PE_num != 0) {
+                    MPI_Isend(&Temperature_last[1][1], COLUMNS, MPI_DOUBLE,
+                              my_PE_num-1, UP, MPI_COMM_WORLD, &requests[req_count++]);
+                    MPI_Irecv(&Temperature[0][1], COLUMNS, MPI_DOUBLE,
+                              my_PE_num-1, DOWN, MPI_COMM_WORLD, &requests[req_count++]);
+                }
+                // with workers around, drive the exchange to completion now
+                if (nth > 1) MPI_Waitall(req_count, requests, MPI_STATUSES_IGNORE);
+            }
+
+            // PHASE 2: interior rows, overlapping the exchange
+            if (tid > 0 || nth == 1) {
+                for(i = lo; i < hi; i++) {
+                    simd->stencil(&Temperature[i][1], &Temperature_last[i-1][1],
+                                  &Temperature_last[i][1], &Temperature_last[i+1][1], COLUMNS);
+                }
+            }
+            if (tid == 0 && nth == 1) MPI_Waitall(req_count, requests, MPI_STATUSES_IGNORE);
+
+            #pragma omp barrier
+
+            // PHASE 3: edge rows, their ghost rows are in Temperature[0] and [my_rows+1]
+            #pragma omp single
+            {
+                dt = 0.0;
+                simd->stencil(&Temperature[1][1], &Temperature[0][1],
+                              &Temperature_last[1][1], &Temperature_last[2][1], COLUMNS);
+                simd->stencil(&Temperature[my_rows][1], &Temperature_last[my_rows-1][1],
+                              &Temperature_last[my_rows][1], &Temperature[my_rows+1][1], COLUMNS);
+            }
+
+            // PHASE 4: local dt across all threads
+            #pragma omp for reduction(max:dt) schedule(static)
+            for(i = 1; i <= my_rows; i++){
+                dt = fmax(simd->maxdiff(&Temperature[i][1], &Temperature_last[i][1], COLUMNS), dt);
+            }
+
+            // PHASE 5: swap, global dt and progress, all on the communication thread
+            if (tid == 0) {
+                double (*temp_ptr)[pitch] = Temperature_last;
+                Temperature_last = Temperature;
+                Temperature = temp_ptr;
+
+                MPI_Allreduce(&dt, &dt_global, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+                if((iteration % 100) == 0) {
+                    if (my_PE_num == npes-1){
+                        track_progress(iteration, my_rows, pitch, Temperature_last);
+                    }
+                }
+                iteration++;
+            }
+
+            #pragma omp barrier
+        }
+    }
+
+    // Slightly more accurate timing and cleaner output
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // PE 0 finish timing and output values
+    if (my_PE_num==0){
+        gettimeofday(&stop_time,NULL);
+        timersub(&stop_time, &start_time, &elapsed_time);
+
+        printf("\nMax error at iteration %d was %f\n", iteration-1, dt_global);
+        printf("Total time was %f seconds.\n", elapsed_time.tv_sec+elapsed_time.tv_usec/1000000.0);
+        printf("Grid size: %" PRId64 "x%" PRId64 ", Processes: %d, Threads: %d\n",
+               (int64_t)ROWS, (int64_t)COLUMNS, npes, threads);
+    }
+
+    // Clean up dynamic memory
+    free(Temperature);
+    free(Temperature_last);
+
+    MPI_Finalize();
+    return 0;
+}
+
+void initialize(int npes, int my_PE_num, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]){
+
+    double tMin, tMax;  //Local boundary limits
+    int64_t i, j;
+
+    // Initialize all cells to 0.0
+    for(i = 0; i <= my_rows+1; i++){
+        for (j = 0; j <= COLUMNS+1; j++){
+            Temperature_last[i][j] = 0.0;
+        }
+    }
+
+    // Calculate this PE's portion of the global boundary
+    int64_t rows_per_process = ROWS / npes;
+    int64_t extra_rows = ROWS % npes;
+    int64_t my_start_row;
+
+    if (my_PE_num < extra_rows) {
+        my_start_row = my_PE_num * (rows_per_process + 1);
+    } else {
+        my_start_row = extra_rows * (rows_per_process + 1) +
+                       (my_PE_num - extra_rows) * rows_per_process;
+    }
+
+    // Local boundary condition endpoints
+    tMin = my_start_row * 100.0 / ROWS;
+    tMax = (my_start_row + my_rows) * 100.0 / ROWS;
+
+    // Left and right boundaries
+    for (i = 0; i <= my_rows+1; i++) {
+        Temperature_last[i][0] = 0.0;
+        Temperature_last[i][COLUMNS+1] = tMin + ((tMax-tMin)/my_rows)*i;
+    }
+
+    // Top boundary (PE 0 only)
+    if (my_PE_num == 0)
+        for (j = 0; j <= COLUMNS+1; j++)
+            Temperature_last[0][j] = 0.0;
+
+    // Bottom boundary (Last PE only)
+    if (my_PE_num == npes-1)
+        for (j=0; j<=COLUMNS+1; j++)
+            Temperature_last[my_rows+1][j] = (100.0/COLUMNS) * j;
+}
+
+// only called by last PE
+void track_progress(int iteration, int64_t my_rows, int64_t pitch, double (*Temperature_last)[pitch]) {
+
+    int64_t i;
+
+    printf("---------- Iteration number: %d ------------\n", iteration);
+
+    // output global coordinates so user doesn't have to understand decomposition
+    for(i = laplace_progress_reach(my_rows, COLUMNS); i >= 0; i--) {
+        printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", ROWS-i, COLUMNS-i, Temperature_last[my_rows-i][COLUMNS-i]);
+    }
+    printf("\n");
+}
@@ -0,0 +1,543 @@
+/*************************************************
+ * PMPI communication profiler for the MPI Laplace variants
+ *
+ *   mpicc -O3 hw3_laplace_mpi_3.c mpi_profile.c -o laplace_mpi.out -lm
+ *   mpirun -n 4 ./laplace_mpi.out ...
+ *
+ * or, without relinking, as a preloaded library:
+ *
+ *   mpicc -O3 -shared -fPIC mpi_profile.c -o libmpi_profile.so
+ *   mpirun -n 4 -x LD_PRELOAD=./libmpi_profile.so ./laplace_mpi.out ...
+ *
+ * Every MPI routine the Laplace codes call (laplace_mpi.c, the hw3
+ * variants, 2d, hybrid, shm, RMA, MPI-IO checkpoints) that moves data
+ * or can block on other ranks is wrapped here and forwarded to its
+ * PMPI_ name, so the solvers need no change. That includes the
+ * collective setup calls (Cart_create, Comm_split_type, window and file
+ * view setup). Local calls (Comm_rank, Type_*, Cart_shift, Info_*,
+ * Group_*, Win_shared_query) are not, and count as compute.
+ * Each rank counts per routine the calls, the payload bytes (count x
+ * type size) and the seconds spent inside. Time outside MPI between
+ * MPI_Init and MPI_Finalize is compute.
+ *
+ * Overlap: Isend, Irecv and Iallreduce note when each request was
+ * posted. When MPI_Wait/Waitall completes them, the window is from the
+ * earliest post to completion, and the time blocked in the wait is
+ * the part of it that compute did not hide:
+ *
+ *   overlap efficiency = (window - blocked) / window
+ *
+ * 100% means the messages arrived while the interior sweep ran; 0%
+ * means the wait was posted straight after the sends.
+ *
+ * At MPI_Finalize rank 0 gathers every rank's counters and prints:
+ *
+ *   Profile: one line per rank: wall, compute, MPI time by class
+ *            (p2p, wait, collective, rma, io), MB moved, overlap
+ *   Profile: one line per routine used: calls, MB, time min/mean/max
+ *            over the ranks
+ *   Profile: load imbalance max/mean of compute and of MPI time
+ *
+ * MPI_PROFILE_CSV=FILE also writes rank,routine,calls,bytes,seconds
+ * rows for every rank. Counters are not thread safe: the hybrid code
+ * calls MPI from its master thread only (MPI_THREAD_FUNNELED).
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <mpi.h>
+
+enum { PROFILE_P2P, PROFILE_WAIT, PROFILE_COLLECTIVE, PROFILE_RMA, PROFILE_IO, PROFILE_CLASSES };
+
+enum { P_SEND, P_RECV, P_SENDRECV, P_ISEND, P_IRECV, P_WAIT, P_WAITALL,
+       P_BARRIER, P_BCAST, P_REDUCE, P_ALLREDUCE, P_IALLREDUCE, P_GATHER, P_GATHERV, P_EXSCAN,
+       P_CART_CREATE, P_COMM_SPLIT_TYPE, P_COMM_FREE, P_WIN_ALLOCATE, P_WIN_ALLOCATE_SHARED, P_WIN_FREE,
+       P_PUT, P_WIN_LOCK_ALL, P_WIN_UNLOCK_ALL, P_WIN_FLUSH_ALL, P_WIN_SYNC,
+       P_FILE_OPEN, P_FILE_CLOSE, P_FILE_SET_VIEW, P_FILE_SET_SIZE, P_FILE_READ_AT, P_FILE_WRITE_AT,
+       P_FILE_READ_AT_ALL, P_FILE_WRITE_AT_ALL, P_ROUTINES };
+
+static const char *profile_names[P_ROUTINES] = {
+    "Send", "Recv", "Sendrecv", "Isend", "Irecv", "Wait", "Waitall",
+    "Barrier", "Bcast", "Reduce", "Allreduce", "Iallreduce", "Gather", "Gatherv", "Exscan",
+    "Cart_create", "Comm_split_type", "Comm_free", "Win_allocate", "Win_allocate_shared", "Win_free",
+    "Put", "Win_lock_all", "Win_unlock_all", "Win_flush_all", "Win_sync",
+    "File_open", "File_close", "File_set_view", "File_set_size", "File_read_at", "File_write_at",
+    "File_read_at_all", "File_write_at_all"
+};
+
+static const int profile_class[P_ROUTINES] = {
+    PROFILE_P2P, PROFILE_P2P, PROFILE_P2P, PROFILE_P2P, PROFILE_P2P, PROFILE_WAIT, PROFILE_WAIT,
+    PROFILE_COLLECTIVE, PROFILE_COLLECTIVE, PROFILE_COLLECTIVE, PROFILE_COLLECTIVE,
+    PROFILE_COLLECTIVE, PROFILE_COLLECTIVE, PROFILE_COLLECTIVE, PROFILE_COLLECTIVE,
+    PROFILE_COLLECTIVE, PROFILE_COLLECTIVE, PROFILE_COLLECTIVE, PROFILE_COLLECTIVE,
+    PROFILE_COLLECTIVE, PROFILE_COLLECTIVE,
+    PROFILE_RMA, PROFILE_RMA, PROFILE_RMA, PROFILE_RMA, PROFILE_RMA,
+    PROFILE_IO, PROFILE_IO, PROFILE_IO, PROFILE_IO, PROFILE_IO, PROFILE_IO, PROFILE_IO, PROFILE_IO
+};
+
+// one rank's counters, all doubles so rank 0 can gather them in one call
+typedef struct {
+    double calls[P_ROUTINES];
+    double bytes[P_ROUTINES];
+    double seconds[P_ROUTINES];
+    double wall;                    // MPI_Init to MPI_Finalize
+    double window;                  // post-to-completion time of waited requests
+    double blocked;                 // time blocked in those waits
+} profile_counters;
+
+#define PROFILE_FIELDS   (sizeof(profile_counters) / sizeof(double))
+#define PROFILE_INFLIGHT 64         // requests tracked for the overlap metric
+
+static profile_counters profile;
+static double profile_start;
+
+static struct {
+    MPI_Request request;
+    double posted;
+} profile_inflight[PROFILE_INFLIGHT];
+static int profile_inflight_count;
+
+
+static void profile_add(int routine, double start, double bytes) {
+    profile.calls[routine] += 1;
+    profile.bytes[routine] += bytes;
+    profile.seconds[routine] += PMPI_Wtime() - start;
+}
+
+static double profile_bytes(int count, MPI_Datatype type) {
+    int size = 0;
+    if (type != MPI_DATATYPE_NULL) PMPI_Type_size(type, &size);
+    return (double)count * size;
+}
+
+static void profile_post(MPI_Request request, double posted) {
+    if (profile_inflight_count < PROFILE_INFLIGHT) {
+        profile_inflight[profile_inflight_count].request = request;
+        profile_inflight[profile_inflight_count].posted = posted;
+        profile_inflight_count++;
+    }
+}
+
+// forget a request about to complete; returns when it was posted, or -1 if untracked
+static double profile_take(MPI_Request request) {
+    int k;
+    if (request == MPI_REQUEST_NULL) return -1;
+    for (k = 0; k < profile_inflight_count; k++) {
+        if (profile_inflight[k].request == request) {
+            double posted = profile_inflight[k].posted;
+            profile_inflight[k] = profile_inflight[--profile_inflight_count];
+            return posted;
+        }
+    }
+    return -1;
+}
+
+static void profile_overlap(double first_post, double start) {
+    if (first_post >= 0) {
+        double end = PMPI_Wtime();
+        profile.window += end - first_post;
+        profile.blocked += end - start;
+    }
+}
+
+
+/* ---------------- setup and report ---------------- */
+
+int MPI_Init(int *argc, char ***argv) {
+    int rc = PMPI_Init(argc, argv);
+    profile_start = PMPI_Wtime();
+    return rc;
+}
+
+int MPI_Init_thread(int *argc, char ***argv, int required, int *provided) {
+    int rc = PMPI_Init_thread(argc, argv, required, provided);
+    profile_start = PMPI_Wtime();
+    return rc;
+}
+
+static double profile_mpi_seconds(const profile_counters *c, int cls) {
+    double seconds = 0.0;
+    int r;
+    for (r = 0; r < P_ROUTINES; r++) {
+        if (cls < 0 || profile_class[r] == cls) seconds += c->seconds[r];
+    }
+    return seconds;
+}
+
+static double profile_mb(const profile_counters *c) {
+    double bytes = 0.0;
+    int r;
+    for (r = 0; r < P_ROUTINES; r++) bytes += c->bytes[r];
+    return bytes / 1e6;
+}
+
+static void profile_report(const profile_counters *all, int size) {
+    double compute_max = 0, compute_sum = 0, mpi_max = 0, mpi_sum = 0, window = 0, blocked = 0;
+    int compute_rank = 0, mpi_rank = 0, p, r, c;
+    const char *csv = getenv("MPI_PROFILE_CSV");
+
+    printf("Profile: %5s %10s %10s %10s %9s %9s %9s %9s %9s %10s %8s\n", "rank", "wall(s)", "compute",
+           "mpi", "p2p", "wait", "coll", "rma", "io", "MB", "overlap");
+    for (p = 0; p < size; p++) {
+        const profile_counters *a = &all[p];
+        double mpi = profile_mpi_seconds(a, -1), compute = a->wall - mpi;
+        char overlap[16] = "-";
+
+        if (a->window > 0) snprintf(overlap, sizeof(overlap), "%.1f%%", 100.0 * (a->window - a->blocked) / a->window);
+        printf("Profile: %5d %10.4f %10.4f %10.4f", p, a->wall, compute, mpi);
+        for (c = 0; c < PROFILE_CLASSES; c++) printf(" %9.4f", profile_mpi_seconds(a, c));
+        printf(" %10.2f %8s\n", profile_mb(a), overlap);
+
+        compute_sum += compute;
+        mpi_sum += mpi;
+        if (compute > compute_max) { compute_max = compute; compute_rank = p; }
+        if (mpi > mpi_max) { mpi_max = mpi; mpi_rank = p; }
+        window += a->window;
+        blocked += a->blocked;
+    }
+
+    printf("Profile: %-23s %10s %10s %10s %10s %10s\n", "routine", "calls", "MB", "min(s)", "mean(s)", "max(s)");
+    for (r = 0; r < P_ROUTINES; r++) {
+        double calls = 0, bytes = 0, low = all[0].seconds[r], high = 0, sum = 0;
+        for (p = 0; p < size; p++) {
+            calls += all[p].calls[r];
+            bytes += all[p].bytes[r];
+            sum += all[p].seconds[r];
+            if (all[p].seconds[r] < low) low = all[p].seconds[r];
+            if (all[p].seconds[r] > high) high = all[p].seconds[r];
+        }
+        if (calls == 0) continue;
+        printf("Profile: MPI_%-19s %10.0f %10.2f %10.4f %10.4f %10.4f\n", profile_names[r], calls,
+               bytes / 1e6, low, sum / size, high);
+    }
+
+    printf("Profile: imbalance compute max/mean %.3f (rank %d), mpi max/mean %.3f (rank %d)",
+           compute_sum > 0 ? compute_max / (compute_sum / size) : 1.0, compute_rank,
+           mpi_sum > 0 ? mpi_max / (mpi_sum / size) : 1.0, mpi_rank);
+    if (window > 0) printf(", overlap efficiency %.1f%%\n", 100.0 * (window - blocked) / window);
+    else printf(", no non-blocking requests waited on\n");
+
+    if (csv) {
+        FILE *f = fopen(csv, "w");
+        if (!f) {
+            perror(csv);
+            return;
+        }
+        fprintf(f, "rank,routine,calls,bytes,seconds\n");
+        for (p = 0; p < size; p++) {
+            for (r = 0; r < P_ROUTINES; r++) {
+                if (all[p].calls[r] == 0) continue;
+                fprintf(f, "%d,MPI_%s,%.0f,%.0f,%.9f\n", p, profile_names[r], all[p].calls[r],
+                        all[p].bytes[r], all[p].seconds[r]);
+            }
+            fprintf(f, "%d,compute,0,0,%.9f\n", p, all[p].wall - profile_mpi_seconds(&all[p], -1));
+        }
+        fclose(f);
+    }
+}
+
+int MPI_Finalize(void) {
+    profile_counters *all = NULL;
+    int rank, size;
+
+    profile.wall = PMPI_Wtime() - profile_start;
+    PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    PMPI_Comm_size(MPI_COMM_WORLD, &size);
+    if (rank == 0) all = malloc(size * sizeof(profile_counters));
+    PMPI_Gather(&profile, PROFILE_FIELDS, MPI_DOUBLE, all, PROFILE_FIELDS, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        profile_report(all, size);
+        fflush(stdout);
+        free(all);
+    }
+    return PMPI_Finalize();
+}
+
+
+/* ---------------- point to point ---------------- */
+
+int MPI_Send(const void *buf, int count, MPI_Datatype type, int dest, int tag, MPI_Comm comm) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Send(buf, count, type, dest, tag, comm);
+    profile_add(P_SEND, start, profile_bytes(count, type));
+    return rc;
+}
+
+int MPI_Recv(void *buf, int count, MPI_Datatype type, int source, int tag, MPI_Comm comm,
+             MPI_Status *status) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Recv(buf, count, type, source, tag, comm, status);
+    profile_add(P_RECV, start, profile_bytes(count, type));
+    return rc;
+}
+
+int MPI_Sendrecv(const void *sendbuf, int sendcount, MPI_Datatype sendtype, int dest, int sendtag,
+                 void *recvbuf, int recvcount, MPI_Datatype recvtype, int source, int recvtag,
+                 MPI_Comm comm, MPI_Status *status) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Sendrecv(sendbuf, sendcount, sendtype, dest, sendtag, recvbuf, recvcount, recvtype,
+                           source, recvtag, comm, status);
+    profile_add(P_SENDRECV, start, profile_bytes(sendcount, sendtype) + profile_bytes(recvcount, recvtype));
+    return rc;
+}
+
+int MPI_Isend(const void *buf, int count, MPI_Datatype type, int dest, int tag, MPI_Comm comm,
+              MPI_Request *request) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Isend(buf, count, type, dest, tag, comm, request);
+    profile_add(P_ISEND, start, profile_bytes(count, type));
+    profile_post(*request, start);
+    return rc;
+}
+
+int MPI_Irecv(void *buf, int count, MPI_Datatype type, int source, int tag, MPI_Comm comm,
+              MPI_Request *request) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Irecv(buf, count, type, source, tag, comm, request);
+    profile_add(P_IRECV, start, profile_bytes(count, type));
+    profile_post(*request, start);
+    return rc;
+}
+
+int MPI_Wait(MPI_Request *request, MPI_Status *status) {
+    double start = PMPI_Wtime();
+    double posted = profile_take(*request);
+    int rc = PMPI_Wait(request, status);
+    profile_overlap(posted, start);
+    profile_add(P_WAIT, start, 0);
+    return rc;
+}
+
+int MPI_Waitall(int count, MPI_Request requests[], MPI_Status statuses[]) {
+    double start = PMPI_Wtime(), first = -1;
+    int k, rc;
+
+    for (k = 0; k < count; k++) {
+        double posted = profile_take(requests[k]);
+        if (posted >= 0 && (first < 0 || posted < first)) first = posted;
+    }
+    rc = PMPI_Waitall(count, requests, statuses);
+    profile_overlap(first, start);
+    profile_add(P_WAITALL, start, 0);
+    return rc;
+}
+
+
+/* ---------------- collectives ---------------- */
+
+int MPI_Barrier(MPI_Comm comm) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Barrier(comm);
+    profile_add(P_BARRIER, start, 0);
+    return rc;
+}
+
+int MPI_Bcast(void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Bcast(buf, count, type, root, comm);
+    profile_add(P_BCAST, start, profile_bytes(count, type));
+    return rc;
+}
+
+int MPI_Reduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type, MPI_Op op, int root,
+               MPI_Comm comm) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Reduce(sendbuf, recvbuf, count, type, op, root, comm);
+    profile_add(P_REDUCE, start, profile_bytes(count, type));
+    return rc;
+}
+
+int MPI_Allreduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type, MPI_Op op,
+                  MPI_Comm comm) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Allreduce(sendbuf, recvbuf, count, type, op, comm);
+    profile_add(P_ALLREDUCE, start, profile_bytes(count, type));
+    return rc;
+}
+
+int MPI_Iallreduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type, MPI_Op op,
+                   MPI_Comm comm, MPI_Request *request) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Iallreduce(sendbuf, recvbuf, count, type, op, comm, request);
+    profile_add(P_IALLREDUCE, start, profile_bytes(count, type));
+    profile_post(*request, start);
+    return rc;
+}
+
+int MPI_Gather(const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf, int recvcount,
+               MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+    profile_add(P_GATHER, start, profile_bytes(sendcount, sendtype));
+    return rc;
+}
+
+int MPI_Gatherv(const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf,
+                const int recvcounts[], const int displs[], MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
+    profile_add(P_GATHERV, start, profile_bytes(sendcount, sendtype));
+    return rc;
+}
+
+int MPI_Exscan(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type, MPI_Op op, MPI_Comm comm) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Exscan(sendbuf, recvbuf, count, type, op, comm);
+    profile_add(P_EXSCAN, start, profile_bytes(count, type));
+    return rc;
+}
+
+// collective setup: no payload, but every rank waits for the others
+
+int MPI_Cart_create(MPI_Comm comm, int ndims, const int dims[], const int periods[], int reorder,
+                    MPI_Comm *cart) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Cart_create(comm, ndims, dims, periods, reorder, cart);
+    profile_add(P_CART_CREATE, start, 0);
+    return rc;
+}
+
+int MPI_Comm_split_type(MPI_Comm comm, int split_type, int key, MPI_Info info, MPI_Comm *newcomm) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Comm_split_type(comm, split_type, key, info, newcomm);
+    profile_add(P_COMM_SPLIT_TYPE, start, 0);
+    return rc;
+}
+
+int MPI_Comm_free(MPI_Comm *comm) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Comm_free(comm);
+    profile_add(P_COMM_FREE, start, 0);
+    return rc;
+}
+
+int MPI_Win_allocate(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm, void *baseptr,
+                     MPI_Win *win) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Win_allocate(size, disp_unit, info, comm, baseptr, win);
+    profile_add(P_WIN_ALLOCATE, start, 0);
+    return rc;
+}
+
+int MPI_Win_allocate_shared(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm, void *baseptr,
+                            MPI_Win *win) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Win_allocate_shared(size, disp_unit, info, comm, baseptr, win);
+    profile_add(P_WIN_ALLOCATE_SHARED, start, 0);
+    return rc;
+}
+
+int MPI_Win_free(MPI_Win *win) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Win_free(win);
+    profile_add(P_WIN_FREE, start, 0);
+    return rc;
+}
+
+
+/* ---------------- one-sided ---------------- */
+
+int MPI_Put(const void *origin, int origin_count, MPI_Datatype origin_type, int target_rank,
+            MPI_Aint target_disp, int target_count, MPI_Datatype target_type, MPI_Win win) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Put(origin, origin_count, origin_type, target_rank, target_disp, target_count,
+                      target_type, win);
+    profile_add(P_PUT, start, profile_bytes(origin_count, origin_type));
+    return rc;
+}
+
+int MPI_Win_lock_all(int assert, MPI_Win win) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Win_lock_all(assert, win);
+    profile_add(P_WIN_LOCK_ALL, start, 0);
+    return rc;
+}
+
+int MPI_Win_unlock_all(MPI_Win win) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Win_unlock_all(win);
+    profile_add(P_WIN_UNLOCK_ALL, start, 0);
+    return rc;
+}
+
+int MPI_Win_flush_all(MPI_Win win) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Win_flush_all(win);
+    profile_add(P_WIN_FLUSH_ALL, start, 0);
+    return rc;
+}
+
+int MPI_Win_sync(MPI_Win win) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_Win_sync(win);
+    profile_add(P_WIN_SYNC, start, 0);
+    return rc;
+}
+
+
+/* ---------------- MPI-IO ---------------- */
+
+int MPI_File_open(MPI_Comm comm, const char *filename, int amode, MPI_Info info, MPI_File *fh) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_File_open(comm, filename, amode, info, fh);
+    profile_add(P_FILE_OPEN, start, 0);
+    return rc;
+}
+
+int MPI_File_close(MPI_File *fh) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_File_close(fh);
+    profile_add(P_FILE_CLOSE, start, 0);
+    return rc;
+}
+
+int MPI_File_set_view(MPI_File fh, MPI_Offset disp, MPI_Datatype etype, MPI_Datatype filetype,
+                      const char *datarep, MPI_Info info) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_File_set_view(fh, disp, etype, filetype, datarep, info);
+    profile_add(P_FILE_SET_VIEW, start, 0);
+    return rc;
+}
+
+int MPI_File_set_size(MPI_File fh, MPI_Offset size) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_File_set_size(fh, size);
+    profile_add(P_FILE_SET_SIZE, start, 0);
+    return rc;
+}
+
+int MPI_File_read_at(MPI_File fh, MPI_Offset offset, void *buf, int count, MPI_Datatype type,
+                     MPI_Status *status) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_File_read_at(fh, offset, buf, count, type, status);
+    profile_add(P_FILE_READ_AT, start, profile_bytes(count, type));
+    return rc;
+}
+
+int MPI_File_write_at(MPI_File fh, MPI_Offset offset, const void *buf, int count, MPI_Datatype type,
+                      MPI_Status *status) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_File_write_at(fh, offset, buf, count, type, status);
+    profile_add(P_FILE_WRITE_AT, start, profile_bytes(count, type));
+    return rc;
+}
+
+int MPI_File_read_at_all(MPI_File fh, MPI_Offset offset, void *buf, int count, MPI_Datatype type,
+                         MPI_Status *status) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_File_read_at_all(fh, offset, buf, count, type, status);
+    profile_add(P_FILE_READ_AT_ALL, start, profile_bytes(count, type));
+    return rc;
+}
+
+int MPI_File_write_at_all(MPI_File fh, MPI_Offset offset, const void *buf, int count, MPI_Datatype type,
+                          MPI_Status *status) {
+    double start = PMPI_Wtime();
+    int rc = PMPI_File_write_at_all(fh, offset, buf, count, type, status);
+    profile_add(P_FILE_WRITE_AT_ALL, start, profile_bytes(count, type));
+    return rc;
+}
@@ -0,0 +1,90 @@
+/*************************************************
+ * In-process phase timers for the benchmark harness
+ *
+ * `time echo 4000 | ./a.out` also counts process startup, MPI launch
+ * and the terminal. Instead, a program keeps one bench_phases, marks
+ * the start, and charges the time since the last mark to a phase at
+ * each boundary:
+ *
+ *   bench_start(&b);
+ *   ... allocate, initialize ...        bench_lap(&b, BENCH_INIT);
+ *   loop: ... sweep ...                 bench_lap(&b, BENCH_COMPUTE);
+ *         ... ghost rows ...            bench_lap(&b, BENCH_HALO);
+ *         ... dt, Allreduce ...         bench_lap(&b, BENCH_REDUCTION);
+ *         ... progress, files ...       bench_lap(&b, BENCH_OUTPUT);
+ *
+ * so the phases add up to the wall time since bench_start. With
+ * --bench the program prints one line for HW/hw3/bench_harness.sh:
+ *
+ *   Bench: init I compute C halo H reduction R output O total T s,
+ *          U updates/s, peak RSS K KB, processes P
+ *
+ * where U is work units (cell updates, numbers tested) per second of
+ * compute + halo + reduction, and K is summed over the processes.
+ * Under MPI each phase is the slowest PE's, and the total is the
+ * slowest PE's total, not the sum of those.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef BENCH_PHASES_H
+#define BENCH_PHASES_H
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+enum { BENCH_INIT, BENCH_COMPUTE, BENCH_HALO, BENCH_REDUCTION, BENCH_OUTPUT, BENCH_PHASES };
+
+typedef struct {
+    double seconds[BENCH_PHASES];
+    double mark;                // time of the last phase boundary
+} bench_phases;
+
+
+static inline double bench_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline void bench_start(bench_phases *b) {
+    memset(b, 0, sizeof(*b));
+    b->mark = bench_clock();
+}
+
+// charge the time since the last boundary to phase
+static inline void bench_lap(bench_phases *b, int phase) {
+    double now = bench_clock();
+    b->seconds[phase] += now - b->mark;
+    b->mark = now;
+}
+
+// this process's peak resident set in KB (Linux reports ru_maxrss in KB)
+static inline long bench_peak_rss(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static inline double bench_total(const bench_phases *b) {
+    double total = 0.0;
+    int p;
+    for (p = 0; p < BENCH_PHASES; p++) total += b->seconds[p];
+    return total;
+}
+
+// seconds is one per phase
+static inline void bench_report(const double *seconds, double total, double work_units,
+                                long peak_rss_kb, int processes) {
+    double solve = seconds[BENCH_COMPUTE] + seconds[BENCH_HALO] + seconds[BENCH_REDUCTION];
+    printf("Bench: init %.6f compute %.6f halo %.6f reduction %.6f output %.6f total %.6f s, "
+           "%.4g updates/s, peak RSS %ld KB, processes %d\n",
+           seconds[BENCH_INIT], seconds[BENCH_COMPUTE], seconds[BENCH_HALO],
+           seconds[BENCH_REDUCTION], seconds[BENCH_OUTPUT], total,
+           solve > 0 ? work_units / solve : 0.0, peak_rss_kb, processes);
+}
+
+#endif
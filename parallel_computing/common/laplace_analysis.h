@@ -0,0 +1,413 @@
+/*************************************************
+ * In-situ analysis of the Laplace plate
+ *
+ * Runs on the live grid at chosen iterations and keeps only small
+ * results, never the field itself:
+ *
+ *   statistics   min, max, mean, standard deviation and a
+ *                LAPLACE_ANALYSIS_BINS-bin histogram over [0, 100],
+ *                one OpenMP reduction over the interior
+ *   thumbnail    the interior decimated by a factor F: each pixel is
+ *                the mean of an F x F block, one thread per pixel row
+ *   isotherms    marching squares over every grid cell, boundaries
+ *                included, for up to LAPLACE_ANALYSIS_MAX_LEVELS
+ *                temperatures. One pass counts each cell row's
+ *                segments per level, a prefix sum places them, a
+ *                second pass writes them, so the output is in row
+ *                order whatever the thread count. Saddle cells are
+ *                split by their centre value
+ *
+ * The compute calls take a block of rows, so an MPI PE can run them on
+ * its own rows: grid points to local row 0 (a ghost or boundary row),
+ * row_offset is the global row of that row, and the block's statistics
+ * and thumbnail block sums add up across PEs. Cell row i joins rows i
+ * and i+1; `below`, if given, stands in for row last_cell+1.
+ *
+ * The writer appends to PREFIX.stats and writes, per analysis,
+ *
+ *   PREFIX_IIIIII.pgm   the thumbnail, 8-bit greyscale over [0, 100]
+ *   PREFIX_IIIIII.iso   isotherm segments as "x y" point pairs
+ *                       (x = column, y = row, from the top left
+ *                       boundary corner), blank-line separated, so
+ *                       gnuplot draws them with `plot f with lines`
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_ANALYSIS_H
+#define LAPLACE_ANALYSIS_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+
+#define LAPLACE_ANALYSIS_BINS        20     // histogram bins over [0, LAPLACE_ANALYSIS_TMAX]
+#define LAPLACE_ANALYSIS_TMAX        100.0  // hottest boundary temperature
+#define LAPLACE_ANALYSIS_MAX_LEVELS  16
+#define LAPLACE_ANALYSIS_THUMBNAIL   256    // default thumbnail edge in pixels
+
+typedef struct {
+    double min, max;
+    double sum, sum_squares;
+    int64_t histogram[LAPLACE_ANALYSIS_BINS];
+} laplace_stats;
+
+typedef struct {
+    float x0, y0, x1, y1;
+} laplace_segment;
+
+typedef struct {
+    const char *prefix;
+    int every;                          // iterations between analyses, 0 = final plate only
+    int writer;                         // this process writes the files
+    int64_t rows, columns;              // global interior
+    int64_t factor;                     // decimation
+    int64_t thumb_rows, thumb_columns;
+    int levels;
+    double level[LAPLACE_ANALYSIS_MAX_LEVELS];
+
+    laplace_stats stats;                // of the last compute
+    double *thumb;                      // block sums
+    int64_t cell_rows;                  // most cell rows a compute may cover
+    int64_t *counts;                    // segments per (level, cell row)
+    laplace_segment *segments;          // level after level, row order within a level
+    int64_t capacity;
+    int64_t level_segments[LAPLACE_ANALYSIS_MAX_LEVELS];
+
+    FILE *stats_file;
+    int runs;
+    double seconds;                     // spent in analyses
+    double bytes;                       // written
+} laplace_analysis;
+
+
+static inline double laplace_analysis_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+// levels is "L1,L2,..." or NULL for 10, 20, ..., 90; factor 0 picks one
+// that keeps the thumbnail within LAPLACE_ANALYSIS_THUMBNAIL pixels.
+// cell_rows is the most cell rows one compute call covers
+static inline void laplace_analysis_init(laplace_analysis *a, const char *prefix, int every,
+                                         int64_t factor, const char *levels, int64_t rows,
+                                         int64_t columns, int64_t cell_rows, int writer) {
+    int64_t edge = rows > columns ? rows : columns;
+
+    memset(a, 0, sizeof(*a));
+    a->prefix = prefix;
+    a->every = every;
+    a->writer = writer;
+    a->rows = rows;
+    a->columns = columns;
+    a->factor = factor > 0 ? factor : (edge + LAPLACE_ANALYSIS_THUMBNAIL - 1) / LAPLACE_ANALYSIS_THUMBNAIL;
+    a->thumb_rows = (rows + a->factor - 1) / a->factor;
+    a->thumb_columns = (columns + a->factor - 1) / a->factor;
+
+    if (levels) {
+        const char *p = levels;
+        char *end;
+        while (*p && a->levels < LAPLACE_ANALYSIS_MAX_LEVELS) {
+            a->level[a->levels++] = strtod(p, &end);
+            if (end == p || (*end && *end != ',')) {
+                fprintf(stderr, "--isotherms needs comma-separated temperatures, got '%s'\n", levels);
+                exit(1);
+            }
+            p = *end ? end + 1 : end;
+        }
+    } else {
+        for (a->levels = 0; a->levels < 9; a->levels++) a->level[a->levels] = 10.0 * (a->levels + 1);
+    }
+
+    a->cell_rows = cell_rows;
+    a->thumb = malloc(a->thumb_rows * a->thumb_columns * sizeof(double));
+    a->counts = malloc(a->levels * (cell_rows + 1) * sizeof(int64_t));
+    if (!a->thumb || !a->counts) {
+        fprintf(stderr, "Analysis: cannot allocate a %" PRId64 " x %" PRId64 " thumbnail\n",
+                a->thumb_rows, a->thumb_columns);
+        exit(1);
+    }
+
+    if (writer) {
+        char path[4096];
+        int b;
+        snprintf(path, sizeof(path), "%s.stats", prefix);
+        a->stats_file = fopen(path, "w");
+        if (!a->stats_file) {
+            perror(path);
+            exit(1);
+        }
+        fprintf(a->stats_file, "# iteration min max mean stddev, then histogram counts from");
+        for (b = 0; b < LAPLACE_ANALYSIS_BINS; b++)
+            fprintf(a->stats_file, " %g", b * LAPLACE_ANALYSIS_TMAX / LAPLACE_ANALYSIS_BINS);
+        fprintf(a->stats_file, "\n");
+    }
+}
+
+
+static inline void laplace_analysis_stats(laplace_analysis *a, const double *grid, int64_t stride,
+                                          int64_t rows) {
+    double mn = grid[stride + 1], mx = mn, sum = 0.0, sum_squares = 0.0;
+    int64_t histogram[LAPLACE_ANALYSIS_BINS] = {0};
+    int64_t i, j;
+
+#ifdef _OPENMP
+    #pragma omp parallel for private(j) reduction(min:mn) reduction(max:mx) \
+            reduction(+:sum, sum_squares, histogram[:LAPLACE_ANALYSIS_BINS])
+#endif
+    for (i = 1; i <= rows; i++) {
+        const double *row = grid + i * stride;
+        for (j = 1; j <= a->columns; j++) {
+            double t = row[j];
+            int b = (int)(t * (LAPLACE_ANALYSIS_BINS / LAPLACE_ANALYSIS_TMAX));
+            if (b < 0) b = 0;
+            if (b >= LAPLACE_ANALYSIS_BINS) b = LAPLACE_ANALYSIS_BINS - 1;
+            histogram[b]++;
+            mn = t < mn ? t : mn;
+            mx = t > mx ? t : mx;
+            sum += t;
+            sum_squares += t * t;
+        }
+    }
+    a->stats.min = mn;
+    a->stats.max = mx;
+    a->stats.sum = sum;
+    a->stats.sum_squares = sum_squares;
+    memcpy(a->stats.histogram, histogram, sizeof(histogram));
+}
+
+
+// block sums of interior rows row_offset .. row_offset+rows-1 (0-based);
+// pixels outside those rows stay zero
+static inline void laplace_analysis_decimate(laplace_analysis *a, const double *grid, int64_t stride,
+                                             int64_t row_offset, int64_t rows) {
+    int64_t f = a->factor;
+    int64_t tr, g, j;
+
+    memset(a->thumb, 0, a->thumb_rows * a->thumb_columns * sizeof(double));
+    if (rows < 1) return;
+
+#ifdef _OPENMP
+    #pragma omp parallel for private(g, j)
+#endif
+    for (tr = row_offset / f; tr <= (row_offset + rows - 1) / f; tr++) {
+        double *pixels = a->thumb + tr * a->thumb_columns;
+        int64_t first = tr * f > row_offset ? tr * f : row_offset;
+        int64_t last = (tr + 1) * f < row_offset + rows ? (tr + 1) * f : row_offset + rows;
+        for (g = first; g < last; g++) {
+            const double *row = grid + (g - row_offset + 1) * stride + 1;
+            for (j = 0; j < a->columns; j++) pixels[j / f] += row[j];
+        }
+    }
+}
+
+
+// segments a level cuts through the cell with corners a (top left), b
+// (top right), c (bottom right), d (bottom left) at (x, y); written to
+// out unless it is NULL
+static inline int laplace_analysis_cell(double a, double b, double c, double d, double level,
+                                        float x, float y, laplace_segment *out) {
+    int sa = a >= level, sb = b >= level, sc = c >= level, sd = d >= level;
+    int crossed = (sa != sb) + (sb != sc) + (sc != sd) + (sd != sa);
+    float px[4], py[4];
+    int n = 0;
+
+    if (!out || crossed == 0) return crossed / 2;
+
+    // crossings in the order top, right, bottom, left
+    if (sa != sb) { px[n] = x + (float)((level - a) / (b - a)); py[n++] = y; }
+    if (sb != sc) { px[n] = x + 1; py[n++] = y + (float)((level - b) / (c - b)); }
+    if (sc != sd) { px[n] = x + (float)((level - d) / (c - d)); py[n++] = y + 1; }
+    if (sd != sa) { px[n] = x; py[n++] = y + (float)((level - a) / (d - a)); }
+
+    if (n == 2) {
+        out[0] = (laplace_segment){px[0], py[0], px[1], py[1]};
+        return 1;
+    }
+    // saddle: the centre decides which corners the contour cuts off
+    if (((a + b + c + d) * 0.25 >= level) == sa) {
+        out[0] = (laplace_segment){px[0], py[0], px[1], py[1]};   // around b
+        out[1] = (laplace_segment){px[2], py[2], px[3], py[3]};   // around d
+    } else {
+        out[0] = (laplace_segment){px[0], py[0], px[3], py[3]};   // around a
+        out[1] = (laplace_segment){px[1], py[1], px[2], py[2]};   // around c
+    }
+    return 2;
+}
+
+
+static inline const double *laplace_analysis_row(const double *grid, int64_t stride, int64_t i,
+                                                 int64_t last_cell, const double *below) {
+    return (below && i == last_cell + 1) ? below : grid + i * stride;
+}
+
+
+// isotherm segments of cell rows first_cell .. last_cell
+static inline void laplace_analysis_isotherms(laplace_analysis *a, const double *grid, int64_t stride,
+                                              int64_t row_offset, int64_t first_cell, int64_t last_cell,
+                                              const double *below) {
+    int64_t cells = last_cell - first_cell + 1;
+    int64_t i, j, total = 0;
+    int l;
+
+    // pass 1: segments per level and cell row
+#ifdef _OPENMP
+    #pragma omp parallel for private(j, l)
+#endif
+    for (i = first_cell; i <= last_cell; i++) {
+        const double *up = laplace_analysis_row(grid, stride, i, last_cell, below);
+        const double *down = laplace_analysis_row(grid, stride, i + 1, last_cell, below);
+        for (l = 0; l < a->levels; l++) {
+            int64_t n = 0;
+            for (j = 0; j <= a->columns; j++)
+                n += laplace_analysis_cell(up[j], up[j+1], down[j+1], down[j], a->level[l], 0, 0, NULL);
+            a->counts[l * cells + (i - first_cell)] = n;
+        }
+    }
+
+    // exclusive prefix sum, level-major, so each level's segments are contiguous
+    for (l = 0; l < a->levels; l++) {
+        a->level_segments[l] = 0;
+        for (i = 0; i < cells; i++) {
+            int64_t n = a->counts[l * cells + i];
+            a->counts[l * cells + i] = total;
+            a->level_segments[l] += n;
+            total += n;
+        }
+    }
+    if (total > a->capacity) {
+        free(a->segments);
+        a->capacity = total + total / 4;
+        a->segments = malloc(a->capacity * sizeof(laplace_segment));
+        if (!a->segments) {
+            fprintf(stderr, "Analysis: cannot allocate %" PRId64 " isotherm segments\n", total);
+            exit(1);
+        }
+    }
+
+    // pass 2: each row writes into the slots pass 1 reserved
+#ifdef _OPENMP
+    #pragma omp parallel for private(j, l)
+#endif
+    for (i = first_cell; i <= last_cell; i++) {
+        const double *up = laplace_analysis_row(grid, stride, i, last_cell, below);
+        const double *down = laplace_analysis_row(grid, stride, i + 1, last_cell, below);
+        for (l = 0; l < a->levels; l++) {
+            laplace_segment *out = a->segments + a->counts[l * cells + (i - first_cell)];
+            for (j = 0; j <= a->columns; j++)
+                out += laplace_analysis_cell(up[j], up[j+1], down[j+1], down[j], a->level[l],
+                                             (float)j, (float)(row_offset + i), out);
+        }
+    }
+}
+
+
+// statistics, thumbnail sums and isotherms of one block of rows (see top)
+static inline void laplace_analysis_compute(laplace_analysis *a, const double *grid, int64_t stride,
+                                            int64_t row_offset, int64_t rows, int64_t first_cell,
+                                            int64_t last_cell, const double *below) {
+    laplace_analysis_stats(a, grid, stride, rows);
+    laplace_analysis_decimate(a, grid, stride, row_offset, rows);
+    laplace_analysis_isotherms(a, grid, stride, row_offset, first_cell, last_cell, below);
+}
+
+
+// write the results for the whole plate: stats and thumbnail sums over
+// every interior cell, segments level after level
+static inline void laplace_analysis_write(laplace_analysis *a, int iteration, const laplace_stats *s,
+                                          const double *thumb, const laplace_segment *segments,
+                                          const int64_t *level_segments) {
+    double cells = (double)a->rows * a->columns;
+    double mean = s->sum / cells;
+    double variance = s->sum_squares / cells - mean * mean;
+    char path[4096];
+    unsigned char *pixels;
+    FILE *f;
+    int64_t i, j, n;
+    int l, b;
+
+    if (s != &a->stats) a->stats = *s;
+    fprintf(a->stats_file, "%d %.6f %.6f %.6f %.6f", iteration, s->min, s->max, mean,
+            variance > 0 ? sqrt(variance) : 0.0);
+    for (b = 0; b < LAPLACE_ANALYSIS_BINS; b++) fprintf(a->stats_file, " %" PRId64, s->histogram[b]);
+    fprintf(a->stats_file, "\n");
+    fflush(a->stats_file);
+
+    // thumbnail: block means, edge blocks may be short
+    pixels = malloc(a->thumb_rows * a->thumb_columns);
+    for (i = 0; i < a->thumb_rows; i++) {
+        int64_t block_rows = (i + 1) * a->factor < a->rows ? a->factor : a->rows - i * a->factor;
+        for (j = 0; j < a->thumb_columns; j++) {
+            int64_t block_columns = (j + 1) * a->factor < a->columns ? a->factor : a->columns - j * a->factor;
+            double t = thumb[i * a->thumb_columns + j] / (block_rows * block_columns);
+            double v = t * 255.0 / LAPLACE_ANALYSIS_TMAX + 0.5;
+            pixels[i * a->thumb_columns + j] = v < 0 ? 0 : v > 255 ? 255 : (unsigned char)v;
+        }
+    }
+    snprintf(path, sizeof(path), "%s_%06d.pgm", a->prefix, iteration);
+    f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    fprintf(f, "P5\n%" PRId64 " %" PRId64 "\n255\n", a->thumb_columns, a->thumb_rows);
+    fwrite(pixels, 1, a->thumb_rows * a->thumb_columns, f);
+    a->bytes += ftell(f);
+    fclose(f);
+    free(pixels);
+
+    snprintf(path, sizeof(path), "%s_%06d.iso", a->prefix, iteration);
+    f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    for (l = 0; l < a->levels; l++) {
+        fprintf(f, "# isotherm %g, %" PRId64 " segments\n", a->level[l], level_segments[l]);
+        for (n = 0; n < level_segments[l]; n++, segments++)
+            fprintf(f, "%.3f %.3f\n%.3f %.3f\n\n", segments->x0, segments->y0, segments->x1, segments->y1);
+        fprintf(f, "\n");
+    }
+    a->bytes += ftell(f);
+    fclose(f);
+    a->runs++;
+}
+
+
+// compute and write in one process (the OpenMP and serial solvers);
+// grid is the whole plate, rows+2 rows stride doubles apart
+static inline void laplace_analysis_run(laplace_analysis *a, const double *grid, int64_t stride,
+                                        int iteration) {
+    double start = laplace_analysis_clock();
+    laplace_analysis_compute(a, grid, stride, 0, a->rows, 0, a->rows, NULL);
+    laplace_analysis_write(a, iteration, &a->stats, a->thumb, a->segments, a->level_segments);
+    a->seconds += laplace_analysis_clock() - start;
+}
+
+
+// print what was done and free everything
+static inline void laplace_analysis_close(laplace_analysis *a) {
+    if (a->writer) {
+        fclose(a->stats_file);
+        if (a->runs > 0) {
+            double cells = (double)a->rows * a->columns;
+            printf("Analysis: %d runs to %s.*, %.3f s each, %.1f KB written (the plate is %.1f MB), "
+                   "thumbnail %" PRId64 "x%" PRId64 "\n", a->runs, a->prefix, a->seconds / a->runs,
+                   a->bytes / a->runs / 1e3, cells * sizeof(double) / 1e6, a->thumb_columns, a->thumb_rows);
+            printf("Final plate: min %.4f, max %.4f, mean %.4f\n", a->stats.min, a->stats.max,
+                   a->stats.sum / cells);
+        }
+    }
+    free(a->thumb);
+    free(a->counts);
+    free(a->segments);
+}
+
+#endif
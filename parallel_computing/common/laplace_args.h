@@ -0,0 +1,231 @@
+/*************************************************
+ * Laplace run-time problem setup
+ *
+ * Shared by every C Laplace variant so the plate size, the error
+ * tolerance and the iteration limit come from the command line:
+ *
+ *   ./laplace.out [--rows=N] [--columns=N] [--size=N]
+ *                 [--max-temp-error=E] [--max-iterations=N]
+ *
+ * ROWS, COLUMNS and MAX_TEMP_ERROR keep the names the solvers always
+ * used, but are now variables filled in by laplace_parse_args().
+ * Compiling with -DROWS=1000 -DCOLUMNS=1000 turns the plate size back
+ * into compile-time constants; HW/hw1/ex1/bench_runtime_sizes.sh builds both
+ * ways to check the hot loops run at the same speed.
+ *
+ * Grid indexes are int64_t so plates over 2^31 cells work. Grids are
+ * pointers to rows, double (*T)[COLUMNS+2], so the stencil code still
+ * reads T[i][j]; the row type is fixed when the pointer is declared,
+ * so declare grids only after laplace_parse_args() has run.
+ * laplace_alloc_pitched_grid() is the same with a row pitch chosen by
+ * laplace_grid_pitch(): one 64-byte aligned block, rows padded apart,
+ * declared double (*T)[pitch] so T[i][j] still reads the same.
+ * When --max-iterations is not given the solvers fall back to the
+ * old "Maximum iterations [100-4000]?" prompt, so the existing
+ * `echo 4000 | ./a.out` scripts keep working.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_ARGS_H
+#define LAPLACE_ARGS_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+
+// size of plate
+#if defined(ROWS) && defined(COLUMNS)
+#define LAPLACE_FIXED_SIZE 1
+#elif defined(ROWS) || defined(COLUMNS)
+#error "define both ROWS and COLUMNS, or neither"
+#else
+static int64_t ROWS    = 1000;
+static int64_t COLUMNS = 1000;
+#endif
+
+// largest permitted change in temp (This value takes about 3400 steps)
+static double MAX_TEMP_ERROR = 0.01;
+
+// value of "--name=value" if arg is that option, NULL otherwise
+static inline const char *laplace_arg_value(const char *arg, const char *name) {
+    size_t n = strlen(name);
+    if (strncmp(arg, name, n) == 0 && arg[n] == '=') return arg + n + 1;
+    return NULL;
+}
+
+static inline int64_t laplace_parse_size(const char *value, const char *name) {
+    char *end;
+    long long n = strtoll(value, &end, 10);
+    if (*end != '\0' || n < 1) {
+        fprintf(stderr, "%s must be a positive integer, got '%s'\n", name, value);
+        exit(1);
+    }
+    return (int64_t)n;
+}
+
+// a tolerance >= 0; 0 never converges, so the run goes to --max-iterations
+static inline double laplace_parse_error(const char *value, const char *name) {
+    char *end;
+    double e = strtod(value, &end);
+    if (end == value || *end != '\0' || !isfinite(e) || e < 0.0) {
+        fprintf(stderr, "%s must be a number >= 0, got '%s'\n", name, value);
+        exit(1);
+    }
+    return e;
+}
+
+static inline int laplace_parse_int(const char *value, const char *name) {
+    int64_t n = laplace_parse_size(value, name);
+    if (n > INT_MAX) {
+        fprintf(stderr, "%s must be at most %d, got '%s'\n", name, INT_MAX, value);
+        exit(1);
+    }
+    return (int)n;
+}
+
+static inline void laplace_set_size(int64_t *dim, int64_t n, const char *name) {
+#ifdef LAPLACE_FIXED_SIZE
+    if (n != *dim) {
+        fprintf(stderr, "%s is fixed at %" PRId64 " in this build\n", name, *dim);
+        exit(1);
+    }
+#else
+    (void)name;
+    *dim = n;
+#endif
+}
+
+// Parse the common options. Options a solver adds on top of these are
+// left alone so it can pick them up with laplace_arg_value().
+// Returns --max-iterations, or -1 if the caller should prompt for it.
+static inline int laplace_parse_args(int argc, char *argv[]) {
+
+    int max_iterations = -1;
+    int64_t rows = ROWS, columns = COLUMNS;
+    const char *v;
+    int k;
+
+    for (k = 1; k < argc; k++) {
+        if ((v = laplace_arg_value(argv[k], "--rows"))) {
+            rows = laplace_parse_size(v, "--rows");
+        } else if ((v = laplace_arg_value(argv[k], "--columns"))) {
+            columns = laplace_parse_size(v, "--columns");
+        } else if ((v = laplace_arg_value(argv[k], "--size"))) {
+            rows = columns = laplace_parse_size(v, "--size");
+        } else if ((v = laplace_arg_value(argv[k], "--max-temp-error"))) {
+            MAX_TEMP_ERROR = laplace_parse_error(v, "--max-temp-error");
+        } else if ((v = laplace_arg_value(argv[k], "--max-iterations"))) {
+            max_iterations = laplace_parse_int(v, "--max-iterations");
+        }
+    }
+
+#ifdef LAPLACE_FIXED_SIZE
+    {
+        int64_t fixed_rows = ROWS, fixed_columns = COLUMNS;
+        laplace_set_size(&fixed_rows, rows, "ROWS");
+        laplace_set_size(&fixed_columns, columns, "COLUMNS");
+    }
+#else
+    laplace_set_size(&ROWS, rows, "ROWS");
+    laplace_set_size(&COLUMNS, columns, "COLUMNS");
+#endif
+
+    return max_iterations;
+}
+
+// how far the progress printers step back from the bottom right corner:
+// they sample cells (rows-k, columns-k) for k = this down to 0, at most
+// six of them, and a plate or PE block under 6 cells wide gets fewer
+static inline int64_t laplace_progress_reach(int64_t rows, int64_t columns) {
+    int64_t n = rows < columns ? rows : columns;
+    return n < 6 ? n - 1 : 5;
+}
+
+// bytes for a (rows+2) x (columns+2) grid including the ghost/boundary frame
+static inline size_t laplace_grid_bytes(int64_t rows, int64_t columns) {
+    return (size_t)(rows + 2) * (size_t)(columns + 2) * sizeof(double);
+}
+
+// zero-filled grid (like the old static arrays); exits if it does not fit
+static inline void *laplace_alloc_grid(int64_t rows, int64_t columns) {
+    void *grid = calloc((size_t)(rows + 2) * (size_t)(columns + 2), sizeof(double));
+    if (!grid) {
+        fprintf(stderr, "Cannot allocate a %" PRId64 " x %" PRId64 " grid (%zu bytes)\n",
+                rows + 2, columns + 2, laplace_grid_bytes(rows, columns));
+        exit(1);
+    }
+    return grid;
+}
+
+// same, but starting on a 64-byte (cache line) boundary for aligned simd loops
+static inline void *laplace_alloc_aligned_grid(int64_t rows, int64_t columns) {
+    size_t bytes = (laplace_grid_bytes(rows, columns) + 63) & ~(size_t)63;
+    void *grid = aligned_alloc(64, bytes);
+    if (!grid) {
+        fprintf(stderr, "Cannot allocate a %" PRId64 " x %" PRId64 " grid (%zu bytes)\n",
+                rows + 2, columns + 2, bytes);
+        exit(1);
+    }
+    memset(grid, 0, bytes);
+    return grid;
+}
+
+
+// Row pitch, the doubles from the start of one row to the next, for
+// laplace_alloc_pitched_grid():
+//   packed   columns+2, the layout of laplace_alloc_grid()
+//   aligned  rounded up to whole cache lines, so every row starts on one
+//   padded   aligned, plus a line while the pitch is a multiple of 2 KB:
+//            rows i-1, i and i+1 (4 KB apart for 510 or 1022 columns)
+//            would map to the same L1 sets and alias in the load/store
+//            queue. 1022 columns: 1024 -> 1032
+enum { LAPLACE_PITCH_PACKED, LAPLACE_PITCH_ALIGNED, LAPLACE_PITCH_PADDED };
+
+static inline int64_t laplace_grid_pitch(int64_t columns, int policy) {
+    int64_t pitch = columns + 2;
+    if (policy == LAPLACE_PITCH_PACKED) return pitch;
+    pitch = (pitch + 7) & ~(int64_t)7;
+    if (policy == LAPLACE_PITCH_PADDED) {
+        while ((pitch * (int64_t)sizeof(double)) % 2048 == 0) pitch += 8;
+    }
+    return pitch;
+}
+
+// --pitch=packed|aligned|padded, or a number of doubles >= columns+2
+static inline int64_t laplace_parse_pitch(const char *value, int64_t columns) {
+    static const char *names[] = { "packed", "aligned", "padded" };
+    int64_t pitch;
+    int policy;
+    for (policy = LAPLACE_PITCH_PACKED; policy <= LAPLACE_PITCH_PADDED; policy++) {
+        if (strcmp(value, names[policy]) == 0) return laplace_grid_pitch(columns, policy);
+    }
+    pitch = laplace_parse_size(value, "--pitch");
+    if (pitch < columns + 2) {
+        fprintf(stderr, "--pitch must be packed, aligned, padded or at least %" PRId64 ", got '%s'\n",
+                columns + 2, value);
+        exit(1);
+    }
+    return pitch;
+}
+
+// zero-filled (rows+2) x pitch grid in one 64-byte aligned block, for
+// double (*T)[pitch]; exits if it does not fit
+static inline void *laplace_alloc_pitched_grid(int64_t rows, int64_t pitch) {
+    size_t bytes = ((size_t)(rows + 2) * (size_t)pitch * sizeof(double) + 63) & ~(size_t)63;
+    void *grid = aligned_alloc(64, bytes);
+    if (!grid) {
+        fprintf(stderr, "Cannot allocate a %" PRId64 " x %" PRId64 " grid (%zu bytes)\n",
+                rows + 2, pitch, bytes);
+        exit(1);
+    }
+    memset(grid, 0, bytes);
+    return grid;
+}
+
+#endif
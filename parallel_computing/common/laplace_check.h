@@ -0,0 +1,97 @@
+/*************************************************
+ * Convergence-check policy for the Laplace solvers
+ *
+ * Computing dt costs a full max-reduction over the plate, and with MPI
+ * a global Allreduce, every iteration. The solvers only need it often
+ * enough to stop near the first iteration with dt <= MAX_TEMP_ERROR:
+ *
+ *   --check-every=N     measure dt on every Nth iteration
+ *   --check-every=auto  space checks by the measured decay of dt: each
+ *                       gap is half the predicted iterations left,
+ *                       between 1 and LAPLACE_CHECK_MAX, and at most
+ *                       double the previous one; near convergence
+ *                       every iteration is checked
+ *
+ * The default checks every iteration. The iteration a solver reports
+ * is the check that saw dt under the tolerance, so it is at most one
+ * check interval past the iteration a per-iteration check stops on.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_CHECK_H
+#define LAPLACE_CHECK_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define LAPLACE_CHECK_MAX 64   // longest adaptive gap between checks
+
+typedef struct {
+    int every;          // fixed interval, 0 = adaptive
+    int next;           // next iteration to check
+    int gap;            // last adaptive gap
+    int checks;         // checks done so far
+    int last_iteration; // iteration and dt of the previous check
+    double last_dt;
+    double tolerance;
+} laplace_check;
+
+
+// spec is "N", "auto" or NULL (every iteration)
+static inline void laplace_check_init(laplace_check *c, const char *spec, double tolerance) {
+    memset(c, 0, sizeof(*c));
+    c->every = 1;
+    c->next = 1;
+    c->gap = 1;
+    c->tolerance = tolerance;
+    if (spec && strcmp(spec, "auto") == 0) {
+        c->every = 0;
+    } else if (spec) {
+        c->every = atoi(spec);
+        if (c->every < 1) {
+            fprintf(stderr, "--check-every needs a positive interval or auto, got '%s'\n", spec);
+            exit(1);
+        }
+    }
+}
+
+
+static inline int laplace_check_due(const laplace_check *c, int iteration) {
+    return iteration >= c->next;
+}
+
+
+// record the global dt measured at iteration and schedule the next check
+static inline void laplace_check_update(laplace_check *c, int iteration, double dt) {
+
+    c->checks++;
+    if (c->every > 0) {
+        c->next = iteration + c->every;
+    } else {
+        int gap = 1;
+        if (c->last_iteration > 0 && dt < c->last_dt && dt > c->tolerance) {
+            double rate = pow(dt / c->last_dt, 1.0 / (iteration - c->last_iteration));
+            double left = log(c->tolerance / dt) / log(rate);
+            gap = (left / 2 < LAPLACE_CHECK_MAX) ? (int)(left / 2) : LAPLACE_CHECK_MAX;
+            if (gap > 2 * c->gap) gap = 2 * c->gap;
+            if (gap < 1) gap = 1;
+        }
+        c->gap = gap;
+        c->next = iteration + gap;
+    }
+    c->last_iteration = iteration;
+    c->last_dt = dt;
+}
+
+
+static inline const char *laplace_check_name(const laplace_check *c, char *buf, size_t size) {
+    if (c->every > 0) snprintf(buf, size, "every %d", c->every);
+    else snprintf(buf, size, "auto");
+    return buf;
+}
+
+#endif
@@ -0,0 +1,298 @@
+/*************************************************
+ * Lossless codec for Laplace grids
+ *
+ * Temperatures are smooth, so a cell is close to what its neighbours
+ * predict and the XOR of the two bit patterns starts with a run of
+ * zero bits. Each cell x is coded as
+ *
+ *   p    = 2 l - ll + u - (2 ul - ull)      (l = left, u = up, ...)
+ *   r    = bits(x) XOR bits(p)
+ *   code = min(leading zeros of r, 63)      6 bits
+ *   r's low 64 - code bits
+ *
+ * a linear extrapolation along the row, corrected by the error the
+ * same extrapolation made on the row above. Cells outside the block
+ * count as 0.0. The predictor only adds and subtracts, so no compiler
+ * can contract it into an FMA and decode differently from encode.
+ *
+ * The grid is cut into blocks of LAPLACE_CODEC_BLOCK_ROWS rows, coded
+ * independently and, built with -fopenmp, in parallel. A stream is
+ *
+ *   int64 rows, columns, block_rows, blocks
+ *   int64 bytes of each block
+ *   the blocks, then 8 zero bytes
+ *
+ * Grids are passed as the first interior cell and a row stride in
+ * doubles, e.g. &T[1][1] and COLUMNS+2 for a grid with ghost cells.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_CODEC_H
+#define LAPLACE_CODEC_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#define LAPLACE_CODEC_BLOCK_ROWS 32
+
+typedef struct {
+    unsigned char *p;
+    uint64_t acc;           // pending bits, lowest first
+    int n;                  // how many
+} laplace_bit_writer;
+
+typedef struct {
+    const unsigned char *p;
+    uint64_t acc;
+    int n;
+} laplace_bit_reader;
+
+
+static inline uint64_t laplace_codec_mask(int n) {
+    return (n == 64) ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1;
+}
+
+// append the low n bits of v (1 <= n <= 64, higher bits clear)
+static inline void laplace_bits_put(laplace_bit_writer *w, uint64_t v, int n) {
+    w->acc |= v << w->n;
+    if (w->n + n >= 64) {
+        int used = 64 - w->n;
+        memcpy(w->p, &w->acc, 8);
+        w->p += 8;
+        w->acc = (used < 64) ? v >> used : 0;
+        w->n += n - 64;
+    } else {
+        w->n += n;
+    }
+}
+
+// write out the last partial word; returns the end of the stream
+static inline unsigned char *laplace_bits_flush(laplace_bit_writer *w) {
+    memcpy(w->p, &w->acc, 8);
+    return w->p + (w->n + 7) / 8;
+}
+
+// next n bits (1 <= n <= 64); may read up to 8 bytes past the block
+static inline uint64_t laplace_bits_get(laplace_bit_reader *r, int n) {
+    uint64_t v;
+    if (r->n >= n) {
+        v = r->acc & laplace_codec_mask(n);
+        r->acc = (n < 64) ? r->acc >> n : 0;
+        r->n -= n;
+    } else {
+        uint64_t next;
+        int used = n - r->n;
+        memcpy(&next, r->p, 8);
+        r->p += 8;
+        v = (r->acc | (r->n < 64 ? next << r->n : 0)) & laplace_codec_mask(n);
+        r->acc = (used < 64) ? next >> used : 0;
+        r->n = 64 - used;
+    }
+    return v;
+}
+
+
+static inline double laplace_codec_predict(double l, double ll, double u, double ul, double ull) {
+    return (l + l - ll) + (u - (ul + ul - ull));
+}
+
+static inline uint64_t laplace_codec_bits(double x) {
+    uint64_t b;
+    memcpy(&b, &x, 8);
+    return b;
+}
+
+static inline double laplace_codec_double(uint64_t b) {
+    double x;
+    memcpy(&x, &b, 8);
+    return x;
+}
+
+
+static inline size_t laplace_codec_block_bound(int64_t columns) {
+    return (size_t)LAPLACE_CODEC_BLOCK_ROWS * (size_t)columns * 70 / 8 + 16;
+}
+
+// largest stream for a rows x columns grid
+static inline size_t laplace_codec_bound(int64_t rows, int64_t columns) {
+    int64_t blocks = (rows + LAPLACE_CODEC_BLOCK_ROWS - 1) / LAPLACE_CODEC_BLOCK_ROWS;
+    return (size_t)(4 + blocks) * 8 + (size_t)blocks * laplace_codec_block_bound(columns) + 8;
+}
+
+
+static inline unsigned char *laplace_codec_encode_block(const double *grid, int64_t stride, int64_t rows,
+                                                        int64_t columns, unsigned char *out) {
+    laplace_bit_writer w = {out, 0, 0};
+    const double *prev = NULL;
+    int64_t i, j;
+
+    for (i = 0; i < rows; i++) {
+        const double *row = grid + i * stride;
+        double l = 0.0, ll = 0.0, ul = 0.0, ull = 0.0;
+        for (j = 0; j < columns; j++) {
+            double u = prev ? prev[j] : 0.0;
+            uint64_t r = laplace_codec_bits(row[j]) ^
+                         laplace_codec_bits(laplace_codec_predict(l, ll, u, ul, ull));
+            int code = r ? __builtin_clzll(r) : 64;
+            if (code > 63) code = 63;
+            if (code >= 6) {
+                laplace_bits_put(&w, (uint64_t)code | (r << 6), 70 - code);
+            } else {
+                laplace_bits_put(&w, (uint64_t)code, 6);
+                laplace_bits_put(&w, r, 64 - code);
+            }
+            ll = l;  l = row[j];
+            ull = ul; ul = u;
+        }
+        prev = row;
+    }
+    return laplace_bits_flush(&w);
+}
+
+
+static inline void laplace_codec_decode_block(const unsigned char *in, double *grid, int64_t stride,
+                                              int64_t rows, int64_t columns) {
+    laplace_bit_reader r = {in, 0, 0};
+    const double *prev = NULL;
+    int64_t i, j;
+
+    for (i = 0; i < rows; i++) {
+        double *row = grid + i * stride;
+        double l = 0.0, ll = 0.0, ul = 0.0, ull = 0.0;
+        for (j = 0; j < columns; j++) {
+            double u = prev ? prev[j] : 0.0;
+            int code = (int)laplace_bits_get(&r, 6);
+            uint64_t bits = laplace_bits_get(&r, 64 - code);
+            row[j] = laplace_codec_double(bits ^
+                         laplace_codec_bits(laplace_codec_predict(l, ll, u, ul, ull)));
+            ll = l;  l = row[j];
+            ull = ul; ul = u;
+        }
+        prev = row;
+    }
+}
+
+
+// code rows x columns cells into out (laplace_codec_bound bytes);
+// returns the stream length. parallel = 0 keeps to the calling thread
+static inline size_t laplace_codec_encode(const double *grid, int64_t stride, int64_t rows,
+                                          int64_t columns, unsigned char *out, int parallel) {
+    int64_t blocks = (rows + LAPLACE_CODEC_BLOCK_ROWS - 1) / LAPLACE_CODEC_BLOCK_ROWS;
+    int64_t *header = (int64_t *)out;
+    int64_t *sizes = header + 4;
+    unsigned char *data = out + (4 + blocks) * 8;
+    size_t block_bound = laplace_codec_block_bound(columns);
+    size_t offset = 0;
+    int64_t b;
+
+    header[0] = rows;
+    header[1] = columns;
+    header[2] = LAPLACE_CODEC_BLOCK_ROWS;
+    header[3] = blocks;
+
+    // each block into its own slot, then pack the slots together
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) if(parallel)
+#else
+    (void)parallel;
+#endif
+    for (b = 0; b < blocks; b++) {
+        int64_t row0 = b * LAPLACE_CODEC_BLOCK_ROWS;
+        int64_t n = (rows - row0 < LAPLACE_CODEC_BLOCK_ROWS) ? rows - row0 : LAPLACE_CODEC_BLOCK_ROWS;
+        unsigned char *slot = data + b * block_bound;
+        sizes[b] = laplace_codec_encode_block(grid + row0 * stride, stride, n, columns, slot) - slot;
+    }
+    for (b = 0; b < blocks; b++) {
+        memmove(data + offset, data + b * block_bound, sizes[b]);
+        offset += sizes[b];
+    }
+    memset(data + offset, 0, 8);
+    return (data - out) + offset + 8;
+}
+
+
+// inverse of laplace_codec_encode; -1 if the stream is not a rows x
+// columns grid or is shorter than its index says
+static inline int laplace_codec_decode(const unsigned char *in, size_t bytes, double *grid, int64_t stride,
+                                       int64_t rows, int64_t columns, int parallel) {
+    int64_t header[4], blocks, b;
+    size_t *offset, total;
+
+    if (bytes < sizeof(header)) return -1;
+    memcpy(header, in, sizeof(header));     // the stream need not be aligned
+    if (header[0] != rows || header[1] != columns || header[2] != LAPLACE_CODEC_BLOCK_ROWS) return -1;
+    blocks = header[3];
+    if (blocks != (rows + LAPLACE_CODEC_BLOCK_ROWS - 1) / LAPLACE_CODEC_BLOCK_ROWS) return -1;
+    if (bytes < (size_t)(4 + blocks) * 8) return -1;
+
+    offset = malloc((blocks + 1) * sizeof(size_t));
+    total = (4 + blocks) * 8;
+    for (b = 0; b < blocks; b++) {
+        int64_t size;
+        memcpy(&size, in + (4 + b) * 8, 8);
+        offset[b] = total;
+        total += size;
+    }
+    if (total + 8 > bytes) {
+        free(offset);
+        return -1;
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) if(parallel)
+#else
+    (void)parallel;
+#endif
+    for (b = 0; b < blocks; b++) {
+        int64_t row0 = b * LAPLACE_CODEC_BLOCK_ROWS;
+        int64_t n = (rows - row0 < LAPLACE_CODEC_BLOCK_ROWS) ? rows - row0 : LAPLACE_CODEC_BLOCK_ROWS;
+        laplace_codec_decode_block(in + offset[b], grid + row0 * stride, stride, n, columns);
+    }
+    free(offset);
+    return 0;
+}
+
+
+static inline double laplace_codec_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// code a solver's grid, decode it back, check every bit and print the
+// ratio and both speeds in GB/s of raw cells
+static inline void laplace_codec_report(const double *grid, int64_t stride, int64_t rows, int64_t columns) {
+
+    double raw = (double)rows * columns * sizeof(double);
+    unsigned char *stream = malloc(laplace_codec_bound(rows, columns));
+    double *copy = malloc((size_t)rows * (size_t)columns * sizeof(double));
+    double t0, t1, t2;
+    size_t bytes;
+    int64_t i, mismatches = 0;
+
+    if (!stream || !copy) {
+        fprintf(stderr, "Codec report: out of memory\n");
+        exit(1);
+    }
+    t0 = laplace_codec_clock();
+    bytes = laplace_codec_encode(grid, stride, rows, columns, stream, 1);
+    t1 = laplace_codec_clock();
+    laplace_codec_decode(stream, bytes, copy, columns, rows, columns, 1);
+    t2 = laplace_codec_clock();
+
+    for (i = 0; i < rows; i++) {
+        if (memcmp(copy + i * columns, grid + i * stride, columns * sizeof(double)) != 0) mismatches++;
+    }
+    printf("Codec: %.1f MB -> %.1f MB, ratio %.2f, encode %.2f GB/s, decode %.2f GB/s, %s\n",
+           raw / 1e6, bytes / 1e6, raw / bytes, raw / (t1 - t0) / 1e9, raw / (t2 - t1) / 1e9,
+           mismatches ? "MISMATCH" : "lossless");
+    free(stream);
+    free(copy);
+}
+
+#endif
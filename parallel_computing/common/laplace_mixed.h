@@ -0,0 +1,199 @@
+/*************************************************
+ * Mixed-precision Jacobi for the Laplace plate
+ *
+ * The plate T is kept as T = u + e:
+ *
+ *   u  double, the last refined temperatures (the caller's grid)
+ *   e  float, the correction built up since then
+ *   r  float, the Jacobi residual of u, avg(neighbours of u) - u,
+ *      computed in double at each refinement
+ *
+ * A Jacobi sweep on T is then a sweep on the correction alone,
+ *
+ *   e_new = avg(neighbours of e) + r
+ *
+ * which only streams 4-byte cells. Every refinement folds the
+ * correction into u in double (u += e, e = 0) and recomputes r from
+ * the new u, so rounding in e never builds up for more than one
+ * refinement interval. The float sweeps follow the same iterates as the
+ * double Jacobi solver, and max |e_new - e| is its dt, so both stop
+ * on the same iteration and agree to float rounding of the correction.
+ *
+ * e has a zero frame (the boundary lives in u). With a row
+ * decomposition the caller exchanges e ghost rows before each sweep,
+ * and refines in two steps: laplace_mixed_fold, exchange u ghost rows,
+ * laplace_mixed_residual.
+ *
+ * Build with -fopenmp (or -fopenmp-simd -DLAPLACE_OMP_SIMD for MPI-only
+ * codes, since -fopenmp-simd defines no macro of its own): the row loops
+ * rely on omp simd to vectorize their max reductions. Without either the
+ * pragmas are left out and the loops are plain serial code.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_MIXED_H
+#define LAPLACE_MIXED_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+// -fopenmp implies omp simd; -fopenmp-simd needs -DLAPLACE_OMP_SIMD
+#if defined(_OPENMP) && !defined(LAPLACE_OMP_SIMD)
+#define LAPLACE_OMP_SIMD 1
+#endif
+
+typedef struct {
+    int64_t rows, columns;   // interior cells (local rows with MPI)
+    double *u;               // caller's (rows+2) x (columns+2) grid
+    float  *e, *e_new;       // correction, swapped every sweep
+    float  *r;               // residual of u
+} laplace_mixed;
+
+
+static inline float *laplace_mixed_alloc(int64_t rows, int64_t columns) {
+    float *grid = calloc((size_t)(rows + 2) * (size_t)(columns + 2), sizeof(float));
+    if (!grid) {
+        fprintf(stderr, "Mixed precision: cannot allocate a %lld x %lld float grid\n",
+                (long long)rows + 2, (long long)columns + 2);
+        exit(1);
+    }
+    return grid;
+}
+
+
+static inline void laplace_mixed_init(laplace_mixed *m, int64_t rows, int64_t columns, void *plate) {
+    m->rows = rows;
+    m->columns = columns;
+    m->u = (double *)plate;
+    m->e = laplace_mixed_alloc(rows, columns);
+    m->e_new = laplace_mixed_alloc(rows, columns);
+    m->r = laplace_mixed_alloc(rows, columns);
+}
+
+
+static inline void laplace_mixed_free(laplace_mixed *m) {
+    free(m->e);
+    free(m->e_new);
+    free(m->r);
+}
+
+
+// fold the pending correction into u without starting a new interval
+static inline void laplace_mixed_fold(laplace_mixed *m) {
+
+    const int64_t rows = m->rows, columns = m->columns;
+    double (*u)[columns+2] = (double (*)[columns+2])m->u;
+    float  (*e)[columns+2] = (float (*)[columns+2])m->e;
+    int64_t i, j;
+
+#ifdef _OPENMP
+    #pragma omp parallel for private(i,j) schedule(static)
+#endif
+    for (i = 1; i <= rows; i++) {
+        for (j = 1; j <= columns; j++) {
+            u[i][j] += (double)e[i][j];
+            e[i][j] = 0.0f;
+        }
+    }
+}
+
+
+// one row of the float sweep; returns max |out - mid|. gcc will not turn
+// the max reduction into vector code by itself (NaN ordering), so the
+// row loops ask for it with omp simd.
+static inline float laplace_mixed_sweep_row(float *restrict out, const float *restrict up,
+                                            const float *restrict mid, const float *restrict down,
+                                            const float *restrict r, int64_t n) {
+    float dt = 0.0f;
+    int64_t j;
+#ifdef LAPLACE_OMP_SIMD
+    #pragma omp simd reduction(max:dt)
+#endif
+    for (j = 0; j < n; j++) {
+        float next = 0.25f * (down[j] + up[j] + mid[j+1] + mid[j-1]) + r[j];
+        float d = fabsf(next - mid[j]);
+        out[j] = next;
+        dt = (d > dt) ? d : dt;
+    }
+    return dt;
+}
+
+
+// one row of the double residual; returns max |r|
+static inline double laplace_mixed_residual_row(float *restrict r, const double *restrict up,
+                                                const double *restrict mid, const double *restrict down,
+                                                int64_t n) {
+    double dt = 0.0;
+    int64_t j;
+#ifdef LAPLACE_OMP_SIMD
+    #pragma omp simd reduction(max:dt)
+#endif
+    for (j = 0; j < n; j++) {
+        double res = 0.25 * (down[j] + up[j] + mid[j+1] + mid[j-1]) - mid[j];
+        double d = fabs(res);
+        r[j] = (float)res;
+        dt = (d > dt) ? d : dt;
+    }
+    return dt;
+}
+
+
+// r = avg(neighbours of u) - u in double; returns max |r|, the
+// double-precision dt of u
+static inline double laplace_mixed_residual(laplace_mixed *m) {
+
+    const int64_t rows = m->rows, stride = m->columns + 2;
+    double dt = 0.0;
+    int64_t i;
+
+#ifdef _OPENMP
+    #pragma omp parallel for private(i) reduction(max:dt) schedule(static)
+#endif
+    for (i = 1; i <= rows; i++) {
+        double row = laplace_mixed_residual_row(m->r + i*stride + 1, m->u + (i-1)*stride + 1,
+                                                m->u + i*stride + 1, m->u + (i+1)*stride + 1,
+                                                m->columns);
+        dt = (row > dt) ? row : dt;
+    }
+    return dt;
+}
+
+
+// fold the correction into u and start a new interval from it
+static inline double laplace_mixed_refine(laplace_mixed *m) {
+    laplace_mixed_fold(m);
+    return laplace_mixed_residual(m);
+}
+
+
+// one float Jacobi sweep on the correction; returns max |e_new - e|
+static inline double laplace_mixed_sweep(laplace_mixed *m) {
+
+    const int64_t rows = m->rows, stride = m->columns + 2;
+    const float *e = m->e;
+    float dt = 0.0f;
+    float *swap;
+    int64_t i;
+
+#ifdef _OPENMP
+    #pragma omp parallel for private(i) reduction(max:dt) schedule(static)
+#endif
+    for (i = 1; i <= rows; i++) {
+        float row = laplace_mixed_sweep_row(m->e_new + i*stride + 1, e + (i-1)*stride + 1,
+                                            e + i*stride + 1, e + (i+1)*stride + 1,
+                                            m->r + i*stride + 1, m->columns);
+        dt = (row > dt) ? row : dt;
+    }
+
+    swap = m->e;
+    m->e = m->e_new;
+    m->e_new = swap;
+    return (double)dt;
+}
+
+#endif
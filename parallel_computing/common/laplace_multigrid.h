@@ -0,0 +1,344 @@
+/*************************************************
+ * Geometric multigrid engine for the Laplace plate
+ *
+ * Solves the same problem as the Jacobi sweep: interior of a
+ * (rows+2) x (columns+2) grid, boundary frame fixed by initialize().
+ * Each level keeps (n-1)/2 of its n points per direction (coarse point
+ * I sits on fine point 2I) until one side is down to LAPLACE_MG_COARSEST
+ * points; coarse levels solve for the correction with zero boundaries.
+ *
+ * Only n = 2^k - 1 halves exactly. Otherwise the far boundary is not a
+ * fine point 2I, so every level keeps the real position of its rows
+ * and columns and uses the non-uniform 5-point Laplacian; the last
+ * coarse interval is then between one and two spacings long. Dropping
+ * to n/2 points instead shrinks that interval on every even level and
+ * the cycle diverges for plates like 1000 x 1000.
+ *
+ *   smoother     red-black Gauss-Seidel
+ *   restriction  full weighting of the residual
+ *   prolongation bilinear interpolation of the correction
+ *   cycles       V (one coarse visit) or F (an F then a V on the coarse level)
+ *
+ * laplace_mg_cycle() returns the largest change one more Jacobi sweep
+ * would make, max |avg(neighbours) - T|, which is exactly the dt the
+ * Jacobi solvers compare against MAX_TEMP_ERROR, so all engines stop
+ * on the same criterion.
+ *
+ * Loops carry OpenMP pragmas behind #ifdef _OPENMP: compiled with
+ * -fopenmp (or -mp) the engine runs in parallel, otherwise it is plain
+ * serial code and builds without unknown-pragma warnings.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_MULTIGRID_H
+#define LAPLACE_MULTIGRID_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#define LAPLACE_MG_MAX_LEVELS 32
+#define LAPLACE_MG_COARSEST    3   // stop coarsening when a side is this short
+
+typedef struct {
+    int64_t rows, columns;   // interior points on this level
+    int     uniform;         // unit spacing everywhere (the plate itself)
+    double *y, *x;           // row / column positions in plate spacings
+    double *an, *as;         // per-row weight of the row below / above
+    double *ae, *aw;         // per-column weight of the column right / left
+    double *u;               // plate (level 0) or correction
+    double *f;               // right-hand side
+    double *r;               // residual scratch
+} laplace_mg_level;
+
+typedef struct {
+    int levels;
+    laplace_mg_level level[LAPLACE_MG_MAX_LEVELS];
+    int pre_smooth;          // red-black sweeps before restricting
+    int post_smooth;         // red-black sweeps after correcting
+    int coarse_sweeps;       // red-black sweeps on the coarsest level
+    double residual_max;     // max |sum(neighbours) - 4T| after the last cycle
+    double residual_rms;     // root mean square of the same
+} laplace_mg;
+
+
+static inline double *laplace_mg_alloc(int64_t rows, int64_t columns) {
+    double *grid = calloc((size_t)(rows + 2) * (size_t)(columns + 2), sizeof(double));
+    if (!grid) {
+        fprintf(stderr, "Multigrid: cannot allocate a %lld x %lld level\n",
+                (long long)rows + 2, (long long)columns + 2);
+        exit(1);
+    }
+    return grid;
+}
+
+
+// 1-D second difference weights at each interior node for positions pos[0..n+1]:
+// d2u/dz2 ~ minus[k] (u[k-1] - u[k]) + plus[k] (u[k+1] - u[k])
+static inline void laplace_mg_weights(const double *pos, int64_t n, double *plus, double *minus) {
+
+    int64_t k;
+
+    for (k = 1; k <= n; k++) {
+        double hm = pos[k] - pos[k-1], hp = pos[k+1] - pos[k];
+        plus[k]  = 2.0 / ((hm + hp) * hp);
+        minus[k] = 2.0 / ((hm + hp) * hm);
+    }
+}
+
+
+// build the level hierarchy on top of the caller's plate (not copied)
+static inline void laplace_mg_init(laplace_mg *mg, int64_t rows, int64_t columns, void *plate) {
+
+    int64_t r = rows, c = columns;
+    int64_t k;
+    int l;
+
+    memset(mg, 0, sizeof(*mg));
+    mg->pre_smooth = 2;
+    mg->post_smooth = 2;
+    mg->coarse_sweeps = 50;
+
+    for (l = 0; l < LAPLACE_MG_MAX_LEVELS; l++) {
+        laplace_mg_level *L = &mg->level[l];
+        L->rows = r;
+        L->columns = c;
+        L->u = (l == 0) ? (double *)plate : laplace_mg_alloc(r, c);
+        L->f = laplace_mg_alloc(r, c);
+        L->r = laplace_mg_alloc(r, c);
+        L->y  = calloc(r + 2, sizeof(double));
+        L->an = calloc(r + 2, sizeof(double));
+        L->as = calloc(r + 2, sizeof(double));
+        L->x  = calloc(c + 2, sizeof(double));
+        L->ae = calloc(c + 2, sizeof(double));
+        L->aw = calloc(c + 2, sizeof(double));
+        mg->levels = l + 1;
+
+        // coarse node I is fine node 2I, the far boundary stays where it is
+        if (l == 0) {
+            for (k = 0; k <= r+1; k++) L->y[k] = (double)k;
+            for (k = 0; k <= c+1; k++) L->x[k] = (double)k;
+        } else {
+            laplace_mg_level *F = &mg->level[l-1];
+            for (k = 0; k <= r; k++) L->y[k] = F->y[2*k];
+            for (k = 0; k <= c; k++) L->x[k] = F->x[2*k];
+            L->y[r+1] = F->y[F->rows+1];
+            L->x[c+1] = F->x[F->columns+1];
+        }
+        laplace_mg_weights(L->y, r, L->an, L->as);
+        laplace_mg_weights(L->x, c, L->ae, L->aw);
+        L->uniform = (l == 0);
+
+        if (r <= LAPLACE_MG_COARSEST || c <= LAPLACE_MG_COARSEST) break;
+        r = (r - 1) / 2;
+        c = (c - 1) / 2;
+    }
+}
+
+
+static inline void laplace_mg_free(laplace_mg *mg) {
+
+    int l;
+
+    for (l = 0; l < mg->levels; l++) {
+        laplace_mg_level *L = &mg->level[l];
+        if (l > 0) free(L->u);
+        free(L->f);
+        free(L->r);
+        free(L->y);
+        free(L->an);
+        free(L->as);
+        free(L->x);
+        free(L->ae);
+        free(L->aw);
+    }
+    mg->levels = 0;
+}
+
+
+// red-black Gauss-Seidel on A u = f, where -A is the 5-point Laplacian
+// (4u - sum(neighbours) on the plate itself)
+static inline void laplace_mg_smooth(laplace_mg_level *L, int sweeps) {
+
+    const int64_t rows = L->rows, columns = L->columns;
+    double (*u)[columns+2] = (double (*)[columns+2])L->u;
+    double (*f)[columns+2] = (double (*)[columns+2])L->f;
+    const double *an = L->an, *as = L->as, *ae = L->ae, *aw = L->aw;
+    int64_t i, j;
+    int sweep, colour;
+
+    for (sweep = 0; sweep < sweeps; sweep++) {
+        for (colour = 0; colour < 2; colour++) {
+            if (L->uniform) {
+#ifdef _OPENMP
+                #pragma omp parallel for private(i,j) schedule(static)
+#endif
+                for (i = 1; i <= rows; i++) {
+                    for (j = 1 + (i + colour) % 2; j <= columns; j += 2) {
+                        u[i][j] = 0.25 * (u[i+1][j] + u[i-1][j] + u[i][j+1] + u[i][j-1] + f[i][j]);
+                    }
+                }
+            } else {
+#ifdef _OPENMP
+                #pragma omp parallel for private(i,j) schedule(static)
+#endif
+                for (i = 1; i <= rows; i++) {
+                    for (j = 1 + (i + colour) % 2; j <= columns; j += 2) {
+                        u[i][j] = (an[i] * u[i+1][j] + as[i] * u[i-1][j] +
+                                   ae[j] * u[i][j+1] + aw[j] * u[i][j-1] + f[i][j]) /
+                                  (an[i] + as[i] + ae[j] + aw[j]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+// r = f - A u on the interior; the frame of r stays zero
+static inline void laplace_mg_residual(laplace_mg_level *L) {
+
+    const int64_t rows = L->rows, columns = L->columns;
+    double (*u)[columns+2] = (double (*)[columns+2])L->u;
+    double (*f)[columns+2] = (double (*)[columns+2])L->f;
+    double (*r)[columns+2] = (double (*)[columns+2])L->r;
+    const double *an = L->an, *as = L->as, *ae = L->ae, *aw = L->aw;
+    int64_t i, j;
+
+#ifdef _OPENMP
+    #pragma omp parallel for private(i,j) schedule(static)
+#endif
+    for (i = 1; i <= rows; i++) {
+        for (j = 1; j <= columns; j++) {
+            r[i][j] = f[i][j] - ((an[i] + as[i] + ae[j] + aw[j]) * u[i][j] -
+                                 an[i] * u[i+1][j] - as[i] * u[i-1][j] -
+                                 ae[j] * u[i][j+1] - aw[j] * u[i][j-1]);
+        }
+    }
+}
+
+
+// weight of coarse node K's linear hat function at position z
+static inline double laplace_mg_hat(const double *pos, int64_t K, double z) {
+    if (z <= pos[K]) return (z - pos[K-1]) / (pos[K] - pos[K-1]);
+    return (pos[K+1] - z) / (pos[K+1] - pos[K]);
+}
+
+
+// weighted average of the fine residual under each coarse hat (the
+// transpose of laplace_mg_prolong, full weighting on a uniform level)
+// into the coarse right-hand side, and a zero starting correction
+static inline void laplace_mg_restrict(laplace_mg_level *fine, laplace_mg_level *coarse) {
+
+    const int64_t frows = fine->rows, fcolumns = fine->columns;
+    const int64_t rows = coarse->rows, columns = coarse->columns;
+    double (*r)[fcolumns+2] = (double (*)[fcolumns+2])fine->r;
+    double (*f)[columns+2] = (double (*)[columns+2])coarse->f;
+    double (*u)[columns+2] = (double (*)[columns+2])coarse->u;
+    int64_t I, J, i, j;
+
+#ifdef _OPENMP
+    #pragma omp parallel for private(I,J,i,j) schedule(static)
+#endif
+    for (I = 1; I <= rows; I++) {
+        const int64_t ihi = (I == rows) ? frows : 2*I+1;
+        for (J = 1; J <= columns; J++) {
+            const int64_t jhi = (J == columns) ? fcolumns : 2*J+1;
+            double sum = 0.0, weight = 0.0;
+            for (i = 2*I-1; i <= ihi; i++) {
+                double wy = laplace_mg_hat(coarse->y, I, fine->y[i]);
+                for (j = 2*J-1; j <= jhi; j++) {
+                    double w = wy * laplace_mg_hat(coarse->x, J, fine->x[j]);
+                    sum += w * r[i][j];
+                    weight += w;
+                }
+            }
+            f[I][J] = sum / weight;
+            u[I][J] = 0.0;
+        }
+    }
+}
+
+
+// add the bilinearly interpolated coarse correction to the fine level;
+// fine node i lies between coarse nodes I and I+1 (on I when i = 2I), the
+// last fine nodes between the last coarse node and the boundary
+static inline void laplace_mg_prolong(laplace_mg_level *coarse, laplace_mg_level *fine) {
+
+    const int64_t ccolumns = coarse->columns;
+    const int64_t rows = fine->rows, columns = fine->columns;
+    double (*e)[ccolumns+2] = (double (*)[ccolumns+2])coarse->u;
+    double (*u)[columns+2] = (double (*)[columns+2])fine->u;
+    int64_t i, j, I, J;
+
+#ifdef _OPENMP
+    #pragma omp parallel for private(i,j,I,J) schedule(static)
+#endif
+    for (i = 1; i <= rows; i++) {
+        double wy;
+        I = (i / 2 < coarse->rows) ? i / 2 : coarse->rows;
+        wy = (fine->y[i] - coarse->y[I]) / (coarse->y[I+1] - coarse->y[I]);
+        for (j = 1; j <= columns; j++) {
+            double wx;
+            J = (j / 2 < ccolumns) ? j / 2 : ccolumns;
+            wx = (fine->x[j] - coarse->x[J]) / (coarse->x[J+1] - coarse->x[J]);
+            u[i][j] += (1.0 - wy) * ((1.0 - wx) * e[I][J]   + wx * e[I][J+1]) +
+                              wy  * ((1.0 - wx) * e[I+1][J] + wx * e[I+1][J+1]);
+        }
+    }
+}
+
+
+static inline void laplace_mg_visit(laplace_mg *mg, int l, int fcycle) {
+
+    laplace_mg_level *L = &mg->level[l];
+
+    if (l == mg->levels - 1) {
+        laplace_mg_smooth(L, mg->coarse_sweeps);
+        return;
+    }
+
+    laplace_mg_smooth(L, mg->pre_smooth);
+    laplace_mg_residual(L);
+    laplace_mg_restrict(L, &mg->level[l+1]);
+
+    laplace_mg_visit(mg, l+1, fcycle);
+    if (fcycle) laplace_mg_visit(mg, l+1, 0);   // F-cycle: follow with a V on the coarse level
+
+    laplace_mg_prolong(&mg->level[l+1], L);
+    laplace_mg_smooth(L, mg->post_smooth);
+}
+
+
+// one V- or F-cycle on the plate; returns the Jacobi-equivalent dt
+static inline double laplace_mg_cycle(laplace_mg *mg, int fcycle) {
+
+    laplace_mg_level *L = &mg->level[0];
+    const int64_t rows = L->rows, columns = L->columns;
+    double (*u)[columns+2] = (double (*)[columns+2])L->u;
+    double res_max = 0.0, res_sum = 0.0;
+    int64_t i, j;
+
+    laplace_mg_visit(mg, 0, fcycle);
+
+#ifdef _OPENMP
+    #pragma omp parallel for private(i,j) reduction(max:res_max) reduction(+:res_sum) schedule(static)
+#endif
+    for (i = 1; i <= rows; i++) {
+        for (j = 1; j <= columns; j++) {
+            double res = u[i+1][j] + u[i-1][j] + u[i][j+1] + u[i][j-1] - 4.0 * u[i][j];
+            res_max = fmax(fabs(res), res_max);
+            res_sum += res * res;
+        }
+    }
+    mg->residual_max = res_max;
+    mg->residual_rms = sqrt(res_sum / ((double)rows * (double)columns));
+
+    return 0.25 * res_max;
+}
+
+#endif
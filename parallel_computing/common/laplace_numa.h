@@ -0,0 +1,363 @@
+/*************************************************
+ * Grid placement, huge pages and thread pinning
+ *
+ *   ./laplace_omp.out --placement=first-touch --huge-pages=thp --pin=spread
+ *
+ * Linux puts a page on the NUMA node of the thread that first writes
+ * it. initialize() runs on thread 0, so on a dual-socket node both
+ * grids end up behind one memory controller and the parallel sweeps
+ * share half the machine's bandwidth. Three independent options:
+ *
+ *   --placement=first-touch   map the grids untouched, then zero them
+ *                             in parallel with the sweep's static row
+ *                             schedule, so each thread's rows live on
+ *                             its own node (default: serial, as before)
+ *   --huge-pages=thp          2 MB aligned mapping with
+ *                             madvise(MADV_HUGEPAGE)
+ *   --huge-pages=explicit     MAP_HUGETLB pages from vm.nr_hugepages,
+ *                             falling back to thp if none are reserved
+ *   --pin=close|spread        bind OpenMP thread t to one allowed CPU:
+ *                             close fills a node before the next,
+ *                             spread deals threads across nodes
+ *
+ * The sweep loops must keep schedule(static) over rows 1..ROWS for the
+ * placement to match. Pinning with OMP_PROC_BIND/OMP_PLACES works as
+ * well; --pin is for runtimes or launchers where those are not set.
+ * With any option the program prints the thread -> CPU/node map and,
+ * per grid, the nodes its pages landed on (move_pages on up to
+ * LAPLACE_NUMA_SAMPLES pages) and how much of it is on huge pages.
+ *
+ * Mappings start on a page (or 2 MB) boundary, so T[i][j] and
+ * T_last[i][j] would share every low address bit: on huge pages they
+ * then fight over the same L2 sets, 30% slower on the test VM.
+ * Each grid starts LAPLACE_NUMA_STAGGER bytes further into its
+ * mapping than the one before.
+ *
+ * No libnuma needed: nodes come from /sys/devices/system/node.
+ * Define _GNU_SOURCE before the first #include (sched_getcpu, CPU_SET).
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_NUMA_H
+#define LAPLACE_NUMA_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "laplace_args.h"
+
+#define LAPLACE_HUGE_PAGE     (2UL << 20)
+#define LAPLACE_NUMA_NODES    64       // nodes tallied in the placement report
+#define LAPLACE_NUMA_SAMPLES  4096     // pages per grid asked about
+#define LAPLACE_NUMA_STAGGER  (4096 + 64)   // start of grid k is k of these into its mapping
+
+enum { LAPLACE_HUGE_OFF, LAPLACE_HUGE_THP, LAPLACE_HUGE_EXPLICIT };
+enum { LAPLACE_PIN_OFF, LAPLACE_PIN_CLOSE, LAPLACE_PIN_SPREAD };
+
+typedef struct {
+    int enabled;                // any option given: map with mmap, report
+    int first_touch;
+    int huge;                   // requested LAPLACE_HUGE_*
+    int pin;
+    int explicit_failed;        // MAP_HUGETLB refused, thp used instead
+    int grids;                  // mapped so far, for the stagger
+    int nodes;                  // 1 without NUMA sysfs
+    int cpus;                   // entries of cpu_node
+    int *cpu_node;              // node of each CPU
+} laplace_numa;
+
+
+static inline int laplace_numa_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+static inline int laplace_numa_thread(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+
+// CPU -> node from the nodeN/cpulist files ("0-15,32-47")
+static inline void laplace_numa_topology(laplace_numa *n) {
+    char path[128], list[4096];
+    int node, first, last, cpu;
+
+    n->cpus = (int)sysconf(_SC_NPROCESSORS_CONF);
+    if (n->cpus < 1) n->cpus = 1;
+    n->cpu_node = calloc(n->cpus, sizeof(int));
+    n->nodes = 1;
+    for (node = 0; node < LAPLACE_NUMA_NODES; node++) {
+        FILE *f;
+        char *p;
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        if (!(f = fopen(path, "r"))) continue;
+        if (!fgets(list, sizeof(list), f)) list[0] = '\0';
+        fclose(f);
+        if (node + 1 > n->nodes) n->nodes = node + 1;
+        for (p = list; *p && *p != '\n'; ) {
+            first = last = (int)strtol(p, &p, 10);
+            if (*p == '-') last = (int)strtol(p + 1, &p, 10);
+            for (cpu = first; cpu <= last && cpu < n->cpus; cpu++) n->cpu_node[cpu] = node;
+            if (*p == ',') p++;
+            else break;
+        }
+    }
+}
+
+static inline int laplace_numa_node_of(const laplace_numa *n, int cpu) {
+    return (cpu >= 0 && cpu < n->cpus) ? n->cpu_node[cpu] : -1;
+}
+
+
+// --placement / --huge-pages / --pin values; exits on anything else
+static inline int laplace_numa_parse(const char *option, const char *value, const char *const *names,
+                                     int count) {
+    int k;
+    for (k = 0; k < count; k++) {
+        if (strcmp(value, names[k]) == 0) return k;
+    }
+    fprintf(stderr, "Unknown %s '%s' (", option, value);
+    for (k = 0; k < count; k++) fprintf(stderr, "%s%s", names[k], k + 1 < count ? ", " : ")\n");
+    exit(1);
+}
+
+static inline void laplace_numa_init(laplace_numa *n, const char *placement, const char *huge,
+                                     const char *pin) {
+    static const char *placements[] = { "serial", "first-touch" };
+    static const char *hugepages[] = { "off", "thp", "explicit" };
+    static const char *pins[] = { "off", "close", "spread" };
+
+    memset(n, 0, sizeof(*n));
+    if (placement) n->first_touch = laplace_numa_parse("--placement", placement, placements, 2);
+    if (huge) n->huge = laplace_numa_parse("--huge-pages", huge, hugepages, 3);
+    if (pin) n->pin = laplace_numa_parse("--pin", pin, pins, 3);
+    n->enabled = placement || huge || pin;
+    laplace_numa_topology(n);
+}
+
+
+// bind each OpenMP thread to one CPU of the process's mask. Call
+// outside parallel regions, before the grids are touched
+static inline void laplace_numa_pin(laplace_numa *n) {
+    cpu_set_t allowed;
+    int *order, count = 0, cpu, node, k;
+
+    if (n->pin == LAPLACE_PIN_OFF) return;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        perror("sched_getaffinity");
+        return;
+    }
+    order = malloc(CPU_SETSIZE * sizeof(int));
+    if (n->pin == LAPLACE_PIN_CLOSE) {
+        for (node = 0; node < n->nodes; node++) {
+            for (cpu = 0; cpu < CPU_SETSIZE && cpu < n->cpus; cpu++) {
+                if (CPU_ISSET(cpu, &allowed) && n->cpu_node[cpu] == node) order[count++] = cpu;
+            }
+        }
+    } else {
+        // k-th allowed CPU of node 0, of node 1, ..., then the (k+1)-th
+        int *next = calloc(n->nodes, sizeof(int)), placed = 1;
+        while (placed) {
+            placed = 0;
+            for (node = 0; node < n->nodes; node++) {
+                for (cpu = next[node]; cpu < CPU_SETSIZE && cpu < n->cpus; cpu++) {
+                    if (CPU_ISSET(cpu, &allowed) && n->cpu_node[cpu] == node) break;
+                }
+                next[node] = cpu + 1;
+                if (cpu < CPU_SETSIZE && cpu < n->cpus) {
+                    order[count++] = cpu;
+                    placed = 1;
+                }
+            }
+        }
+        free(next);
+    }
+    if (count == 0) {
+        free(order);
+        return;
+    }
+
+    #pragma omp parallel private(k)
+    {
+        cpu_set_t mine;
+        k = laplace_numa_thread();
+        CPU_ZERO(&mine);
+        CPU_SET(order[k % count], &mine);
+        if (sched_setaffinity(0, sizeof(mine), &mine) != 0) perror("sched_setaffinity");
+    }
+    free(order);
+}
+
+// thread -> CPU (node), eight to a line
+static inline void laplace_numa_report_affinity(const laplace_numa *n) {
+    int threads = laplace_numa_threads(), k;
+    int *cpu = malloc(threads * sizeof(int));
+
+    #pragma omp parallel
+    {
+        cpu[laplace_numa_thread()] = sched_getcpu();
+    }
+    printf("Affinity (thread: CPU/node), pin %s, %d nodes:",
+           n->pin == LAPLACE_PIN_CLOSE ? "close" : n->pin == LAPLACE_PIN_SPREAD ? "spread" : "off", n->nodes);
+    for (k = 0; k < threads; k++) {
+        if (k % 8 == 0) printf("\n ");
+        printf(" %3d: %3d/%d", k, cpu[k], laplace_numa_node_of(n, cpu[k]));
+    }
+    printf("\n");
+    free(cpu);
+}
+
+
+// mapping for a grid offset bytes into it, in whole (huge) pages
+static inline size_t laplace_numa_map_bytes(const laplace_numa *n, int64_t rows, int64_t pitch,
+                                            size_t offset) {
+    size_t page = n->huge != LAPLACE_HUGE_OFF ? LAPLACE_HUGE_PAGE : (size_t)sysconf(_SC_PAGESIZE);
+    return (offset + (size_t)(rows + 2) * (size_t)pitch * sizeof(double) + page - 1) & ~(page - 1);
+}
+
+// a 2 MB aligned mapping of bytes: map one huge page more and trim
+static inline void *laplace_numa_map_thp(size_t bytes) {
+    char *base = mmap(NULL, bytes + LAPLACE_HUGE_PAGE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    char *grid;
+    if (base == MAP_FAILED) return NULL;
+    grid = (char *)(((uintptr_t)base + LAPLACE_HUGE_PAGE - 1) & ~(uintptr_t)(LAPLACE_HUGE_PAGE - 1));
+    if (grid > base) munmap(base, grid - base);
+    munmap(grid + bytes, base + LAPLACE_HUGE_PAGE - grid);
+    madvise(grid, bytes, MADV_HUGEPAGE);
+    return grid;
+}
+
+// zero-filled grid of rows pitch doubles apart like laplace_alloc_pitched_grid(),
+// but mapped untouched and, with --placement=first-touch, touched by the
+// threads that sweep it
+static inline void *laplace_numa_alloc_grid(laplace_numa *n, int64_t rows, int64_t pitch) {
+    size_t offset = (size_t)(n->grids++ % 16) * LAPLACE_NUMA_STAGGER;
+    size_t bytes = laplace_numa_map_bytes(n, rows, pitch, offset);
+    size_t row_bytes = (size_t)pitch * sizeof(double);
+    char *grid = NULL;
+    int64_t i;
+
+    if (!n->enabled) return laplace_alloc_pitched_grid(rows, pitch);
+    if (n->huge == LAPLACE_HUGE_EXPLICIT) {
+        grid = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (grid == MAP_FAILED) {
+            if (!n->explicit_failed)
+                fprintf(stderr, "No explicit huge pages reserved (vm.nr_hugepages), using thp\n");
+            n->explicit_failed = 1;
+            grid = NULL;
+        }
+    }
+    if (!grid && n->huge != LAPLACE_HUGE_OFF) {
+        grid = laplace_numa_map_thp(bytes);
+    } else if (!grid) {
+        grid = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (grid == MAP_FAILED) grid = NULL;
+    }
+    if (!grid) {
+        fprintf(stderr, "Cannot allocate a %" PRId64 " x %" PRId64 " grid (%zu bytes)\n",
+                rows + 2, pitch, bytes);
+        exit(1);
+    }
+    grid += offset;
+
+    // the sweep's rows 1..rows, same static schedule; the frame rows go
+    // with their neighbours
+    if (n->first_touch) {
+        #pragma omp parallel for schedule(static)
+        for (i = 1; i <= rows; i++) {
+            memset(grid + i * row_bytes, 0, row_bytes);
+            if (i == 1) memset(grid, 0, row_bytes);
+            if (i == rows) memset(grid + (rows + 1) * row_bytes, 0, row_bytes);
+        }
+    }
+    return grid;
+}
+
+// KB of the mapping holding grid that are on huge pages, from smaps;
+// mapping_kb is its size
+static inline long laplace_numa_huge_kb(const void *grid, long *mapping_kb) {
+    FILE *f = fopen("/proc/self/smaps", "r");
+    char line[512];
+    uintptr_t start, end, at = (uintptr_t)grid;
+    long kb = -1, value;
+    int inside = 0;
+
+    if (!f) return -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR, &start, &end) == 2 && strchr(line, '-') < strchr(line, ' ')) {
+            if (inside) break;
+            inside = (at >= start && at < end);
+            if (inside) {
+                kb = 0;
+                *mapping_kb = (long)((end - start) / 1024);
+            }
+        } else if (inside && sscanf(line, "AnonHugePages: %ld kB", &value) == 1) {
+            kb += value;
+        } else if (inside && sscanf(line, "Private_Hugetlb: %ld kB", &value) == 1) {
+            kb += value;
+        }
+    }
+    fclose(f);
+    return kb;
+}
+
+// nodes holding a sample of the grid's pages, and its huge page share
+static inline void laplace_numa_report_grid(const laplace_numa *n, const char *name, void *grid,
+                                            int64_t rows, int64_t pitch) {
+    size_t bytes = (size_t)(rows + 2) * (size_t)pitch * sizeof(double);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE), pages = (bytes + page - 1) / page, count, k;
+    uintptr_t first = (uintptr_t)grid & ~(uintptr_t)(page - 1);
+    int64_t on_node[LAPLACE_NUMA_NODES] = {0}, placed = 0;
+    void **where;
+    int *status, node;
+    long huge_kb, mapping_kb = 0;
+
+    count = pages < LAPLACE_NUMA_SAMPLES ? pages : LAPLACE_NUMA_SAMPLES;
+    where = malloc(count * sizeof(void *));
+    status = malloc(count * sizeof(int));
+    for (k = 0; k < count; k++) where[k] = (void *)(first + (k * pages / count) * page);
+    printf("Placement: %-16s %s", name, n->first_touch ? "first-touch" : "serial");
+    if (syscall(SYS_move_pages, 0, (unsigned long)count, where, NULL, status, 0) == 0) {
+        for (k = 0; k < count; k++) {
+            if (status[k] >= 0 && status[k] < LAPLACE_NUMA_NODES) {
+                on_node[status[k]]++;
+                placed++;
+            }
+        }
+        for (node = 0; node < n->nodes && node < LAPLACE_NUMA_NODES; node++) {
+            printf(", node %d %.1f%%", node, placed ? 100.0 * on_node[node] / placed : 0.0);
+        }
+    } else {
+        printf(", nodes unknown");
+    }
+    huge_kb = laplace_numa_huge_kb(grid, &mapping_kb);
+    if (huge_kb >= 0 && mapping_kb > 0) printf(", huge pages %.1f%%", 100.0 * huge_kb / mapping_kb);
+    printf("\n");
+    free(where);
+    free(status);
+}
+
+static inline void laplace_numa_close(laplace_numa *n) {
+    free(n->cpu_node);
+}
+
+#endif
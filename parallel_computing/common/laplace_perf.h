@@ -0,0 +1,336 @@
+/*************************************************
+ * Hardware counters and a roofline for the Laplace kernels
+ *
+ *   ./laplace_omp.out --perf [--stream-mb=N]
+ *
+ * At startup laplace_perf_open() opens perf_event_open counters in
+ * every OpenMP thread of the team (an inherited counter only folds a
+ * thread's counts back in when the thread exits, which pool threads
+ * never do), and laplace_perf_read() sums them across threads:
+ *
+ *   cycles, instructions, L1D read misses, LLC misses
+ *
+ * and measures the two roofs of the machine:
+ *
+ *   bandwidth   a STREAM triad a = b + s*c over three arrays of N MB
+ *               each (default four times the LLC, capped at 1/16 of
+ *               RAM), best of LAPLACE_PERF_TRIALS, counted as STREAM
+ *               does: 24 bytes per element, no write-allocate
+ *   compute     independent multiply-add chains on an L1-resident
+ *               array, two flops per element update
+ *
+ * The solver brackets each kernel phase with laplace_perf_begin() and
+ * laplace_perf_end(), and laplace_perf_report() prints per kernel the
+ * time, modelled GB/s and GFLOP/s, arithmetic intensity (the model's
+ * flops over its bytes), the percentage of the roofline min(peak,
+ * AI x bandwidth), IPC and misses per cell. Memory traffic is not
+ * counted directly (that needs uncore counters and system-wide
+ * rights); LLC misses x 64 bytes stands in for it where the LLC
+ * counter opens. A roof% above 100 means the kernel ran out of cache:
+ * a plate whose two grids fit in the LLC never streams from DRAM.
+ *
+ * A counter that cannot be opened (perf_event_paranoid, no PMU in a
+ * VM or container, seccomp) is reported once and shown as "-"; the
+ * timings and the roofline still work without any.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_PERF_H
+#define LAPLACE_PERF_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define LAPLACE_PERF_KERNELS  4     // kernel phases a solver may time
+#define LAPLACE_PERF_TRIALS   5     // STREAM passes, best kept
+#define LAPLACE_PERF_LINE     64    // bytes per LLC miss
+
+enum { LAPLACE_PERF_CYCLES, LAPLACE_PERF_INSTRUCTIONS, LAPLACE_PERF_L1D_MISSES,
+       LAPLACE_PERF_LLC_MISSES, LAPLACE_PERF_EVENTS };
+
+typedef struct {
+    const char *name;
+    double flops_per_cell;          // model: flops and DRAM bytes per cell update
+    double bytes_per_cell;
+    double seconds;
+    double cells;                   // cell updates
+    uint64_t count[LAPLACE_PERF_EVENTS];
+    uint64_t start[LAPLACE_PERF_EVENTS];
+    double start_time;
+} laplace_perf_kernel;
+
+typedef struct {
+    int (*fd)[LAPLACE_PERF_EVENTS]; // per thread, -1 when the counter is unavailable
+    int available[LAPLACE_PERF_EVENTS];
+    double stream_gbs;              // triad bandwidth
+    double peak_gflops;             // multiply-add probe
+    double stream_mb;
+    int threads;
+    int kernels;
+    laplace_perf_kernel kernel[LAPLACE_PERF_KERNELS];
+} laplace_perf;
+
+static const char *laplace_perf_event_names[LAPLACE_PERF_EVENTS] = {
+    "cycles", "instructions", "L1D misses", "LLC misses"
+};
+
+
+static inline double laplace_perf_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static inline int laplace_perf_event(uint32_t type, uint64_t config) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;        // allowed at perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void)type; (void)config;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// counts summed over the threads; any thread may read another's counter
+static inline void laplace_perf_read(const laplace_perf *p, uint64_t *count) {
+    int t, e;
+    for (e = 0; e < LAPLACE_PERF_EVENTS; e++) {
+        count[e] = 0;
+        if (!p->available[e]) continue;
+        for (t = 0; t < p->threads; t++) {
+            uint64_t value;
+            if (read(p->fd[t][e], &value, sizeof(value)) == sizeof(value)) count[e] += value;
+        }
+    }
+}
+
+
+// STREAM triad at stream_mb per array; returns GB/s
+static inline double laplace_perf_stream(double stream_mb) {
+    int64_t n = (int64_t)(stream_mb * 1e6 / sizeof(double)), k;
+    double *a = malloc(n * sizeof(double));
+    double *b = malloc(n * sizeof(double));
+    double *c = malloc(n * sizeof(double));
+    double best = 0.0, s = 3.0;
+    int t;
+
+    if (!a || !b || !c) {
+        fprintf(stderr, "Roofline: cannot allocate 3 x %.0f MB for the STREAM probe\n", stream_mb);
+        exit(1);
+    }
+    // first touch by the threads that will stream them
+    #pragma omp parallel for schedule(static)
+    for (k = 0; k < n; k++) {
+        a[k] = 0.0;
+        b[k] = 1.0;
+        c[k] = 2.0;
+    }
+    for (t = 0; t < LAPLACE_PERF_TRIALS; t++) {
+        double start = laplace_perf_clock(), seconds;
+        #pragma omp parallel for schedule(static)
+        for (k = 0; k < n; k++) a[k] = b[k] + s * c[k];
+        seconds = laplace_perf_clock() - start;
+        if (3.0 * sizeof(double) * n / seconds / 1e9 > best) best = 3.0 * sizeof(double) * n / seconds / 1e9;
+    }
+    if (a[n / 2] != 7.0) fprintf(stderr, "Roofline: STREAM check failed\n");
+    free(a);
+    free(b);
+    free(c);
+    return best;
+}
+
+
+// independent x = x * m + d chains, 2 flops each, in L1; returns GFLOP/s
+static inline double laplace_perf_peak(void) {
+    const int length = 256, rounds = 200000;
+    double best = 0.0;
+    volatile double keep;           // so the chains are not optimised away
+    int t;
+
+    for (t = 0; t < LAPLACE_PERF_TRIALS; t++) {
+        double start = laplace_perf_clock(), seconds, sink = 0.0;
+        int threads = 1;
+        #pragma omp parallel reduction(+:sink)
+        {
+            double x[256], m = 0.999999, d = 1e-6;
+            int r, k;
+            for (k = 0; k < length; k++) x[k] = k;
+            for (r = 0; r < rounds; r++) {
+                #pragma omp simd
+                for (k = 0; k < length; k++) x[k] = x[k] * m + d;
+            }
+            for (k = 0; k < length; k++) sink += x[k];
+            #pragma omp master
+            {
+#ifdef _OPENMP
+                threads = omp_get_num_threads();
+#endif
+            }
+        }
+        seconds = laplace_perf_clock() - start;
+        keep = sink;
+        if (2.0 * length * rounds * threads / seconds / 1e9 > best)
+            best = 2.0 * length * rounds * threads / seconds / 1e9;
+    }
+    (void)keep;
+    return best;
+}
+
+
+// open the counters and measure the roofs; stream_mb 0 sizes the probe
+static inline void laplace_perf_open(laplace_perf *p, double stream_mb) {
+    static const uint32_t types[LAPLACE_PERF_EVENTS] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE };
+    static const uint64_t configs[LAPLACE_PERF_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES };
+    int t, e, opened = 0, why = 0;
+
+    memset(p, 0, sizeof(*p));
+    p->threads = 1;
+#ifdef _OPENMP
+    p->threads = omp_get_max_threads();
+#endif
+    p->fd = malloc(p->threads * sizeof(*p->fd));
+    for (e = 0; e < LAPLACE_PERF_EVENTS; e++) p->available[e] = 1;
+    // pid 0 is the calling thread, so each thread opens its own set
+    #pragma omp parallel num_threads(p->threads) private(e) reduction(max:why)
+    {
+        int me = 0;
+#ifdef _OPENMP
+        me = omp_get_thread_num();
+#endif
+        for (e = 0; e < LAPLACE_PERF_EVENTS; e++) {
+            p->fd[me][e] = laplace_perf_event(types[e], configs[e]);
+            if (p->fd[me][e] < 0) why = errno;
+        }
+    }
+    // a counter is only usable if every thread has it
+    for (t = 0; t < p->threads; t++)
+        for (e = 0; e < LAPLACE_PERF_EVENTS; e++)
+            if (p->fd[t][e] < 0) p->available[e] = 0;
+    for (e = 0; e < LAPLACE_PERF_EVENTS; e++) {
+        if (p->available[e]) opened++;
+        else for (t = 0; t < p->threads; t++)
+            if (p->fd[t][e] >= 0) close(p->fd[t][e]);
+    }
+    if (opened == LAPLACE_PERF_EVENTS) {
+        printf("Counters: cycles, instructions, L1D misses, LLC misses in %d threads\n", p->threads);
+    } else {
+        printf("Counters:");
+        for (e = 0; e < LAPLACE_PERF_EVENTS; e++)
+            if (p->available[e]) printf(" %s", laplace_perf_event_names[e]);
+        printf("%s unavailable (%s%s), timing only for the rest\n", opened ? "; others" : " none,",
+               strerror(why), why == EACCES || why == EPERM ? ", see /proc/sys/kernel/perf_event_paranoid" :
+               why == ENOENT || why == EOPNOTSUPP ? ", no hardware PMU exposed here" : "");
+    }
+
+    if (stream_mb <= 0) {
+        double llc = (double)sysconf(_SC_LEVEL3_CACHE_SIZE);
+        double ram = (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+        stream_mb = (llc > 0 ? 4.0 * llc : 256e6) / 1e6;
+        if (ram > 0 && stream_mb > ram / 16 / 1e6) stream_mb = ram / 16 / 1e6;
+        if (stream_mb < 64) stream_mb = 64;
+    }
+    p->stream_mb = stream_mb;
+    p->stream_gbs = laplace_perf_stream(stream_mb);
+    p->peak_gflops = laplace_perf_peak();
+    printf("Roofline: STREAM triad %.2f GB/s (3 x %.0f MB), peak %.2f GFLOP/s (multiply-add probe), "
+           "%d threads, ridge %.2f flop/byte\n", p->stream_gbs, stream_mb, p->peak_gflops, p->threads,
+           p->peak_gflops / p->stream_gbs);
+}
+
+
+// a kernel phase with its model cost per cell update; returns its index.
+// At most LAPLACE_PERF_KERNELS phases; one more is a bug in the solver
+static inline int laplace_perf_kernel_add(laplace_perf *p, const char *name,
+                                          double flops_per_cell, double bytes_per_cell) {
+    if (p->kernels >= LAPLACE_PERF_KERNELS) {
+        fprintf(stderr, "Roofline: cannot add kernel '%s', already %d (LAPLACE_PERF_KERNELS)\n",
+                name, LAPLACE_PERF_KERNELS);
+        exit(1);
+    }
+    laplace_perf_kernel *k = &p->kernel[p->kernels];
+    k->name = name;
+    k->flops_per_cell = flops_per_cell;
+    k->bytes_per_cell = bytes_per_cell;
+    return p->kernels++;
+}
+
+static inline void laplace_perf_begin(laplace_perf *p, int kernel) {
+    laplace_perf_kernel *k = &p->kernel[kernel];
+    laplace_perf_read(p, k->start);
+    k->start_time = laplace_perf_clock();
+}
+
+static inline void laplace_perf_end(laplace_perf *p, int kernel, double cells) {
+    laplace_perf_kernel *k = &p->kernel[kernel];
+    uint64_t now[LAPLACE_PERF_EVENTS];
+    int e;
+
+    k->seconds += laplace_perf_clock() - k->start_time;
+    laplace_perf_read(p, now);
+    for (e = 0; e < LAPLACE_PERF_EVENTS; e++) k->count[e] += now[e] - k->start[e];
+    k->cells += cells;
+}
+
+
+static inline void laplace_perf_report(laplace_perf *p) {
+    int i, t, e;
+
+    printf("%-12s %9s %8s %8s %7s %7s %6s %10s %10s %9s\n", "kernel", "seconds", "GB/s", "GFLOP/s",
+           "AI", "roof%", "IPC", "L1D/cell", "LLC/cell", "LLC_GB/s");
+    for (i = 0; i < p->kernels; i++) {
+        laplace_perf_kernel *k = &p->kernel[i];
+        double gbs = k->cells * k->bytes_per_cell / k->seconds / 1e9;
+        double gflops = k->cells * k->flops_per_cell / k->seconds / 1e9;
+        double ai = k->flops_per_cell / k->bytes_per_cell;
+        double roof = ai * p->stream_gbs < p->peak_gflops ? ai * p->stream_gbs : p->peak_gflops;
+
+        if (k->seconds <= 0) continue;
+        printf("%-12s %9.4f %8.2f %8.2f %7.3f %6.1f%%", k->name, k->seconds, gbs, gflops, ai,
+               100.0 * gflops / roof);
+        if (p->available[LAPLACE_PERF_CYCLES] && p->available[LAPLACE_PERF_INSTRUCTIONS] && k->count[LAPLACE_PERF_CYCLES])
+            printf(" %6.2f", (double)k->count[LAPLACE_PERF_INSTRUCTIONS] / k->count[LAPLACE_PERF_CYCLES]);
+        else
+            printf(" %6s", "-");
+        if (p->available[LAPLACE_PERF_L1D_MISSES])
+            printf(" %10.4f", k->count[LAPLACE_PERF_L1D_MISSES] / k->cells);
+        else
+            printf(" %10s", "-");
+        if (p->available[LAPLACE_PERF_LLC_MISSES])
+            printf(" %10.4f %9.2f\n", k->count[LAPLACE_PERF_LLC_MISSES] / k->cells,
+                   k->count[LAPLACE_PERF_LLC_MISSES] * (double)LAPLACE_PERF_LINE / k->seconds / 1e9);
+        else
+            printf(" %10s %9s\n", "-", "-");
+    }
+    for (e = 0; e < LAPLACE_PERF_EVENTS; e++)
+        if (p->available[e]) for (t = 0; t < p->threads; t++) close(p->fd[t][e]);
+    free(p->fd);
+}
+
+#endif
@@ -0,0 +1,255 @@
+/*************************************************
+ * Asynchronous snapshots of the Laplace plate
+ *
+ * The solver copies its grid into one of LAPLACE_SNAPSHOT_SLOTS
+ * buffers and carries on; a writer thread encodes the buffer and
+ * appends it to the snapshot file. Buffers pass through a lock-free
+ * single-producer / single-consumer ring:
+ *
+ *   head   next buffer the solver fills, only the solver stores it
+ *   tail   next buffer the writer drains, only the writer stores it
+ *
+ * head - tail buffers are waiting. When the writer has fallen behind and
+ * every buffer is waiting, laplace_snapshot_slot returns NULL and the
+ * snapshot is dropped, so the sweep never waits on the disk. Extra
+ * memory is LAPLACE_SNAPSHOT_SLOTS grids (and one codec buffer for the
+ * xor encoding), whatever the snapshot rate.
+ * The writer sleeps on a semaphore; sem_post never blocks the solver.
+ * A frame whose fwrite or fflush fails (a full disk, say) counts as
+ * failed, not written; the file then ends in a partial frame, so the
+ * writer drains the remaining buffers as failed too.
+ *
+ * The file is a sequence of frames, each a LAPLACE_SNAPSHOT_HEADER-byte
+ * laplace_snapshot_header followed by `payload` bytes. The raw
+ * encoding keeps only the ROWS x COLUMNS interior, in row order; the
+ * xor encoding is that interior through the lossless codec of
+ * common/laplace_codec.h, run on the writer thread.
+ *
+ * Link with -pthread.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_SNAPSHOT_H
+#define LAPLACE_SNAPSHOT_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include "laplace_codec.h"
+
+#define LAPLACE_SNAPSHOT_SLOTS   2            // grid copies in flight (double buffering)
+#define LAPLACE_SNAPSHOT_MAGIC   "LAPSNAP1"
+#define LAPLACE_SNAPSHOT_HEADER  64
+#define LAPLACE_SNAPSHOT_RAW     0            // interior doubles in row order
+#define LAPLACE_SNAPSHOT_XOR     1            // laplace_codec_encode stream of the interior
+
+typedef struct {
+    char    magic[8];
+    int64_t rows;
+    int64_t columns;
+    int64_t iteration;
+    double  dt;
+    int64_t encoding;       // LAPLACE_SNAPSHOT_RAW or _XOR
+    int64_t payload;        // bytes that follow the header
+    char    pad[LAPLACE_SNAPSHOT_HEADER - 8 - 6*8];
+} laplace_snapshot_header;
+
+typedef struct {
+    int64_t rows, columns;              // interior cells
+    const char *path;
+    FILE *file;
+    int encoding;
+    unsigned char *stream;              // codec output, writer only
+    double *slot[LAPLACE_SNAPSHOT_SLOTS];   // (rows+2) x (columns+2) grid copies
+    int64_t slot_iteration[LAPLACE_SNAPSHOT_SLOTS];
+    double slot_dt[LAPLACE_SNAPSHOT_SLOTS];
+    _Atomic uint64_t head;
+    _Atomic uint64_t tail;
+    _Atomic int done;                   // no more pushes; drain and exit
+    sem_t ready;                        // one post per push, one for done
+    pthread_t writer;
+
+    int taken, dropped;                 // solver side
+    int written, failed;                // writer side, read after the join
+    int error;                          // errno of the first failed write, 0 = none
+    double bytes, raw_bytes, write_seconds;
+} laplace_snapshot;
+
+
+static inline double laplace_snapshot_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+// 0 once the frame is in the file, -1 if a write failed
+static inline int laplace_snapshot_encode(laplace_snapshot *q, int s) {
+
+    const double *grid = q->slot[s];
+    laplace_snapshot_header header;
+    int64_t i;
+    int ok;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LAPLACE_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.rows = q->rows;
+    header.columns = q->columns;
+    header.iteration = q->slot_iteration[s];
+    header.dt = q->slot_dt[s];
+    header.encoding = q->encoding;
+
+    if (q->encoding == LAPLACE_SNAPSHOT_XOR) {
+        // one thread: the solver's threads keep the cores
+        header.payload = laplace_codec_encode(grid + (q->columns + 2) + 1, q->columns + 2,
+                                              q->rows, q->columns, q->stream, 0);
+        ok = fwrite(&header, sizeof(header), 1, q->file) == 1 &&
+             fwrite(q->stream, 1, header.payload, q->file) == (size_t)header.payload;
+    } else {
+        header.payload = q->rows * q->columns * (int64_t)sizeof(double);
+        ok = fwrite(&header, sizeof(header), 1, q->file) == 1;
+        for (i = 1; ok && i <= q->rows; i++) {
+            ok = fwrite(grid + i * (q->columns + 2) + 1, sizeof(double), q->columns, q->file) ==
+                 (size_t)q->columns;
+        }
+    }
+    if (ok) ok = fflush(q->file) == 0;
+    if (!ok) {
+        q->error = errno ? errno : EIO;
+        return -1;
+    }
+    q->bytes += sizeof(header) + header.payload;
+    q->raw_bytes += sizeof(header) + q->rows * q->columns * (double)sizeof(double);
+    return 0;
+}
+
+
+static inline void *laplace_snapshot_writer(void *arg) {
+
+    laplace_snapshot *q = arg;
+
+    for (;;) {
+        sem_wait(&q->ready);
+        uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&q->head, memory_order_acquire)) {
+            if (atomic_load_explicit(&q->done, memory_order_acquire)) break;
+            continue;
+        }
+        double start = laplace_snapshot_clock();
+        if (!q->error && laplace_snapshot_encode(q, (int)(tail % LAPLACE_SNAPSHOT_SLOTS)) == 0) {
+            q->write_seconds += laplace_snapshot_clock() - start;
+            q->written++;
+        } else {
+            q->failed++;
+        }
+        atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    }
+    return NULL;
+}
+
+
+static inline void laplace_snapshot_open(laplace_snapshot *q, const char *path,
+                                         int64_t rows, int64_t columns, int encoding) {
+    int s;
+
+    memset(q, 0, sizeof(*q));
+    q->rows = rows;
+    q->columns = columns;
+    q->path = path;
+    q->encoding = encoding;
+    if (encoding == LAPLACE_SNAPSHOT_XOR) {
+        q->stream = malloc(laplace_codec_bound(rows, columns));
+        if (!q->stream) {
+            fprintf(stderr, "Snapshots: cannot allocate the codec buffer\n");
+            exit(1);
+        }
+    }
+    q->file = fopen(path, "wb");
+    if (!q->file) {
+        perror(path);
+        exit(1);
+    }
+    setvbuf(q->file, NULL, _IOFBF, 1 << 20);
+    for (s = 0; s < LAPLACE_SNAPSHOT_SLOTS; s++) {
+        q->slot[s] = malloc((size_t)(rows + 2) * (size_t)(columns + 2) * sizeof(double));
+        if (!q->slot[s]) {
+            fprintf(stderr, "Snapshots: cannot allocate a %lld x %lld buffer\n",
+                    (long long)rows + 2, (long long)columns + 2);
+            exit(1);
+        }
+    }
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->done, 0);
+    sem_init(&q->ready, 0, 0);
+    pthread_create(&q->writer, NULL, laplace_snapshot_writer, q);
+}
+
+
+// a free buffer to copy the grid into, or NULL when all are still being
+// written (the snapshot is dropped); with wait, yield until one frees up
+static inline double *laplace_snapshot_slot(laplace_snapshot *q, int wait) {
+
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    q->taken++;
+    while (head - atomic_load_explicit(&q->tail, memory_order_acquire) == LAPLACE_SNAPSHOT_SLOTS) {
+        if (!wait) {
+            q->dropped++;
+            return NULL;
+        }
+        sched_yield();
+    }
+    return q->slot[head % LAPLACE_SNAPSHOT_SLOTS];
+}
+
+
+// hand the buffer from laplace_snapshot_slot to the writer
+static inline void laplace_snapshot_push(laplace_snapshot *q, int64_t iteration, double dt) {
+
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    int s = (int)(head % LAPLACE_SNAPSHOT_SLOTS);
+
+    q->slot_iteration[s] = iteration;
+    q->slot_dt[s] = dt;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    sem_post(&q->ready);
+}
+
+
+// drain the ring, stop the writer and print what it did
+static inline void laplace_snapshot_close(laplace_snapshot *q) {
+    int s;
+
+    atomic_store_explicit(&q->done, 1, memory_order_release);
+    sem_post(&q->ready);
+    pthread_join(q->writer, NULL);
+    if (fclose(q->file) != 0 && !q->error) q->error = errno ? errno : EIO;
+    sem_destroy(&q->ready);
+
+    printf("Snapshots: %d written to %s, %d dropped (writer busy), %.1f MB, writer %.2f GB/s, "
+           "%.1f MB of buffers\n", q->written, q->path, q->dropped, q->bytes / 1e6,
+           q->write_seconds > 0 ? q->raw_bytes / q->write_seconds / 1e9 : 0.0,
+           (LAPLACE_SNAPSHOT_SLOTS * (double)(q->rows + 2) * (q->columns + 2) * sizeof(double) +
+            (q->stream ? laplace_codec_bound(q->rows, q->columns) : 0)) / 1e6);
+    if (q->error)
+        printf("Snapshots: %d failed, %s: %s\n", q->failed, q->path, strerror(q->error));
+    if (q->encoding == LAPLACE_SNAPSHOT_XOR && q->bytes > 0)
+        printf("Snapshot codec: xor, ratio %.2f\n", q->raw_bytes / q->bytes);
+
+    // after the report, which sizes the stream buffer only if there is one
+    for (s = 0; s < LAPLACE_SNAPSHOT_SLOTS; s++) free(q->slot[s]);
+    free(q->stream);
+    q->stream = NULL;
+}
+
+#endif
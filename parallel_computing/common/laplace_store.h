@@ -0,0 +1,268 @@
+/*************************************************
+ * Tiled solution store for the Laplace plate
+ *
+ * A finished plate is written once and then queried many times, mostly
+ * for small windows (the hot corner track_progress prints, a row, a
+ * point). The store cuts the ROWS x COLUMNS interior into fixed
+ * LAPLACE_TILE_ROWS x LAPLACE_TILE_COLUMNS tiles and is read through
+ * mmap, so a query only faults in the pages of the tiles it touches:
+ *
+ *   page 0        laplace_store_header
+ *   index         one laplace_tile_stats {min, max} per tile, so a
+ *                 value search (laplace_store_count_range) can skip
+ *                 tiles without touching them
+ *   tiles         row-major tiles, row-major cells inside a tile;
+ *                 edge tiles are padded to full size
+ *
+ * The index and each tile start on a page boundary. A 64 x 64 tile of
+ * doubles is 32 KB, eight pages of eight tile rows each, so a point
+ * query reads one page of cells.
+ *
+ * Cells are addressed like track_progress: rows 1..ROWS, columns
+ * 1..COLUMNS.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_STORE_H
+#define LAPLACE_STORE_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define LAPLACE_TILE_ROWS     64
+#define LAPLACE_TILE_COLUMNS  64
+#define LAPLACE_STORE_MAGIC   "LAPTILE1"
+#define LAPLACE_STORE_PAGE    4096
+
+typedef struct {
+    char    magic[8];
+    int64_t rows, columns;              // interior cells
+    int64_t tile_rows, tile_columns;
+    int64_t tiles_down, tiles_across;
+    int64_t iteration;                  // solver state when written
+    double  dt;
+    int64_t index_offset;               // byte offsets in the file
+    int64_t tile_offset;
+    int64_t tile_bytes;
+} laplace_store_header;
+
+typedef struct {
+    double min, max;
+} laplace_tile_stats;
+
+typedef struct {
+    laplace_store_header header;
+    const unsigned char *map;           // the whole file, read-only
+    size_t map_bytes;
+    const laplace_tile_stats *index;
+} laplace_store;
+
+
+static inline int64_t laplace_store_round(int64_t bytes) {
+    return (bytes + LAPLACE_STORE_PAGE - 1) / LAPLACE_STORE_PAGE * LAPLACE_STORE_PAGE;
+}
+
+
+// write the rows x columns interior of a grid (first interior cell and
+// row stride in doubles); returns 0, or -1 with errno set
+static inline int laplace_store_write(const char *path, const double *grid, int64_t stride,
+                                      int64_t rows, int64_t columns, int64_t iteration, double dt) {
+    laplace_store_header header;
+    laplace_tile_stats *index;
+    double *band;
+    int64_t tr, tc, i, j, band_cells;
+    size_t index_bytes;
+    int fd, rc = 0;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LAPLACE_STORE_MAGIC, sizeof(header.magic));
+    header.rows = rows;
+    header.columns = columns;
+    header.tile_rows = LAPLACE_TILE_ROWS;
+    header.tile_columns = LAPLACE_TILE_COLUMNS;
+    header.tiles_down = (rows + LAPLACE_TILE_ROWS - 1) / LAPLACE_TILE_ROWS;
+    header.tiles_across = (columns + LAPLACE_TILE_COLUMNS - 1) / LAPLACE_TILE_COLUMNS;
+    header.iteration = iteration;
+    header.dt = dt;
+    header.tile_bytes = LAPLACE_TILE_ROWS * LAPLACE_TILE_COLUMNS * (int64_t)sizeof(double);
+    index_bytes = header.tiles_down * header.tiles_across * sizeof(laplace_tile_stats);
+    header.index_offset = LAPLACE_STORE_PAGE;
+    header.tile_offset = header.index_offset + laplace_store_round(index_bytes);
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+
+    // one band of tiles at a time: gather, then one write of the band
+    band_cells = header.tiles_across * LAPLACE_TILE_ROWS * LAPLACE_TILE_COLUMNS;
+    band = malloc(band_cells * sizeof(double));
+    index = malloc(index_bytes);
+    if (!band || !index) {
+        close(fd);
+        free(band);
+        free(index);
+        return -1;
+    }
+    for (tr = 0; tr < header.tiles_down && rc == 0; tr++) {
+        memset(band, 0, band_cells * sizeof(double));
+        for (tc = 0; tc < header.tiles_across; tc++) {
+            double *tile = band + tc * LAPLACE_TILE_ROWS * LAPLACE_TILE_COLUMNS;
+            laplace_tile_stats *stats = &index[tr * header.tiles_across + tc];
+            int64_t r0 = tr * LAPLACE_TILE_ROWS, c0 = tc * LAPLACE_TILE_COLUMNS;
+            int64_t nr = (rows - r0 < LAPLACE_TILE_ROWS) ? rows - r0 : LAPLACE_TILE_ROWS;
+            int64_t nc = (columns - c0 < LAPLACE_TILE_COLUMNS) ? columns - c0 : LAPLACE_TILE_COLUMNS;
+            stats->min = stats->max = grid[r0 * stride + c0];
+            for (i = 0; i < nr; i++) {
+                const double *src = grid + (r0 + i) * stride + c0;
+                memcpy(tile + i * LAPLACE_TILE_COLUMNS, src, nc * sizeof(double));
+                for (j = 0; j < nc; j++) {
+                    if (src[j] < stats->min) stats->min = src[j];
+                    if (src[j] > stats->max) stats->max = src[j];
+                }
+            }
+        }
+        if (pwrite(fd, band, band_cells * sizeof(double),
+                   header.tile_offset + tr * band_cells * (int64_t)sizeof(double))
+            != (ssize_t)(band_cells * sizeof(double))) rc = -1;
+    }
+    if (rc == 0 && pwrite(fd, index, index_bytes, header.index_offset) != (ssize_t)index_bytes) rc = -1;
+    if (rc == 0 && pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) rc = -1;
+    free(band);
+    free(index);
+    if (close(fd) != 0) rc = -1;
+    return rc;
+}
+
+
+// map a store read-only; returns 0, or -1 if it cannot be read or is
+// not a store
+static inline int laplace_store_open(laplace_store *s, const char *path) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    memset(s, 0, sizeof(*s));
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)LAPLACE_STORE_PAGE) {
+        close(fd);
+        return -1;
+    }
+    s->map_bytes = st.st_size;
+    s->map = mmap(NULL, s->map_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (s->map == MAP_FAILED) {
+        s->map = NULL;
+        return -1;
+    }
+    // queries jump around: no readahead beyond the page asked for
+    madvise((void *)s->map, s->map_bytes, MADV_RANDOM);
+
+    memcpy(&s->header, s->map, sizeof(s->header));
+    if (memcmp(s->header.magic, LAPLACE_STORE_MAGIC, sizeof(s->header.magic)) != 0 ||
+        (size_t)(s->header.tile_offset + s->header.tiles_down * s->header.tiles_across *
+                 s->header.tile_bytes) > s->map_bytes) {
+        munmap((void *)s->map, s->map_bytes);
+        s->map = NULL;
+        return -1;
+    }
+    s->index = (const laplace_tile_stats *)(s->map + s->header.index_offset);
+    return 0;
+}
+
+
+static inline void laplace_store_close(laplace_store *s) {
+    if (s->map) munmap((void *)s->map, s->map_bytes);
+    s->map = NULL;
+}
+
+
+// the tile holding interior cell (row, column), 0-based, and the cell's place in it
+static inline const double *laplace_store_tile(const laplace_store *s, int64_t row, int64_t column) {
+    int64_t t = (row / LAPLACE_TILE_ROWS) * s->header.tiles_across + column / LAPLACE_TILE_COLUMNS;
+    return (const double *)(s->map + s->header.tile_offset + t * s->header.tile_bytes);
+}
+
+
+static inline double laplace_store_cell(const laplace_store *s, int64_t row, int64_t column) {
+    row--;
+    column--;
+    return laplace_store_tile(s, row, column)[(row % LAPLACE_TILE_ROWS) * LAPLACE_TILE_COLUMNS +
+                                              column % LAPLACE_TILE_COLUMNS];
+}
+
+
+// cells rows row..row+nrows-1, columns column..column+ncolumns-1 into
+// out, row-major; copies tile-row runs, touching each tile once per row
+static inline void laplace_store_rect(const laplace_store *s, int64_t row, int64_t column,
+                                      int64_t nrows, int64_t ncolumns, double *out) {
+    int64_t i, j, run;
+
+    for (i = 0; i < nrows; i++) {
+        int64_t r = row - 1 + i;
+        for (j = 0; j < ncolumns; j += run) {
+            int64_t c = column - 1 + j;
+            run = LAPLACE_TILE_COLUMNS - c % LAPLACE_TILE_COLUMNS;
+            if (run > ncolumns - j) run = ncolumns - j;
+            memcpy(out + i * ncolumns + j,
+                   laplace_store_tile(s, r, c) + (r % LAPLACE_TILE_ROWS) * LAPLACE_TILE_COLUMNS +
+                   c % LAPLACE_TILE_COLUMNS, run * sizeof(double));
+        }
+    }
+}
+
+
+static inline void laplace_store_row(const laplace_store *s, int64_t row, double *out) {
+    laplace_store_rect(s, row, 1, 1, s->header.columns, out);
+}
+
+
+// min and max of the tile holding (row, column), from the index alone
+static inline laplace_tile_stats laplace_store_tile_stats(const laplace_store *s, int64_t row, int64_t column) {
+    return s->index[((row - 1) / LAPLACE_TILE_ROWS) * s->header.tiles_across + (column - 1) / LAPLACE_TILE_COLUMNS];
+}
+
+
+// interior cells with lo <= value <= hi. Tiles whose index range misses
+// [lo, hi] are skipped and tiles inside it are counted whole, both
+// without touching their pages; only tiles straddling a bound are read.
+// tiles_read, if not NULL, gets how many were
+static inline int64_t laplace_store_count_range(const laplace_store *s, double lo, double hi,
+                                                int64_t *tiles_read) {
+    int64_t rows = s->header.rows, columns = s->header.columns;
+    int64_t tr, tc, i, j, count = 0, read = 0;
+
+    for (tr = 0; tr < s->header.tiles_down; tr++) {
+        int64_t r0 = tr * LAPLACE_TILE_ROWS;
+        int64_t nr = (rows - r0 < LAPLACE_TILE_ROWS) ? rows - r0 : LAPLACE_TILE_ROWS;
+        for (tc = 0; tc < s->header.tiles_across; tc++) {
+            int64_t c0 = tc * LAPLACE_TILE_COLUMNS;
+            int64_t nc = (columns - c0 < LAPLACE_TILE_COLUMNS) ? columns - c0 : LAPLACE_TILE_COLUMNS;
+            laplace_tile_stats stats = s->index[tr * s->header.tiles_across + tc];
+            const double *tile;
+
+            if (stats.max < lo || stats.min > hi) continue;
+            if (stats.min >= lo && stats.max <= hi) {
+                count += nr * nc;
+                continue;
+            }
+            tile = laplace_store_tile(s, r0, c0);
+            for (i = 0; i < nr; i++) {
+                for (j = 0; j < nc; j++) {
+                    double v = tile[i * LAPLACE_TILE_COLUMNS + j];
+                    count += (v >= lo && v <= hi);
+                }
+            }
+            read++;
+        }
+    }
+    if (tiles_read) *tiles_read = read;
+    return count;
+}
+
+#endif
@@ -0,0 +1,330 @@
+/*************************************************
+ * Non-blocking telemetry for the iteration loop
+ *
+ *   --telemetry=stdout          the usual progress lines, printed by a
+ *                               sink thread instead of the solver
+ *   --telemetry=FILE            one CSV row per record
+ *   --telemetry=prom:FILE       Prometheus text format, the latest
+ *                               record rewritten every second (for
+ *                               node_exporter's textfile collector or
+ *                               a `watch cat`)
+ *   [--telemetry-every=N]       records every N iterations (100)
+ *
+ * A printf from inside the loop takes the stdout lock and, under MPI,
+ * waits on the launcher forwarding the line; with many PEs writing at
+ * once that shows up as spikes in the iteration time. Instead the
+ * solver fills a fixed-size laplace_telemetry_record (iteration, dt,
+ * corner samples, phase times) and pushes it into its thread's
+ * lock-free single-producer / single-consumer ring:
+ *
+ *   head   next record the thread writes, only the thread stores it
+ *   tail   next record the sink reads, only the sink stores it
+ *
+ * A full ring drops the record and counts it: the solver never waits
+ * on the sink, and a push is a copy and one release store, no system
+ * call. The sink thread polls the rings every
+ * LAPLACE_TELEMETRY_POLL_MS, writes what it finds and sleeps again.
+ *
+ * Under MPI every PE runs its own sink; FILE and prom:FILE become
+ * FILE.<rank>. On stdout only records with samples or a dt line are
+ * printed, so the output reads as before.
+ *
+ * Link with -pthread.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_TELEMETRY_H
+#define LAPLACE_TELEMETRY_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "bench_phases.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define LAPLACE_TELEMETRY_RING     64     // records in flight per thread
+#define LAPLACE_TELEMETRY_SAMPLES  6      // the track_progress diagonal
+#define LAPLACE_TELEMETRY_POLL_MS  20
+#define LAPLACE_TELEMETRY_PROM_SECONDS 1.0
+
+#define LAPLACE_TELEMETRY_STDOUT   0
+#define LAPLACE_TELEMETRY_CSV      1
+#define LAPLACE_TELEMETRY_PROM     2
+
+// what a record carries, for the stdout sink
+#define LAPLACE_TELEMETRY_HAS_SAMPLES  1  // "---- Iteration number" block
+#define LAPLACE_TELEMETRY_HAS_DT       2  // "Iteration N: dt_global = X"
+
+typedef struct {
+    int32_t flags;
+    int32_t samples;                      // cells used in sample[]
+    int64_t iteration;
+    double time;                          // seconds since laplace_telemetry_open
+    double dt;
+    double phase[BENCH_PHASES];           // seconds so far per phase, as bench_phases
+    int64_t sample_row, sample_column;    // global cell of sample[0]; sample[k] is
+    double sample[LAPLACE_TELEMETRY_SAMPLES];   // (row + k, column + k)
+} laplace_telemetry_record;
+
+// one per pushing thread; head and tail a cache line apart
+typedef struct {
+    laplace_telemetry_record record[LAPLACE_TELEMETRY_RING];
+    _Atomic uint64_t head;
+    int64_t pushed;                       // thread side
+    _Atomic int64_t dropped;              // thread side, read live by the prom sink
+    char pad1[64 - sizeof(uint64_t) - 2 * sizeof(int64_t)];
+    _Atomic uint64_t tail;
+    char pad2[64 - sizeof(uint64_t)];
+} laplace_telemetry_ring;
+
+typedef struct {
+    int enabled;
+    int sink;                             // LAPLACE_TELEMETRY_STDOUT, _CSV or _PROM
+    int rank, threads;
+    char path[4096];
+    FILE *file;                           // CSV sink
+    double origin;
+    laplace_telemetry_ring *ring;
+    _Atomic int done;                     // no more pushes; drain and exit
+    pthread_t thread;
+
+    laplace_telemetry_record latest;      // sink side, for the prom file
+    int64_t written;                      // sink side, read after the join
+    double prom_written;                  // when the prom file was last rewritten
+} laplace_telemetry;
+
+static const char *laplace_telemetry_phases[BENCH_PHASES] = {
+    "init", "compute", "halo", "reduction", "output"
+};
+
+
+static inline double laplace_telemetry_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static inline void laplace_telemetry_emit(laplace_telemetry *t, const laplace_telemetry_record *r) {
+    int k;
+
+    t->written++;
+    if (t->sink == LAPLACE_TELEMETRY_STDOUT) {
+        if (r->flags & LAPLACE_TELEMETRY_HAS_SAMPLES) {
+            printf("---------- Iteration number: %" PRId64 " ------------\n", r->iteration);
+            for (k = 0; k < r->samples; k++) {
+                printf("[%" PRId64 ",%" PRId64 "]: %5.2f  ", r->sample_row + k, r->sample_column + k, r->sample[k]);
+            }
+            printf("\n");
+        }
+        if (r->flags & LAPLACE_TELEMETRY_HAS_DT) {
+            printf("Iteration %" PRId64 ": dt_global = %f\n", r->iteration, r->dt);
+        }
+    } else if (t->sink == LAPLACE_TELEMETRY_CSV) {
+        fprintf(t->file, "%d,%" PRId64 ",%.6f,%.9g", t->rank, r->iteration, r->time, r->dt);
+        for (k = 0; k < BENCH_PHASES; k++) fprintf(t->file, ",%.6f", r->phase[k]);
+        for (k = 0; k < LAPLACE_TELEMETRY_SAMPLES; k++) {
+            if (k < r->samples) fprintf(t->file, ",%.6f", r->sample[k]);
+            else fprintf(t->file, ",");
+        }
+        fprintf(t->file, "\n");
+    } else {
+        t->latest = *r;
+    }
+}
+
+
+// the latest record as gauges, written beside the file and renamed over
+// it so a scraper never reads half a file
+static inline void laplace_telemetry_prom(laplace_telemetry *t) {
+    const laplace_telemetry_record *r = &t->latest;
+    char tmp[4200];
+    int64_t dropped = 0;
+    FILE *f;
+    int k;
+
+    for (k = 0; k < t->threads; k++)
+        dropped += atomic_load_explicit(&t->ring[k].dropped, memory_order_relaxed);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", t->path);
+    f = fopen(tmp, "w");
+    if (!f) return;
+    fprintf(f, "# HELP laplace_iteration Last iteration reported.\n# TYPE laplace_iteration gauge\n");
+    fprintf(f, "laplace_iteration{rank=\"%d\"} %" PRId64 "\n", t->rank, r->iteration);
+    fprintf(f, "# HELP laplace_dt Largest temperature change at that iteration.\n# TYPE laplace_dt gauge\n");
+    fprintf(f, "laplace_dt{rank=\"%d\"} %.9g\n", t->rank, r->dt);
+    fprintf(f, "# HELP laplace_phase_seconds Seconds spent per solver phase so far.\n"
+               "# TYPE laplace_phase_seconds counter\n");
+    for (k = 0; k < BENCH_PHASES; k++) {
+        fprintf(f, "laplace_phase_seconds{rank=\"%d\",phase=\"%s\"} %.6f\n", t->rank,
+                laplace_telemetry_phases[k], r->phase[k]);
+    }
+    fprintf(f, "# HELP laplace_sample Temperature at a tracked cell.\n# TYPE laplace_sample gauge\n");
+    for (k = 0; k < r->samples; k++) {
+        fprintf(f, "laplace_sample{rank=\"%d\",row=\"%" PRId64 "\",column=\"%" PRId64 "\"} %.6f\n",
+                t->rank, r->sample_row + k, r->sample_column + k, r->sample[k]);
+    }
+    fprintf(f, "# HELP laplace_telemetry_records_total Records written by the sink.\n"
+               "# TYPE laplace_telemetry_records_total counter\n");
+    fprintf(f, "laplace_telemetry_records_total{rank=\"%d\"} %" PRId64 "\n", t->rank, t->written);
+    fprintf(f, "# HELP laplace_telemetry_dropped_total Records dropped on a full ring.\n"
+               "# TYPE laplace_telemetry_dropped_total counter\n");
+    fprintf(f, "laplace_telemetry_dropped_total{rank=\"%d\"} %" PRId64 "\n", t->rank, dropped);
+    fclose(f);
+    rename(tmp, t->path);
+}
+
+
+static inline void *laplace_telemetry_sink(void *arg) {
+
+    laplace_telemetry *t = arg;
+    struct timespec poll = {0, LAPLACE_TELEMETRY_POLL_MS * 1000000L};
+
+    for (;;) {
+        // read done first: everything pushed before it is drained below
+        int done = atomic_load_explicit(&t->done, memory_order_acquire);
+        int64_t before = t->written;
+        int k;
+
+        for (k = 0; k < t->threads; k++) {
+            laplace_telemetry_ring *q = &t->ring[k];
+            uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+            uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+            for (; tail != head; tail++) {
+                laplace_telemetry_emit(t, &q->record[tail % LAPLACE_TELEMETRY_RING]);
+            }
+            atomic_store_explicit(&q->tail, tail, memory_order_release);
+        }
+        if (t->written != before) {
+            if (t->sink == LAPLACE_TELEMETRY_STDOUT) fflush(stdout);
+            if (t->sink == LAPLACE_TELEMETRY_CSV) fflush(t->file);
+        }
+        if (t->sink == LAPLACE_TELEMETRY_PROM && t->written > 0 &&
+            (done || laplace_telemetry_clock() - t->prom_written >= LAPLACE_TELEMETRY_PROM_SECONDS)) {
+            laplace_telemetry_prom(t);
+            t->prom_written = laplace_telemetry_clock();
+        }
+        if (done) break;
+        nanosleep(&poll, NULL);
+    }
+    return NULL;
+}
+
+
+// spec is stdout, FILE or prom:FILE (NULL = off); threads is how many
+// threads push. Call before the loop, outside parallel regions
+static inline void laplace_telemetry_open(laplace_telemetry *t, const char *spec, int rank, int ranks,
+                                          int threads) {
+    const char *file = spec;
+
+    memset(t, 0, sizeof(*t));
+    if (!spec) return;
+    t->enabled = 1;
+    t->rank = rank;
+    t->threads = threads > 0 ? threads : 1;
+    if (strcmp(spec, "stdout") == 0) {
+        t->sink = LAPLACE_TELEMETRY_STDOUT;
+    } else if (strncmp(spec, "prom:", 5) == 0) {
+        t->sink = LAPLACE_TELEMETRY_PROM;
+        file = spec + 5;
+    } else {
+        t->sink = LAPLACE_TELEMETRY_CSV;
+    }
+    if (t->sink != LAPLACE_TELEMETRY_STDOUT) {
+        if (ranks > 1) snprintf(t->path, sizeof(t->path), "%s.%d", file, rank);
+        else snprintf(t->path, sizeof(t->path), "%s", file);
+    }
+    if (t->sink == LAPLACE_TELEMETRY_CSV) {
+        int k;
+        t->file = fopen(t->path, "w");
+        if (!t->file) {
+            perror(t->path);
+            exit(1);
+        }
+        fprintf(t->file, "rank,iteration,seconds,dt");
+        for (k = 0; k < BENCH_PHASES; k++) fprintf(t->file, ",%s", laplace_telemetry_phases[k]);
+        for (k = 0; k < LAPLACE_TELEMETRY_SAMPLES; k++) fprintf(t->file, ",sample%d", k);
+        fprintf(t->file, "\n");
+    }
+
+    t->ring = aligned_alloc(64, t->threads * sizeof(laplace_telemetry_ring));
+    if (!t->ring) {
+        fprintf(stderr, "Telemetry: cannot allocate %d rings\n", t->threads);
+        exit(1);
+    }
+    memset(t->ring, 0, t->threads * sizeof(laplace_telemetry_ring));
+    for (int k = 0; k < t->threads; k++) {
+        atomic_init(&t->ring[k].head, 0);
+        atomic_init(&t->ring[k].tail, 0);
+        atomic_init(&t->ring[k].dropped, 0);
+    }
+    atomic_init(&t->done, 0);
+    t->origin = laplace_telemetry_clock();
+    pthread_create(&t->thread, NULL, laplace_telemetry_sink, t);
+}
+
+
+// a record for iteration with dt and, if phases is set, bench_phases seconds
+static inline void laplace_telemetry_record_init(const laplace_telemetry *t, laplace_telemetry_record *r,
+                                                 int iteration, double dt, const double *phases) {
+    memset(r, 0, sizeof(*r));
+    r->iteration = iteration;
+    r->time = laplace_telemetry_clock() - t->origin;
+    r->dt = dt;
+    if (phases) memcpy(r->phase, phases, sizeof(r->phase));
+}
+
+// copy r into the calling thread's ring, or drop it if the ring is full;
+// returns 0 when dropped
+static inline int laplace_telemetry_push(laplace_telemetry *t, const laplace_telemetry_record *r) {
+    laplace_telemetry_ring *q;
+    uint64_t head;
+    int thread = 0;
+
+    if (!t->enabled) return 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    if (thread >= t->threads) return 0;
+    q = &t->ring[thread];
+    head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&q->tail, memory_order_acquire) == LAPLACE_TELEMETRY_RING) {
+        // single writer, so a relaxed load and store is enough
+        atomic_store_explicit(&q->dropped,
+                              atomic_load_explicit(&q->dropped, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        return 0;
+    }
+    q->record[head % LAPLACE_TELEMETRY_RING] = *r;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    q->pushed++;
+    return 1;
+}
+
+
+// drain what is left, stop the sink and free the rings
+static inline void laplace_telemetry_close(laplace_telemetry *t, int64_t *pushed, int64_t *dropped) {
+    int k;
+
+    *pushed = *dropped = 0;
+    if (!t->enabled) return;
+    atomic_store_explicit(&t->done, 1, memory_order_release);
+    pthread_join(t->thread, NULL);
+    for (k = 0; k < t->threads; k++) {
+        *pushed += t->ring[k].pushed;
+        *dropped += atomic_load_explicit(&t->ring[k].dropped, memory_order_relaxed);
+    }
+    if (t->file) fclose(t->file);
+    free(t->ring);
+    t->enabled = 0;
+}
+
+#endif
@@ -0,0 +1,268 @@
+/*************************************************
+ * Timeline tracing of the solver phases
+ *
+ *   ./laplace_omp.out --trace=run.json [--trace-events=N]
+ *   mpirun -n 4 ./laplace_mpi.out --trace=run.json
+ *
+ * Totals per phase hide the one slow thread, the PE the OS kept
+ * stealing from, and the track_progress() printf every 100 iterations.
+ * With --trace every phase of every iteration becomes one event
+ * {phase, iteration, start, end}, recorded by the thread that ran it
+ * into its own buffer of N events (default LAPLACE_TRACE_EVENTS),
+ * allocated and touched at startup. Recording is two clock reads and
+ * a store, with no locks and no shared cache lines; a full buffer
+ * drops and counts further events.
+ *
+ * At the end the buffers are written as Chrome trace JSON (complete
+ * "X" events, pid = PE, tid = OpenMP thread), which chrome://tracing
+ * and https://ui.perfetto.dev open directly. Under MPI each PE writes
+ * FILE.<rank>, and after a barrier PE 0 merges them into FILE; times
+ * start at a barrier, so PEs line up as far as their clocks agree.
+ *
+ * Phases: sweep, halo post, wait, boundary rows, reduction, output.
+ *
+ *  Hochan Son, UCLA 2025
+ *
+ ************************************************/
+
+#ifndef LAPLACE_TRACE_H
+#define LAPLACE_TRACE_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define LAPLACE_TRACE_EVENTS  262144    // per thread, 24 bytes each
+
+enum { TRACE_SWEEP, TRACE_HALO_POST, TRACE_WAIT, TRACE_BOUNDARY, TRACE_REDUCTION, TRACE_OUTPUT,
+       TRACE_PHASES };
+
+static const char *laplace_trace_names[TRACE_PHASES] = {
+    "sweep", "halo post", "wait", "boundary rows", "reduction", "output"
+};
+
+typedef struct {
+    double start, end;              // seconds since laplace_trace_open
+    int32_t phase, iteration;
+} laplace_trace_event;
+
+// one per thread, a cache line apart
+typedef struct {
+    laplace_trace_event *events;
+    int64_t count, dropped;
+    double mark;                    // end of the last laplace_trace_lap
+    char pad[32];
+} laplace_trace_buffer;
+
+typedef struct {
+    int enabled;
+    int rank, threads;
+    int64_t capacity;
+    double origin;
+    laplace_trace_buffer *buffer;
+} laplace_trace;
+
+
+static inline double laplace_trace_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline int laplace_trace_thread(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+
+// enabled only when path is set; threads is how many record (1 for code
+// that only traces outside parallel regions). Call outside parallel
+// regions, after a barrier under MPI so all PEs start the clock together
+static inline void laplace_trace_open(laplace_trace *t, const char *path, int rank, int threads,
+                                      int64_t capacity) {
+    int thread;
+
+    memset(t, 0, sizeof(*t));
+    if (!path) return;
+    t->enabled = 1;
+    t->rank = rank;
+    t->threads = threads > 0 ? threads : 1;
+    t->capacity = capacity > 0 ? capacity : LAPLACE_TRACE_EVENTS;
+    t->buffer = aligned_alloc(64, t->threads * sizeof(laplace_trace_buffer));
+    if (!t->buffer) {
+        fprintf(stderr, "Trace: cannot allocate %d buffers\n", t->threads);
+        exit(1);
+    }
+    memset(t->buffer, 0, t->threads * sizeof(laplace_trace_buffer));
+    for (thread = 0; thread < t->threads; thread++) {
+        t->buffer[thread].events = malloc(t->capacity * sizeof(laplace_trace_event));
+        if (!t->buffer[thread].events) {
+            fprintf(stderr, "Trace: cannot allocate %" PRId64 " events per thread\n", t->capacity);
+            exit(1);
+        }
+        // fault the pages in now, not in the middle of a sweep
+        memset(t->buffer[thread].events, 0, t->capacity * sizeof(laplace_trace_event));
+    }
+    t->origin = laplace_trace_clock();
+    t->buffer[0].mark = 0.0;
+}
+
+
+// start of a phase; 0 when tracing is off, so the call is nearly free
+static inline double laplace_trace_now(const laplace_trace *t) {
+    return t->enabled ? laplace_trace_clock() - t->origin : 0.0;
+}
+
+// record phase from start to now for the calling thread
+static inline void laplace_trace_add(laplace_trace *t, int phase, double start, int iteration) {
+    laplace_trace_buffer *b;
+    laplace_trace_event *e;
+    int thread;
+
+    if (!t->enabled) return;
+    thread = laplace_trace_thread();
+    if (thread >= t->threads) return;
+    b = &t->buffer[thread];
+    if (b->count == t->capacity) {
+        b->dropped++;
+        return;
+    }
+    e = &b->events[b->count++];
+    e->start = start;
+    e->end = laplace_trace_clock() - t->origin;
+    e->phase = phase;
+    e->iteration = iteration;
+}
+
+// the master thread's phases back to back, like bench_lap: from the last
+// lap (or open) to now
+static inline void laplace_trace_lap(laplace_trace *t, int phase, int iteration) {
+    if (!t->enabled) return;
+    laplace_trace_add(t, phase, t->buffer[0].mark, iteration);
+    t->buffer[0].mark = laplace_trace_clock() - t->origin;
+}
+
+// restart the master timeline without recording, e.g. before the loop
+static inline void laplace_trace_mark(laplace_trace *t) {
+    if (t->enabled) t->buffer[0].mark = laplace_trace_clock() - t->origin;
+}
+
+
+// this PE's metadata and events as JSON array elements, each led by a
+// comma: the file opens with a metadata event so the parts just append
+static inline int64_t laplace_trace_events(const laplace_trace *t, FILE *f) {
+    int64_t total = 0, k;
+    int thread;
+
+    fprintf(f, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"PE %d\"}}",
+            t->rank, t->rank);
+    for (thread = 0; thread < t->threads; thread++) {
+        const laplace_trace_buffer *b = &t->buffer[thread];
+        if (b->count == 0) continue;
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                   "\"args\":{\"name\":\"thread %d\"}}", t->rank, thread, thread);
+        for (k = 0; k < b->count; k++) {
+            const laplace_trace_event *e = &b->events[k];
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                       "\"args\":{\"iteration\":%d}}", laplace_trace_names[e->phase], t->rank, thread,
+                    e->start * 1e6, (e->end - e->start) * 1e6, e->iteration);
+        }
+        total += b->count;
+    }
+    return total;
+}
+
+static inline int64_t laplace_trace_dropped(const laplace_trace *t) {
+    int64_t dropped = 0;
+    int thread;
+    for (thread = 0; thread < t->threads; thread++) dropped += t->buffer[thread].dropped;
+    return dropped;
+}
+
+static inline void laplace_trace_free(laplace_trace *t) {
+    int thread;
+    if (!t->enabled) return;
+    for (thread = 0; thread < t->threads; thread++) free(t->buffer[thread].events);
+    free(t->buffer);
+    t->enabled = 0;
+}
+
+
+// single process: write path and free the buffers
+static inline void laplace_trace_close(laplace_trace *t, const char *path) {
+    FILE *f;
+    int64_t events;
+
+    if (!t->enabled) return;
+    f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+               "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"sort_index\":%d}}",
+            t->rank, t->rank);
+    events = laplace_trace_events(t, f);
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    printf("Trace: %" PRId64 " events (%" PRId64 " dropped) from %d threads to %s\n", events,
+           laplace_trace_dropped(t), t->threads, path);
+    laplace_trace_free(t);
+}
+
+// under MPI, step 1 on every PE: write path.<rank>; returns its events
+static inline int64_t laplace_trace_write_part(laplace_trace *t, const char *path) {
+    char part[4096];
+    FILE *f;
+    int64_t events;
+
+    if (!t->enabled) return 0;
+    snprintf(part, sizeof(part), "%s.%d", path, t->rank);
+    f = fopen(part, "w");
+    if (!f) {
+        perror(part);
+        exit(1);
+    }
+    events = laplace_trace_events(t, f);
+    fclose(f);
+    return events;
+}
+
+// step 2 on PE 0 once every part is written: concatenate them into path
+static inline void laplace_trace_merge(const char *path, int ranks) {
+    char part[4096], chunk[65536];
+    FILE *out = fopen(path, "w"), *in;
+    size_t n;
+    int rank;
+
+    if (!out) {
+        perror(path);
+        exit(1);
+    }
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                 "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":0,\"args\":{\"sort_index\":0}}");
+    for (rank = 0; rank < ranks; rank++) {
+        snprintf(part, sizeof(part), "%s.%d", path, rank);
+        in = fopen(part, "r");
+        if (!in) {
+            perror(part);
+            continue;
+        }
+        while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) fwrite(chunk, 1, n, out);
+        fclose(in);
+        remove(part);
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+}
+
+#endif